@@ -0,0 +1,227 @@
+/** ===========================================================
+ * @file
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Compares the exact and the approximate search of face projections.
+ * @section DESCRIPTION
+ *
+ * Fills a gallery with random clustered projections, as a trained eigenspace produces them, and
+ * measures query time and recall of the approximate (HNSW) search against the exact scan for
+ * several beam widths, of the scan of 8 bit codes for several numbers of re-ranked candidates, and
+ * of the search through the class centroids for several numbers of probed classes.
+ *
+ * Usage: BenchmarkMatchingExample [faces] [dimension] [queries]
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+#include <sys/time.h>
+
+#include "opencv2/core/core.hpp"
+
+// Our library
+#include "ProjectionGallery.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Use namespace libface in the library.
+using namespace libface;
+
+static double seconds(clock_t ticks)
+{
+    return (double)ticks / (double)CLOCKS_PER_SEC;
+}
+
+static double wallSeconds()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    int faces     = argc > 1 ? atoi(argv[1]) : 100000;
+    int dimension = argc > 2 ? atoi(argv[2]) : 64;
+    int queries   = argc > 3 ? atoi(argv[3]) : 1000;
+    int people    = faces / 10 > 0 ? faces / 10 : 1;
+
+    cv::RNG rng(12345);
+
+    // Every person has a centre, faces of the person scatter around it
+    cv::Mat centres(people, dimension, CV_32FC1);
+    rng.fill(centres, cv::RNG::NORMAL, 0.0, 10.0);
+
+    ProjectionGallery exact;
+    exact.reserve(faces);
+
+    cv::Mat face(1, dimension, CV_32FC1);
+    for (int i = 0; i < faces; ++i)
+    {
+        int person = i % people;
+        rng.fill(face, cv::RNG::NORMAL, 0.0, 1.0);
+        face += centres.row(person);
+        exact.add(face, person);
+    }
+
+    cv::Mat queryMat(queries, dimension, CV_32FC1);
+    rng.fill(queryMat, cv::RNG::NORMAL, 0.0, 1.0);
+    for (int i = 0; i < queries; ++i)
+    {
+        cv::Mat row = queryMat.row(i);
+        row += centres.row(rng.uniform(0, people));
+    }
+
+    cout << faces << " faces of " << people << " people, dimension " << dimension << ", " << queries << " queries" << endl;
+
+    vector<int> truth(queries);
+    clock_t start = clock();
+    for (int i = 0; i < queries; ++i)
+    {
+        truth[i] = exact.nearest(queryMat.row(i));
+    }
+    double exactTime = seconds(clock() - start);
+    cout << "exact scan:  " << 1000.0 * exactTime / queries << " ms per query" << endl;
+
+    // clock() adds up the time of all threads, so the wall time of the sharded scan is measured
+    ProjectionGallery serial(exact);
+    MatchingOptions serialOptions;
+    serialOptions.threads = 1;
+    serial.setMatchingOptions(serialOptions);
+
+    double wall = wallSeconds();
+    for (int i = 0; i < queries; ++i)
+        serial.nearest(queryMat.row(i));
+    double serialWall = wallSeconds() - wall;
+
+    wall = wallSeconds();
+    for (int i = 0; i < queries; ++i)
+        exact.nearest(queryMat.row(i));
+    double parallelWall = wallSeconds() - wall;
+
+    cout << "sharded scan: " << 1000.0 * parallelWall / queries << " ms per query on " << ThreadPool::idealThreadCount()
+         << " cores, " << 1000.0 * serialWall / queries << " ms on one" << endl;
+
+    ProjectionGallery approximate(exact);
+    MatchingOptions options;
+    options.approximate = true;
+    approximate.setMatchingOptions(options);
+
+    // The first query builds the index
+    start = clock();
+    approximate.nearest(queryMat.row(0));
+    cout << "index build: " << seconds(clock() - start) << " s (neighbours " << options.neighbours
+         << ", efConstruction " << options.efConstruction << ")" << endl;
+
+    const int beams[] = { 16, 32, 64, 128, 256 };
+    for (unsigned b = 0; b < sizeof(beams) / sizeof(beams[0]); ++b)
+    {
+        options.efSearch = beams[b];
+        approximate.setMatchingOptions(options);
+
+        int found = 0;
+        start = clock();
+        for (int i = 0; i < queries; ++i)
+        {
+            if (approximate.nearest(queryMat.row(i)) == truth[i])
+                ++found;
+        }
+        double time = seconds(clock() - start);
+
+        cout << "efSearch " << beams[b] << ":\t" << 1000.0 * time / queries << " ms per query, recall "
+             << (double)found / queries << ", speedup " << exactTime / time << endl;
+    }
+
+    ProjectionGallery quantized(exact);
+    MatchingOptions quantizedOptions;
+    quantizedOptions.quantized = true;
+
+    // the codes are scanned instead of the float rows, which stay in memory for the re-ranking
+    cout << "quantized scan: reads " << dimension << " bytes per face instead of " << 4 * exact.stride()
+         << ", holds " << 4 * exact.stride() + dimension + 4 << " bytes per face instead of " << 4 * exact.stride() << endl;
+
+    const int reranks[] = { 1, 8, 32, 128 };
+    for (unsigned r = 0; r < sizeof(reranks) / sizeof(reranks[0]); ++r)
+    {
+        quantizedOptions.rerank = reranks[r];
+        quantized.setMatchingOptions(quantizedOptions);
+
+        int found = 0;
+        start = clock();
+        for (int i = 0; i < queries; ++i)
+        {
+            if (quantized.nearest(queryMat.row(i)) == truth[i])
+                ++found;
+        }
+        double time = seconds(clock() - start);
+
+        cout << "rerank " << reranks[r] << ":\t" << 1000.0 * time / queries << " ms per query, recall "
+             << (double)found / queries << ", speedup " << exactTime / time << endl;
+    }
+
+    ProjectionGallery classes(exact);
+    MatchingOptions classOptions;
+    classOptions.centroids = true;
+
+    const int probes[] = { 1, 4, 16 };
+    for (unsigned p = 0; p < sizeof(probes) / sizeof(probes[0]); ++p)
+    {
+        classOptions.probes = probes[p];
+        classes.setMatchingOptions(classOptions);
+
+        int found = 0;
+        start = clock();
+        for (int i = 0; i < queries; ++i)
+        {
+            if (classes.label(classes.nearest(queryMat.row(i))) == exact.label(truth[i]))
+                ++found;
+        }
+        double time = seconds(clock() - start);
+
+        cout << "probes " << probes[p] << ":\t" << 1000.0 * time / queries << " ms per query, ID recall "
+             << (double)found / queries << ", speedup " << exactTime / time << endl;
+    }
+
+    // The rows are scaled to unit length when the mode is set, every query scales itself
+    ProjectionGallery cosine(exact);
+    MatchingOptions cosineOptions;
+    cosineOptions.distance = DistanceCosine;
+    cosine.setMatchingOptions(cosineOptions);
+
+    int agree = 0;
+    start = clock();
+    for (int i = 0; i < queries; ++i)
+    {
+        if (cosine.label(cosine.nearest(queryMat.row(i))) == exact.label(truth[i]))
+            ++agree;
+    }
+    double cosineTime = seconds(clock() - start);
+
+    cout << "cosine: " << 1000.0 * cosineTime / queries << " ms per query, same ID as Euclidean "
+         << (double)agree / queries << ", relative time " << cosineTime / exactTime << endl;
+
+    return 0;
+}
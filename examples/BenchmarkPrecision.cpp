@@ -0,0 +1,177 @@
+/** ===========================================================
+ * @file
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Compares single and double precision models of Eigenfaces and Fisherfaces.
+ * @section DESCRIPTION
+ *
+ * Trains both engines on the faces of database/train, once in single precision (the default) and
+ * once with TrainingOptions::doublePrecision, and measures training and recognition time, the
+ * recognition rate on database/test and the largest difference of the reported distances.
+ *
+ * Usage: BenchmarkPrecisionExample [database directory] [components]
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+
+// Extra libraries for use in client programs
+#if defined (__APPLE__)
+#include <cv.h>
+#include <highgui.h>
+#else
+#include <opencv/cv.h>
+#include <opencv/highgui.h>
+#endif
+
+// Our library
+#include "Eigenfaces.h"
+#include "Face.h"
+#include "FisherFaces.h"
+
+using namespace std;
+
+// Use namespace libface in the library.
+using namespace libface;
+
+static double wallSeconds()
+{
+    timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+struct Result
+{
+    double trainSeconds;
+    double testSeconds;
+    int    correct;
+    vector<float> distances;   // Distance of the best match of every test face
+};
+
+/**
+ * Trains an engine and recognizes the test faces, the face with index i belongs to ID i + 1.
+ */
+template <class Engine>
+static Result run(bool doublePrecision, const string& dir, vector<Face*>& training, const vector<IplImage*>& tests, int components)
+{
+    // the database directory holds no model, so the engine starts untrained
+    Engine engine(dir);
+    TrainingOptions options;
+    options.doublePrecision = doublePrecision;
+    engine.setTrainingOptions(options);
+
+    Result result;
+    double start = wallSeconds();
+    engine.training(&training, components);
+    result.trainSeconds = wallSeconds() - start;
+
+    start = wallSeconds();
+    vector<int> ids     = engine.testingIDs(tests);
+    result.testSeconds  = wallSeconds() - start;
+
+    result.correct = 0;
+    for (unsigned i = 0; i < ids.size(); ++i)
+    {
+        if (ids[i] == (int)i + 1)
+            ++result.correct;
+
+        vector<pair<int, float> > best = engine.testingTopK(tests[i], 1);
+        result.distances.push_back(best.empty() ? 0.0f : best[0].second);
+    }
+    return result;
+}
+
+template <class Engine>
+static void compare(const char* name, const string& dir, vector<Face*>& training, const vector<IplImage*>& tests, int components)
+{
+    Result single = run<Engine>(false, dir, training, tests, components);
+    Result twice  = run<Engine>(true, dir, training, tests, components);
+
+    double largest = 0.0;
+    for (unsigned i = 0; i < single.distances.size() && i < twice.distances.size(); ++i)
+    {
+        double scale = max(1e-12, fabs((double)twice.distances[i]));
+        largest      = max(largest, fabs((double)single.distances[i] - twice.distances[i]) / scale);
+    }
+
+    printf("%-12s %-7s train %8.3f s  test %8.4f s  recognised %d / %d\n", name, "float",
+           single.trainSeconds, single.testSeconds, single.correct, (int)tests.size());
+    printf("%-12s %-7s train %8.3f s  test %8.4f s  recognised %d / %d\n", name, "double",
+           twice.trainSeconds, twice.testSeconds, twice.correct, (int)tests.size());
+    printf("%-12s speedup train %.2fx, largest relative distance difference %.2e\n", name,
+           single.trainSeconds > 0.0 ? twice.trainSeconds / single.trainSeconds : 0.0, largest);
+}
+
+int main(int argc, char** argv)
+{
+    string dir     = argc > 1 ? argv[1] : "database";
+    int components = argc > 2 ? atoi(argv[2]) : 0;
+
+    // train/s<id>/<n>.pgm are the faces of ID id, test/<id>.pgm is one more face of it
+    vector<Face*> training;
+    vector<IplImage*> tests;
+    for (int id = 1; ; ++id)
+    {
+        stringstream test;
+        test << dir << "/test/" << id << ".pgm";
+        IplImage* img = cvLoadImage(test.str().c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+        if (!img)
+            break;
+        tests.push_back(img);
+
+        for (int n = 1; ; ++n)
+        {
+            stringstream file;
+            file << dir << "/train/s" << id << "/" << n << ".pgm";
+            IplImage* face = cvLoadImage(file.str().c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+            if (!face)
+                break;
+            training.push_back(new Face(0, 0, face->width, face->height, id, face));
+        }
+    }
+
+    if (training.empty() || tests.empty())
+    {
+        cout << "No faces found in " << dir << ". Usage: " << argv[0] << " [database directory] [components]" << endl;
+        return 1;
+    }
+
+    cout << "Training with " << training.size() << " faces, testing " << tests.size() << " faces." << endl;
+
+    compare<Eigenfaces>("Eigenfaces", dir, training, tests, components);
+    compare<Fisherfaces>("Fisherfaces", dir, training, tests, components);
+
+    for (unsigned i = 0; i < training.size(); ++i)
+        delete training[i];
+    for (unsigned i = 0; i < tests.size(); ++i)
+        cvReleaseImage(&tests[i]);
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+/** ===========================================================
+ * @file BatchDetect.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Face detection over many images using a pool of worker threads.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "BatchDetect.h"
+
+// LibFace headers
+#include "Log.h"
+#include "Face.h"
+#include "FaceDetect.h"
+#include "ThreadPool.h"
+
+// OpenCV headers
+#if defined (__APPLE__)
+#include <highgui.h>
+#else
+#include <opencv/highgui.h>
+#endif
+
+// C headers
+#include <ctime>
+
+using namespace std;
+
+namespace libface {
+
+namespace {
+
+/**
+ * The state shared by all workers of one batch. Either filenames or images is used.
+ */
+struct BatchJob {
+
+    BatchJob(const vector<string>* argFilenames, const vector<const IplImage*>* argImages, DetectionListener* argListener)
+        : filenames(argFilenames), images(argImages), listener(argListener), next(0), results() {
+        total = filenames ? (int)filenames->size() : (int)images->size();
+        if(!listener) {
+            results.resize(total, 0);
+        }
+    }
+
+    const vector<string>*          filenames;
+    const vector<const IplImage*>* images;
+    DetectionListener*             listener;
+    int                            total;
+    int                            next;       // Next input to be handed out
+    vector<vector<Face*>*>         results;    // Filled by index when no listener is given
+
+    Mutex                          queueMutex;
+    Mutex                          deliveryMutex;
+};
+
+/**
+ * Worker loop: keeps taking the next unprocessed image until the batch is exhausted.
+ */
+class DetectTask : public Task {
+
+public:
+
+    DetectTask(BatchJob* job, FaceDetect* detector) : m_job(job), m_detector(detector) {}
+
+    void run() {
+        for(;;) {
+            int index;
+            {
+                MutexLocker locker(m_job->queueMutex);
+                if(m_job->next >= m_job->total) {
+                    return;
+                }
+                index = m_job->next++;
+            }
+
+            vector<Face*>* faces = detect(index);
+
+            if(m_job->listener) {
+                MutexLocker locker(m_job->deliveryMutex);
+                m_job->listener->facesDetected(index, faces);
+            } else {
+                // every index is written by exactly one worker
+                m_job->results[index] = faces;
+            }
+        }
+    }
+
+private:
+
+    vector<Face*>* detect(int index) {
+        if(m_job->images) {
+            const IplImage* image = m_job->images->at(index);
+            if(!image) {
+                LOG(libfaceWARNING) << "BatchDetect : Null image at index " << index << ", skipping.";
+                return new vector<Face*>();
+            }
+            return m_detector->detectFaces(image);
+        }
+
+        const string& filename = m_job->filenames->at(index);
+        IplImage* image        = cvLoadImage(filename.c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+        if(!image) {
+            LOG(libfaceWARNING) << "BatchDetect : Could not load " << filename << ", skipping.";
+            return new vector<Face*>();
+        }
+
+        vector<Face*>* faces = m_detector->detectFaces(image);
+        cvReleaseImage(&image);
+        return faces;
+    }
+
+    BatchJob*   m_job;
+    FaceDetect* m_detector;
+};
+
+} // namespace
+
+class BatchDetect::BatchDetectPriv {
+
+public:
+
+    BatchDetectPriv(int threads) : pool(threads), detectors() {}
+
+    ~BatchDetectPriv() {
+        for(unsigned i = 0; i < detectors.size(); ++i) {
+            delete detectors.at(i);
+        }
+    }
+
+    /**
+     * Runs one worker per detector over the job and blocks until the job is done.
+     *
+     * @param job The batch to process.
+     */
+    void process(BatchJob& job);
+
+    ThreadPool          pool;
+    vector<FaceDetect*> detectors;   // One per worker thread
+};
+
+void BatchDetect::BatchDetectPriv::process(BatchJob& job) {
+    clock_t batch = clock();
+
+    vector<DetectTask*> tasks;
+    for(unsigned i = 0; i < detectors.size(); ++i) {
+        tasks.push_back(new DetectTask(&job, detectors.at(i)));
+        pool.start(tasks.back());
+    }
+    pool.waitForDone();
+
+    for(unsigned i = 0; i < tasks.size(); ++i) {
+        delete tasks.at(i);
+    }
+
+    batch = clock() - batch;
+    LOG(libfaceDEBUG) << "Batch detection of " << job.total << " images with " << detectors.size()
+                      << " threads took: " << (double)batch / ((double)CLOCKS_PER_SEC) << "sec. (CPU time)";
+}
+
+BatchDetect::BatchDetect(const FaceDetect& prototype, int threads) : d(new BatchDetectPriv(threads)) {
+    for(int i = 0; i < d->pool.threadCount(); ++i) {
+        d->detectors.push_back(new FaceDetect(prototype));
+    }
+}
+
+BatchDetect::~BatchDetect() {
+    delete d;
+}
+
+int BatchDetect::threadCount() const {
+    return d->pool.threadCount();
+}
+
+ImageBufferStats BatchDetect::bufferStats() const {
+    ImageBufferStats stats;
+    for(unsigned i = 0; i < d->detectors.size(); ++i) {
+        stats += d->detectors.at(i)->bufferStats();
+    }
+    return stats;
+}
+
+vector<vector<Face*>*> BatchDetect::detectFaces(const vector<string>& filenames) {
+    BatchJob job(&filenames, 0, 0);
+    d->process(job);
+    return job.results;
+}
+
+vector<vector<Face*>*> BatchDetect::detectFaces(const vector<const IplImage*>& images) {
+    BatchJob job(0, &images, 0);
+    d->process(job);
+    return job.results;
+}
+
+void BatchDetect::detectFaces(const vector<string>& filenames, DetectionListener* listener) {
+    BatchJob job(&filenames, 0, listener);
+    d->process(job);
+}
+
+void BatchDetect::detectFaces(const vector<const IplImage*>& images, DetectionListener* listener) {
+    BatchJob job(0, &images, listener);
+    d->process(job);
+}
+
+} // namespace libface
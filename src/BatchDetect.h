@@ -0,0 +1,151 @@
+/** ===========================================================
+ * @file BatchDetect.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Face detection over many images using a pool of worker threads.
+ * @section DESCRIPTION
+ *
+ * FaceDetect is not thread-safe, because the cascades keep per-image state. Every worker therefore
+ * owns a private copy of the detector and images are handed out to the workers one at a time.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _BATCHDETECT_H_
+#define _BATCHDETECT_H_
+
+// LibFace headers
+#include "LibFaceCore.h"
+#include "ImageBufferPool.h"
+
+// OpenCV headers
+#if defined (__APPLE__)
+#include <cv.h>
+#else
+#include <opencv/cv.h>
+#endif
+
+// C headers
+#include <string>
+#include <vector>
+
+namespace libface
+{
+
+// forward declaration
+class Face;
+class FaceDetect;
+
+/**
+ * Interface for receiving detection results as soon as each image is done.
+ */
+class FACEAPI DetectionListener
+{
+public:
+
+    virtual ~DetectionListener() {};
+
+    /**
+     * Purely virtual method called once for every input image, in order of completion. Calls are
+     * serialised, so implementations do not need to lock, but they should return quickly.
+     *
+     * @param index Position of the image in the input list.
+     * @param faces Detected faces. The listener takes ownership of the vector and the faces.
+     */
+    virtual void facesDetected(int index, std::vector<Face*>* faces) = 0;
+};
+
+class FACEAPI BatchDetect
+{
+public:
+
+    /**
+     * Constructor. Every worker thread gets its own copy of the prototype detector.
+     *
+     * @param prototype Detector with the cascades and accuracy to be used.
+     * @param threads Number of worker threads. 0 or less uses one thread per core.
+     */
+    BatchDetect(const FaceDetect& prototype, int threads = 0);
+
+    /**
+     * Destructor. Stops the workers and deletes the detector copies.
+     */
+    ~BatchDetect();
+
+    /**
+     * Detects faces in a list of image files, which are loaded as grayscale.
+     *
+     * @param filenames Paths of the images.
+     *
+     * @return One vector of faces per input file, in input order. Unreadable files give an empty vector.
+     */
+    std::vector<std::vector<Face*>*> detectFaces(const std::vector<std::string>& filenames);
+
+    /**
+     * Detects faces in a list of images.
+     *
+     * @param images Images to be searched. They are only read.
+     *
+     * @return One vector of faces per input image, in input order.
+     */
+    std::vector<std::vector<Face*>*> detectFaces(const std::vector<const IplImage*>& images);
+
+    /**
+     * Streaming variant of detectFaces(const std::vector<std::string>&). Blocks until all files
+     * are processed, handing each result to the listener as soon as it is available.
+     *
+     * @param filenames Paths of the images.
+     * @param listener Receiver of the results.
+     */
+    void detectFaces(const std::vector<std::string>& filenames, DetectionListener* listener);
+
+    /**
+     * Streaming variant of detectFaces(const std::vector<const IplImage*>&).
+     *
+     * @param images Images to be searched. They are only read.
+     * @param listener Receiver of the results.
+     */
+    void detectFaces(const std::vector<const IplImage*>& images, DetectionListener* listener);
+
+    /**
+     * @return Number of worker threads.
+     */
+    int threadCount() const;
+
+    /**
+     * Sums the image buffer statistics of the detectors of all workers, see FaceDetect::bufferStats().
+     * Must not be called while a batch is running.
+     *
+     * @return The combined statistics. peakBytes is the sum of the peaks of the workers.
+     */
+    ImageBufferStats bufferStats() const;
+
+private:
+
+    BatchDetect(const BatchDetect&);
+    BatchDetect& operator = (const BatchDetect&);
+
+    class BatchDetectPriv;
+    BatchDetectPriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _BATCHDETECT_H_ */
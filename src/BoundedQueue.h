@@ -0,0 +1,107 @@
+/** ===========================================================
+ * @file BoundedQueue.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Blocking FIFO queue with a fixed capacity.
+ * @section DESCRIPTION
+ *
+ * Producers block in push() while the queue is full and consumers block in pop() while it is empty.
+ * This is used between pipeline stages, so that a fast stage cannot run arbitrarily far ahead of a
+ * slow one and memory use stays bounded.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _BOUNDEDQUEUE_H_
+#define _BOUNDEDQUEUE_H_
+
+// LibFace headers
+#include "ThreadPool.h"
+
+// C headers
+#include <deque>
+
+namespace libface
+{
+
+template <typename T>
+class BoundedQueue
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param capacity Maximum number of queued elements, at least 1.
+     */
+    explicit BoundedQueue(int capacity) : m_capacity(capacity > 0 ? capacity : 1) {}
+
+    /**
+     * Appends an element, blocking while the queue is full.
+     *
+     * @param value Element to be queued.
+     */
+    void push(const T& value) {
+        MutexLocker locker(m_mutex);
+        while((int)m_queue.size() >= m_capacity) {
+            m_notFull.wait(m_mutex);
+        }
+        m_queue.push_back(value);
+        m_notEmpty.wakeOne();
+    }
+
+    /**
+     * Removes the oldest element, blocking while the queue is empty.
+     *
+     * @return The oldest element.
+     */
+    T pop() {
+        MutexLocker locker(m_mutex);
+        while(m_queue.empty()) {
+            m_notEmpty.wait(m_mutex);
+        }
+        T value = m_queue.front();
+        m_queue.pop_front();
+        m_notFull.wakeOne();
+        return value;
+    }
+
+    /**
+     * @return The capacity given at construction.
+     */
+    int capacity() const {
+        return m_capacity;
+    }
+
+private:
+
+    BoundedQueue(const BoundedQueue&);
+    BoundedQueue& operator = (const BoundedQueue&);
+
+    const int     m_capacity;
+    std::deque<T> m_queue;
+    Mutex         m_mutex;
+    WaitCondition m_notFull;
+    WaitCondition m_notEmpty;
+};
+
+} // namespace libface
+
+#endif /* _BOUNDEDQUEUE_H_ */
@@ -0,0 +1,248 @@
+/** ===========================================================
+ * @file ClassCentroidIndex.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Two level search of a ProjectionGallery: class centroids first, then their members.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "ClassCentroidIndex.h"
+
+// LibFace headers
+#include "DistanceKernels.h"
+#include "ProjectionGallery.h"
+
+// C headers
+#include <algorithm>
+
+using namespace std;
+using namespace cv;
+
+namespace libface {
+
+class ClassCentroidIndex::ClassCentroidIndexPriv {
+
+public:
+
+    ClassCentroidIndexPriv() : rows(0), dimension(0), classOf(), members(), sums(), centroids(0) {}
+
+    ClassCentroidIndexPriv(const ClassCentroidIndexPriv& that) : rows(that.rows), dimension(that.dimension), classOf(that.classOf), members(that.members),
+                                                                 sums(that.sums), centroids(that.centroids ? new ProjectionGallery(*that.centroids) : 0) {}
+
+    ClassCentroidIndexPriv& operator = (const ClassCentroidIndexPriv& that) {
+        if(this != &that) {
+            rows      = that.rows;
+            dimension = that.dimension;
+            classOf   = that.classOf;
+            members   = that.members;
+            sums      = that.sums;
+            delete centroids;
+            centroids = that.centroids ? new ProjectionGallery(*that.centroids) : 0;
+        }
+        return *this;
+    }
+
+    ~ClassCentroidIndexPriv() {
+        delete centroids;
+    }
+
+    int                  rows;        // Projections indexed so far
+    int                  dimension;
+    map<int, int>        classOf;     // Label to class
+    vector<vector<int> > members;     // Gallery rows of every class
+    vector<double>       sums;        // dimension per class
+
+    // Rows are the classes and labels their number, which gives aligned rows and the exact scan for free.
+    // Created on demand, the gallery owns an index of this kind itself.
+    ProjectionGallery*   centroids;
+};
+
+ClassCentroidIndex::ClassCentroidIndex() : d(new ClassCentroidIndexPriv) {}
+
+ClassCentroidIndex::ClassCentroidIndex(const ClassCentroidIndex& that) : d(new ClassCentroidIndexPriv(*that.d)) {}
+
+ClassCentroidIndex& ClassCentroidIndex::operator = (const ClassCentroidIndex& that) {
+    if(this != &that) {
+        *d = *that.d;
+    }
+    return *this;
+}
+
+ClassCentroidIndex::~ClassCentroidIndex() {
+    delete d;
+}
+
+void ClassCentroidIndex::clear() {
+    d->rows      = 0;
+    d->dimension = 0;
+    d->classOf.clear();
+    d->members.clear();
+    d->sums.clear();
+    delete d->centroids;
+    d->centroids = 0;
+}
+
+int ClassCentroidIndex::size() const {
+    return d->rows;
+}
+
+int ClassCentroidIndex::classes() const {
+    return (int)d->members.size();
+}
+
+void ClassCentroidIndex::update(const ProjectionGallery& gallery) {
+    if(gallery.size() <= d->rows) {
+        return;
+    }
+    d->dimension = gallery.dimension();
+    if(!d->centroids) {
+        d->centroids = new ProjectionGallery;
+    }
+
+    vector<int> touched;
+    for(int i = d->rows; i < gallery.size(); ++i) {
+        if(gallery.removed(i)) {
+            continue;
+        }
+        int label = gallery.label(i);
+
+        map<int, int>::iterator it = d->classOf.find(label);
+        int c;
+        if(it == d->classOf.end()) {
+            c                 = (int)d->members.size();
+            d->classOf[label] = c;
+            d->members.push_back(vector<int>());
+            d->sums.resize(d->sums.size() + d->dimension, 0.0);
+        } else {
+            c = it->second;
+        }
+
+        d->members[c].push_back(i);
+
+        const float* p = gallery.row(i);
+        double* sum    = &d->sums[(size_t)c * d->dimension];
+        for(int j = 0; j < d->dimension; ++j) {
+            sum[j] += p[j];
+        }
+        touched.push_back(c);
+    }
+    d->rows = gallery.size();
+
+    sort(touched.begin(), touched.end());
+    touched.erase(unique(touched.begin(), touched.end()), touched.end());
+
+    // new classes come in order, so class c is row c of the centroids
+    Mat centroid(1, d->dimension, CV_64FC1);
+    for(unsigned t = 0; t < touched.size(); ++t) {
+        int c             = touched[t];
+        const double* sum = &d->sums[(size_t)c * d->dimension];
+        double count      = (double)d->members[c].size();
+        for(int j = 0; j < d->dimension; ++j) {
+            centroid.at<double>(j) = sum[j] / count;
+        }
+
+        if(c < d->centroids->size()) {
+            d->centroids->set(c, centroid);
+        } else {
+            d->centroids->add(centroid, c);
+        }
+    }
+}
+
+void ClassCentroidIndex::remove(const ProjectionGallery& gallery, int index) {
+    map<int, int>::iterator it = d->classOf.find(gallery.label(index));
+    if(it == d->classOf.end() || index >= d->rows) {
+        return;
+    }
+
+    const int c       = it->second;
+    vector<int>& rows = d->members[c];
+    vector<int>::iterator member = std::find(rows.begin(), rows.end(), index);
+    if(member == rows.end()) {
+        return;
+    }
+    rows.erase(member);
+
+    const float* p = gallery.row(index);
+    double* sum    = &d->sums[(size_t)c * d->dimension];
+    for(int j = 0; j < d->dimension; ++j) {
+        sum[j] -= p[j];
+    }
+
+    if(rows.empty()) {
+        // the label may come back, it then gets a new class
+        d->classOf.erase(it);
+        std::fill(sum, sum + d->dimension, 0.0);
+        d->centroids->remove(c);
+        return;
+    }
+
+    Mat centroid(1, d->dimension, CV_64FC1);
+    for(int j = 0; j < d->dimension; ++j) {
+        centroid.at<double>(j) = sum[j] / rows.size();
+    }
+    d->centroids->set(c, centroid);
+}
+
+vector<pair<int, float> > ClassCentroidIndex::search(const ProjectionGallery& gallery, const Mat& query, int k, int probes) const {
+    vector<pair<int, float> > result;
+
+    vector<float> buffer;
+    const float* q = gallery.padQuery(query, buffer);
+    if(!q || k <= 0 || !d->centroids) {
+        return result;
+    }
+
+    // the closest centroids, labels of the centroid gallery are the classes
+    vector<pair<int, float> > closest = d->centroids->nearestLabels(query, std::max(k, probes));
+
+    for(unsigned i = 0; i < closest.size(); ++i) {
+        const vector<int>& rows = d->members[closest[i].first];
+
+        int best      = -1;
+        float minDist = 0.0f;
+        for(unsigned j = 0; j < rows.size(); ++j) {
+            float dist = DistanceKernels::squaredDistance(q, gallery.row(rows[j]), gallery.stride());
+            if(best < 0 || dist < minDist) {
+                best    = rows[j];
+                minDist = dist;
+            }
+        }
+        result.push_back(make_pair(best, minDist));
+    }
+
+    // the order of the centroids is not the order of the members
+    vector<pair<float, int> > order;
+    for(unsigned i = 0; i < result.size(); ++i) {
+        order.push_back(make_pair(result[i].second, result[i].first));
+    }
+    sort(order.begin(), order.end());
+
+    result.clear();
+    for(unsigned i = 0; i < order.size() && (int)i < k; ++i) {
+        result.push_back(make_pair(order[i].second, order[i].first));
+    }
+    return result;
+}
+
+} // namespace libface
@@ -0,0 +1,134 @@
+/** ===========================================================
+ * @file ClassCentroidIndex.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Two level search of a ProjectionGallery: class centroids first, then their members.
+ * @section DESCRIPTION
+ *
+ * With many photos per person, a query is compared with far more projections than there are people.
+ * The index keeps the mean projection of every label and the list of its projections. A query is
+ * compared with all centroids, and exactly with the projections of the closest few labels only, so
+ * the cost grows with the number of people and the photos of a few of them.
+ *
+ * The index only stores centroids and member lists. Vectors are read from the gallery passed to
+ * every call, which must be the one the index was built from.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _CLASSCENTROIDINDEX_H_
+#define _CLASSCENTROIDINDEX_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+// C headers
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace libface
+{
+
+class ProjectionGallery;
+
+class FACEAPI ClassCentroidIndex
+{
+public:
+
+    /**
+     * Constructor. The index is empty until update() is called.
+     */
+    ClassCentroidIndex();
+
+    /**
+     * Copy constructor.
+     *
+     * @param that The index to copy.
+     */
+    ClassCentroidIndex(const ClassCentroidIndex& that);
+
+    /**
+     * Assignment operator.
+     *
+     * @param that The index to copy.
+     */
+    ClassCentroidIndex& operator = (const ClassCentroidIndex& that);
+
+    /**
+     * Destructor.
+     */
+    ~ClassCentroidIndex();
+
+    /**
+     * Forgets all classes.
+     */
+    void clear();
+
+    /**
+     * @return Number of indexed projections.
+     */
+    int size() const;
+
+    /**
+     * @return Number of classes (labels).
+     */
+    int classes() const;
+
+    /**
+     * Adds the projections added to the gallery since the last call and moves the centroids of their classes.
+     *
+     * @param gallery The gallery the index follows.
+     */
+    void update(const ProjectionGallery& gallery);
+
+    /**
+     * Takes a projection out of its class before the gallery marks it as removed.
+     *
+     * @param gallery The gallery the index follows.
+     * @param index Index of the projection.
+     */
+    void remove(const ProjectionGallery& gallery, int index);
+
+    /**
+     * Finds the closest projection of each of the closest classes. The classes are ranked by their
+     * centroids, the projections of the probed classes are compared exactly.
+     *
+     * @param gallery The gallery the index was built from.
+     * @param query The projected query, a single row or column of gallery.dimension() elements, any depth.
+     * @param k Maximum number of results, one per class.
+     * @param probes Number of classes whose projections are compared, at least k are.
+     *
+     * @return Up to k pairs of gallery index and squared distance, of different classes, closest first.
+     */
+    std::vector<std::pair<int, float> > search(const ProjectionGallery& gallery, const cv::Mat& query, int k, int probes) const;
+
+private:
+
+    class ClassCentroidIndexPriv;
+    ClassCentroidIndexPriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _CLASSCENTROIDINDEX_H_ */
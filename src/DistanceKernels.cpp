@@ -0,0 +1,320 @@
+/** ===========================================================
+ * @file DistanceKernels.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Vectorised dot products for nearest neighbour search.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "DistanceKernels.h"
+
+// C headers
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define LIBFACE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace libface {
+
+int DistanceKernels::padded(int n) {
+    return (n + WIDTH - 1) / WIDTH * WIDTH;
+}
+
+#if defined(__AVX__)
+
+static inline float horizontalSum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum        = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum        = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+float DistanceKernels::dot(const float* a, const float* b, int n) {
+    __m256 acc = _mm256_setzero_ps();
+    for(int i = 0; i < n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i)));
+    }
+    return horizontalSum(acc);
+}
+
+void DistanceKernels::dot4(const float* query, const float* rows, int stride, int n, float* out) {
+    const float* r0 = rows;
+    const float* r1 = rows + stride;
+    const float* r2 = rows + 2 * stride;
+    const float* r3 = rows + 3 * stride;
+
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+
+    for(int i = 0; i < n; i += 8) {
+        __m256 q = _mm256_load_ps(query + i);
+        acc0     = _mm256_add_ps(acc0, _mm256_mul_ps(q, _mm256_load_ps(r0 + i)));
+        acc1     = _mm256_add_ps(acc1, _mm256_mul_ps(q, _mm256_load_ps(r1 + i)));
+        acc2     = _mm256_add_ps(acc2, _mm256_mul_ps(q, _mm256_load_ps(r2 + i)));
+        acc3     = _mm256_add_ps(acc3, _mm256_mul_ps(q, _mm256_load_ps(r3 + i)));
+    }
+
+    out[0] = horizontalSum(acc0);
+    out[1] = horizontalSum(acc1);
+    out[2] = horizontalSum(acc2);
+    out[3] = horizontalSum(acc3);
+}
+
+float DistanceKernels::squaredDistance(const float* a, const float* b, int n) {
+    __m256 acc = _mm256_setzero_ps();
+    for(int i = 0; i < n; i += 8) {
+        __m256 diff = _mm256_sub_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i));
+        acc         = _mm256_add_ps(acc, _mm256_mul_ps(diff, diff));
+    }
+    return horizontalSum(acc);
+}
+
+double DistanceKernels::sumSquaredDifferences(const float* a, const float* b, int n) {
+    double sum = 0.0;
+    int i      = 0;
+    while(i + 8 <= n) {
+        // float lanes for a block, double between blocks, so long vectors keep their precision
+        __m256 acc = _mm256_setzero_ps();
+        for(int end = std::min(n, i + 1024); i + 8 <= end; i += 8) {
+            __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+            acc         = _mm256_add_ps(acc, _mm256_mul_ps(diff, diff));
+        }
+        sum += horizontalSum(acc);
+    }
+    for(; i < n; ++i) {
+        float diff = a[i] - b[i];
+        sum       += diff * diff;
+    }
+    return sum;
+}
+
+const char* DistanceKernels::instructionSet() {
+    return "AVX";
+}
+
+#elif defined(LIBFACE_SSE)
+
+static inline float horizontalSum(__m128 sum) {
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+float DistanceKernels::dot(const float* a, const float* b, int n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for(int i = 0; i < n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_load_ps(a + i + 4), _mm_load_ps(b + i + 4)));
+    }
+    return horizontalSum(_mm_add_ps(acc0, acc1));
+}
+
+void DistanceKernels::dot4(const float* query, const float* rows, int stride, int n, float* out) {
+    const float* r0 = rows;
+    const float* r1 = rows + stride;
+    const float* r2 = rows + 2 * stride;
+    const float* r3 = rows + 3 * stride;
+
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+
+    for(int i = 0; i < n; i += 4) {
+        __m128 q = _mm_load_ps(query + i);
+        acc0     = _mm_add_ps(acc0, _mm_mul_ps(q, _mm_load_ps(r0 + i)));
+        acc1     = _mm_add_ps(acc1, _mm_mul_ps(q, _mm_load_ps(r1 + i)));
+        acc2     = _mm_add_ps(acc2, _mm_mul_ps(q, _mm_load_ps(r2 + i)));
+        acc3     = _mm_add_ps(acc3, _mm_mul_ps(q, _mm_load_ps(r3 + i)));
+    }
+
+    out[0] = horizontalSum(acc0);
+    out[1] = horizontalSum(acc1);
+    out[2] = horizontalSum(acc2);
+    out[3] = horizontalSum(acc3);
+}
+
+float DistanceKernels::squaredDistance(const float* a, const float* b, int n) {
+    __m128 acc = _mm_setzero_ps();
+    for(int i = 0; i < n; i += 4) {
+        __m128 diff = _mm_sub_ps(_mm_load_ps(a + i), _mm_load_ps(b + i));
+        acc         = _mm_add_ps(acc, _mm_mul_ps(diff, diff));
+    }
+    return horizontalSum(acc);
+}
+
+double DistanceKernels::sumSquaredDifferences(const float* a, const float* b, int n) {
+    double sum = 0.0;
+    int i      = 0;
+    while(i + 4 <= n) {
+        // float lanes for a block, double between blocks, so long vectors keep their precision
+        __m128 acc = _mm_setzero_ps();
+        for(int end = std::min(n, i + 1024); i + 4 <= end; i += 4) {
+            __m128 diff = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+            acc         = _mm_add_ps(acc, _mm_mul_ps(diff, diff));
+        }
+        sum += horizontalSum(acc);
+    }
+    for(; i < n; ++i) {
+        float diff = a[i] - b[i];
+        sum       += diff * diff;
+    }
+    return sum;
+}
+
+const char* DistanceKernels::instructionSet() {
+    return "SSE";
+}
+
+#else
+
+float DistanceKernels::dot(const float* a, const float* b, int n) {
+    float sum = 0.0f;
+    for(int i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void DistanceKernels::dot4(const float* query, const float* rows, int stride, int n, float* out) {
+    for(int r = 0; r < 4; ++r) {
+        out[r] = dot(query, rows + r * stride, n);
+    }
+}
+
+float DistanceKernels::squaredDistance(const float* a, const float* b, int n) {
+    float sum = 0.0f;
+    for(int i = 0; i < n; ++i) {
+        float diff = a[i] - b[i];
+        sum       += diff * diff;
+    }
+    return sum;
+}
+
+double DistanceKernels::sumSquaredDifferences(const float* a, const float* b, int n) {
+    double sum = 0.0;
+    for(int i = 0; i < n; ++i) {
+        float diff = a[i] - b[i];
+        sum       += diff * diff;
+    }
+    return sum;
+}
+
+const char* DistanceKernels::instructionSet() {
+    return "scalar";
+}
+
+#endif
+
+#if defined(__AVX__) || defined(LIBFACE_SSE)
+
+double DistanceKernels::sumSquaredDifferences(const unsigned char* a, const unsigned char* b, int n) {
+    const __m128i zero = _mm_setzero_si128();
+
+    double sum = 0.0;
+    int i      = 0;
+    while(i + 16 <= n) {
+        // a lane gains at most 4 * 255^2 per step (two madd results of two squares each), so 4096 steps
+        // stay below 1.07e9, well under INT_MAX
+        __m128i acc = _mm_setzero_si128();
+        for(int steps = 0; steps < 4096 && i + 16 <= n; ++steps, i += 16) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+            __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+            __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+            acc        = _mm_add_epi32(acc, _mm_madd_epi16(lo, lo));
+            acc        = _mm_add_epi32(acc, _mm_madd_epi16(hi, hi));
+        }
+        int lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        sum += (double)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    for(; i < n; ++i) {
+        int diff = a[i] - b[i];
+        sum     += diff * diff;
+    }
+    return sum;
+}
+
+float DistanceKernels::dot(const float* a, const signed char* codes, int n) {
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    __m128 acc2 = _mm_setzero_ps();
+    __m128 acc3 = _mm_setzero_ps();
+
+    int i = 0;
+    for(; i + 16 <= n; i += 16) {
+        // sign extension to 16 and then 32 bits, SSE2 has no direct conversion of bytes
+        __m128i v      = _mm_loadu_si128((const __m128i*)(codes + i));
+        __m128i sign   = _mm_cmpgt_epi8(zero, v);
+        __m128i lo     = _mm_unpacklo_epi8(v, sign);
+        __m128i hi     = _mm_unpackhi_epi8(v, sign);
+        __m128i loSign = _mm_srai_epi16(lo, 15);
+        __m128i hiSign = _mm_srai_epi16(hi, 15);
+
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, loSign))));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, loSign))));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(a + i + 8), _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, hiSign))));
+        acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(a + i + 12), _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, hiSign))));
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(_mm_add_ps(acc0, acc1), _mm_add_ps(acc2, acc3)));
+    float sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for(; i < n; ++i) {
+        sum += a[i] * codes[i];
+    }
+    return sum;
+}
+
+#else
+
+double DistanceKernels::sumSquaredDifferences(const unsigned char* a, const unsigned char* b, int n) {
+    double sum = 0.0;
+    for(int i = 0; i < n; ++i) {
+        int diff = a[i] - b[i];
+        sum     += diff * diff;
+    }
+    return sum;
+}
+
+float DistanceKernels::dot(const float* a, const signed char* codes, int n) {
+    float sum = 0.0f;
+    for(int i = 0; i < n; ++i) {
+        sum += a[i] * codes[i];
+    }
+    return sum;
+}
+
+#endif
+
+} // namespace libface
@@ -0,0 +1,135 @@
+/** ===========================================================
+ * @file DistanceKernels.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Vectorised dot products for nearest neighbour search.
+ * @section DESCRIPTION
+ *
+ * The kernels work on float vectors whose length is a multiple of DistanceKernels::WIDTH and
+ * whose start is aligned to DistanceKernels::ALIGNMENT bytes, as stored by ProjectionGallery.
+ * They are compiled with AVX if the build enables it (cmake -DENABLE_AVX=ON), otherwise with SSE
+ * on x86 and plain C++ elsewhere.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _DISTANCEKERNELS_H_
+#define _DISTANCEKERNELS_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+namespace libface
+{
+
+class FACEAPI DistanceKernels
+{
+public:
+
+    enum {
+        WIDTH     = 8,    // Vector lengths must be a multiple of this many floats
+        ALIGNMENT = 64    // Vectors must start at a multiple of this many bytes
+    };
+
+    /**
+     * @param n Number of floats.
+     *
+     * @return n rounded up to a multiple of WIDTH.
+     */
+    static int padded(int n);
+
+    /**
+     * Dot product of two vectors.
+     *
+     * @param a First vector.
+     * @param b Second vector.
+     * @param n Length, a multiple of WIDTH.
+     *
+     * @return The dot product.
+     */
+    static float dot(const float* a, const float* b, int n);
+
+    /**
+     * Dot products of a query with four consecutive rows of a matrix. The query is read once for
+     * all four rows, which halves memory traffic compared to four calls of dot().
+     *
+     * @param query The query vector.
+     * @param rows First of the four rows.
+     * @param stride Distance between two rows in floats, a multiple of WIDTH.
+     * @param n Length, a multiple of WIDTH.
+     * @param out Receives the four dot products.
+     */
+    static void dot4(const float* query, const float* rows, int stride, int n, float* out);
+
+    /**
+     * Squared Euclidean distance of two vectors.
+     *
+     * @param a First vector.
+     * @param b Second vector.
+     * @param n Length, a multiple of WIDTH.
+     *
+     * @return The squared distance.
+     */
+    static float squaredDistance(const float* a, const float* b, int n);
+
+    /**
+     * Sum of squared differences of two vectors without alignment or length requirements, e.g. rows
+     * of two images.
+     *
+     * @param a First vector.
+     * @param b Second vector.
+     * @param n Length.
+     *
+     * @return The sum.
+     */
+    static double sumSquaredDifferences(const float* a, const float* b, int n);
+
+    /**
+     * Sum of squared differences of two byte vectors, computed exactly with integers.
+     *
+     * @param a First vector.
+     * @param b Second vector.
+     * @param n Length.
+     *
+     * @return The sum.
+     */
+    static double sumSquaredDifferences(const unsigned char* a, const unsigned char* b, int n);
+
+    /**
+     * Dot product of a float vector with a vector of signed bytes, e.g. a scaled query with the
+     * 8 bit codes of a ScalarQuantizer, without alignment or length requirements.
+     *
+     * @param a The float vector.
+     * @param codes The byte vector.
+     * @param n Length.
+     *
+     * @return The dot product.
+     */
+    static float dot(const float* a, const signed char* codes, int n);
+
+    /**
+     * @return Name of the instruction set the kernels were compiled for: "AVX", "SSE" or "scalar".
+     */
+    static const char* instructionSet();
+};
+
+} // namespace libface
+
+#endif /* _DISTANCEKERNELS_H_ */
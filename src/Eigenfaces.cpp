@@ -46,6 +46,14 @@
 #include "Face.h"
 #include "FaceDetect.h"
 #include "LibFaceUtils.h"
+#include "ProjectionGallery.h"
+#include "RandomizedPCA.h"
+#include "FaceStream.h"
+#include "StreamingPCA.h"
+#include "IncrementalPCA.h"
+#include "ThreadPool.h"
+#include "DistanceKernels.h"
+#include "ScratchArena.h"
 
 // OpenCV headers
 #if defined (__APPLE__)
@@ -95,18 +103,20 @@ public:
     ~EigenfacesPriv();
 
     /**
-     * TODO
+     * Distance of two images as the largest eigenvalue of their two-image PCA. The two images are
+     * a - m and b - m = -(a - m) around their mean m, so that eigenvalue is |a - b|^2 / 2 and is
+     * computed directly, without any allocation.
      *
-     * @param img1
-     * @param img2
-     * @return
+     * @param img1 First image.
+     * @param img2 Second image, of the same size and channels.
      *
+     * @return Half the squared Euclidean distance of the images.
      */
     float eigen(IplImage* img1, IplImage* img2);
 
     /**
      * Calculates Root Mean Squared error between 2 images. The method doesn't modify input images.
-     * N.B. only 1 channel is used at present.
+     * All channels are used, in one pass without allocation.
      *
      * @param img1 First input image to compare with.
      * @param img2 Second input image to compare with.
@@ -116,12 +126,106 @@ public:
     double rms(const IplImage* img1, const IplImage* img2);
 
     /**
-     * Performs PCA on the current training data, projects the training faces, and stores them in a DB.
+     * @return Largest distance of a recognised face under the distance mode of the gallery, as
+     * reported by recognize().
+     */
+    float threshold() const;
+
+    /**
+     * Projects a face image into the eigenspace found by training, whitened like the stored
+     * projections.
+     *
+     * @param img The face image, of the same size as the training faces.
+     *
+     * @return The projection as a row vector, or an empty matrix if there is no eigenspace or the size does not match.
+     */
+    Mat project(const IplImage* img) const;
+
+    /**
+     * Starts drift tracking after training: remembers the number of samples of the model and the
+     * fraction of their energy outside the eigenspace. Then applies the distance mode to the new,
+     * plain projections of the gallery.
+     *
+     * @param energy Sum of the squared distances of the training faces from the mean, negative if unknown.
+     */
+    void trained(double energy);
+
+    /**
+     * Records an enrolled face and its projection for the next update of the eigenspace.
+     *
+     * @param face The face as a row, of the dimension of the mean.
+     * @param projection Its projection.
+     * @param row Index of the projection in the gallery.
+     */
+    void enroll(const Mat& face, const Mat& projection, int row);
+
+    /**
+     * Updates the eigenspace with the enrolled faces if their unexplained energy has risen more
+     * than the drift threshold, and forgets them.
+     */
+    void checkDrift();
+
+    /**
+     * Merges the enrolled faces into the eigenspace and maps the gallery into the new one.
+     */
+    void refresh();
+
+    /**
+     * Rebuilds the eigenvalues from the stored projections if the model has none, e.g. after
+     * loading. The projections must not be whitened.
+     *
+     * @return Number of faces the eigenspace was computed from, the pending ones left out.
+     */
+    int recoverEigenvalues();
+
+    /**
+     * Folds the whitening of the distance mode into the eigenvectors used for queries and whitens
+     * the stored projections in place. Without whitening queries use the eigenvectors. Call it on
+     * plain projections whenever the eigenspace or the distance mode changed.
+     */
+    void applyMetric();
+
+    /**
+     * Undoes applyMetric(), so the stored projections are those of the eigenspace again.
+     */
+    void removeMetric();
+
+    /**
+     * @param projection A projection onto the eigenvectors.
      *
-     * @param index Index of the previous image to be merged with.
-     * @param newFace A pointer to the new face to be merged with previous one stored at index.
+     * @return It as stored in the gallery, whitened if the distance mode asks for it.
      */
-    void learn(int index, IplImage* newFace);
+    Mat toStored(const Mat& projection) const;
+
+    /**
+     * @param index Index of a stored projection.
+     *
+     * @return The projection onto the eigenvectors, without whitening, CV_32F.
+     */
+    Mat fromStored(int index) const;
+
+    /**
+     * Releases the stored faces of an ID.
+     *
+     * @param id The ID.
+     *
+     * @return Number of faces released.
+     */
+    int forget(int id);
+
+    /**
+     * Drops the removed projections from the gallery once they take up a quarter of it, so that
+     * removal stays O(1) amortized.
+     *
+     * @param force Drop them whatever their number, e.g. before saving.
+     */
+    void compact(bool force);
+
+    /**
+     * @return Element type of the mean, the eigenvectors and the training matrix, CV_32FC1 unless
+     * the training options ask for double precision.
+     */
+    int modelType() const;
 
     // Face data members, stored in the DB
     // Array of face images. It is assumed that all elements of faceImgArr always point to valid IplImages. Otherwise runtime errors will occur.
@@ -135,7 +239,9 @@ public:
     double CUT_OFF;
     double UPPER_DIST;
     double LOWER_DIST;
-    float THRESHOLD;
+    float THRESHOLD;                // Largest recognised distance under DistanceEuclidean
+    float MAHALANOBIS_THRESHOLD;    // Under DistanceMahalanobis, in the unit of the whitened projections
+    float COSINE_THRESHOLD;         // Under DistanceCosine, the distance is at most 2
     float RMS_THRESHOLD;
     int FACE_WIDTH;
     int FACE_HEIGHT;
@@ -145,11 +251,21 @@ public:
      * New Addition
      */
     int m_no_principal_components;
-    vector<Mat> m_projections;
-    vector<int> m_labels;
+    ProjectionGallery m_gallery;
+    TrainingOptions trainingOptions;
     Mat m_eigenvectors;
     Mat m_eigenvalues;
     Mat m_mean;
+    Mat m_matchVectors;         // m_eigenvectors with the whitening folded in, projects the queries
+    Mat m_weights;              // Whitening of the stored projections per component, CV_64F row, empty for none
+
+    // Drift tracking of faces enrolled after training
+    int m_samples;              // Faces the eigenspace was computed from
+    double m_residual;          // Fraction of their energy outside the eigenspace, -1 if unknown
+    Mat m_pending;              // Faces enrolled since the last update of the eigenspace, CV_32F rows
+    vector<int> m_pendingRows;  // Their rows in the gallery
+    double m_pendingResidual;
+    double m_pendingEnergy;
 
     // Identifier
     Identifier idType;
@@ -157,11 +273,11 @@ public:
 };
 
 
-Eigenfaces::EigenfacesPriv::EigenfacesPriv() : faceImgArr(), indexMap(), configFile(), CUT_OFF(10000000.0), UPPER_DIST(10000000), LOWER_DIST(10000000), THRESHOLD(1000000.0), RMS_THRESHOLD(10.0), FACE_WIDTH(120), FACE_HEIGHT(120) {
+Eigenfaces::EigenfacesPriv::EigenfacesPriv() : faceImgArr(), indexMap(), configFile(), CUT_OFF(10000000.0), UPPER_DIST(10000000), LOWER_DIST(10000000), THRESHOLD(1000000.0), MAHALANOBIS_THRESHOLD(1000000.0), COSINE_THRESHOLD(2.0), RMS_THRESHOLD(10.0), FACE_WIDTH(120), FACE_HEIGHT(120), m_no_principal_components(0), m_samples(0), m_residual(-1.0), m_pendingResidual(0.0), m_pendingEnergy(0.0) {
     trainReq = AllImagesOfAllPersons;
 }
 
-Eigenfaces::EigenfacesPriv::EigenfacesPriv(const EigenfacesPriv& that) : faceImgArr(), indexMap(that.indexMap), configFile(that.configFile), CUT_OFF(that.CUT_OFF), UPPER_DIST(that.UPPER_DIST), LOWER_DIST(that.LOWER_DIST), THRESHOLD(that.THRESHOLD), RMS_THRESHOLD(that.RMS_THRESHOLD), FACE_WIDTH(that.FACE_WIDTH), FACE_HEIGHT(that.FACE_HEIGHT) {
+Eigenfaces::EigenfacesPriv::EigenfacesPriv(const EigenfacesPriv& that) : faceImgArr(), indexMap(that.indexMap), configFile(that.configFile), CUT_OFF(that.CUT_OFF), UPPER_DIST(that.UPPER_DIST), LOWER_DIST(that.LOWER_DIST), THRESHOLD(that.THRESHOLD), MAHALANOBIS_THRESHOLD(that.MAHALANOBIS_THRESHOLD), COSINE_THRESHOLD(that.COSINE_THRESHOLD), RMS_THRESHOLD(that.RMS_THRESHOLD), FACE_WIDTH(that.FACE_WIDTH), FACE_HEIGHT(that.FACE_HEIGHT), m_no_principal_components(that.m_no_principal_components), m_gallery(that.m_gallery), trainingOptions(that.trainingOptions), m_eigenvectors(that.m_eigenvectors), m_eigenvalues(that.m_eigenvalues), m_mean(that.m_mean), m_matchVectors(that.m_matchVectors), m_weights(that.m_weights), m_samples(that.m_samples), m_residual(that.m_residual), m_pending(that.m_pending.clone()), m_pendingRows(that.m_pendingRows), m_pendingResidual(that.m_pendingResidual), m_pendingEnergy(that.m_pendingEnergy), idType(that.idType), trainReq(that.trainReq) {
     // copy images pointed to by faceImgArr
     for(unsigned i = 0; i < that.faceImgArr.size(); ++i) {
         faceImgArr.push_back(cvCloneImage(that.faceImgArr.at(i)));
@@ -191,9 +307,27 @@ Eigenfaces::EigenfacesPriv& Eigenfaces::EigenfacesPriv::operator = (const Eigenf
     UPPER_DIST = that.UPPER_DIST;
     LOWER_DIST = that.LOWER_DIST;
     THRESHOLD = that.THRESHOLD;
+    MAHALANOBIS_THRESHOLD = that.MAHALANOBIS_THRESHOLD;
+    COSINE_THRESHOLD = that.COSINE_THRESHOLD;
     RMS_THRESHOLD = that.RMS_THRESHOLD;
     FACE_WIDTH = that.FACE_WIDTH;
     FACE_HEIGHT = that.FACE_HEIGHT;
+    m_no_principal_components = that.m_no_principal_components;
+    m_gallery = that.m_gallery;
+    trainingOptions = that.trainingOptions;
+    m_eigenvectors = that.m_eigenvectors;
+    m_eigenvalues = that.m_eigenvalues;
+    m_mean = that.m_mean;
+    m_matchVectors = that.m_matchVectors;
+    m_weights = that.m_weights;
+    m_samples = that.m_samples;
+    m_residual = that.m_residual;
+    m_pending = that.m_pending.clone();
+    m_pendingRows = that.m_pendingRows;
+    m_pendingResidual = that.m_pendingResidual;
+    m_pendingEnergy = that.m_pendingEnergy;
+    idType = that.idType;
+    trainReq = that.trainReq;
 
     return *this;
 }
@@ -204,241 +338,318 @@ Eigenfaces::EigenfacesPriv::~EigenfacesPriv() {
     }
 }
 
-float Eigenfaces::EigenfacesPriv::eigen(IplImage* img1, IplImage* img2) {
-
-    // TODO just a question, why is malloc prefered here over new?
-    /*
-    I tried using new and delete, resulting in 24 bytes less being allocated per function call.
-    I believe this is because cvAlloc allocates more memory than actually needed.
-    Using an array of pointers instead of a vector saves an additional 24 bytes per call.
-    */
-    // same applies to function learn
-
-    //#define new_and_delete
-#ifdef new_and_delete
-
-    // tempfaces is also not used in this version
-
-    float minDist = FLT_MAX;
+/**
+ * Sum of squared differences of two images of the same size and channels, in one pass over their
+ * rows. Bytes and floats are compared directly, other depths are converted row by row in the
+ * scratch space of the thread.
+ */
+static double sumSquaredDifferences(const IplImage* img1, const IplImage* img2) {
+    Mat a = cvarrToMat(img1);
+    Mat b = cvarrToMat(img2);
+    if(a.rows != b.rows || a.cols != b.cols || a.channels() != b.channels()) {
+        LOG(libfaceERROR) << "Images of " << a.cols << "x" << a.rows << " and " << b.cols << "x" << b.rows << " pixels cannot be compared.";
+        return DBL_MAX;
+    }
 
-    //#define tempFaces_as_vector
-#ifdef tempFaces_as_vector
-    vector<IplImage*> tempFaces;
-    tempFaces.push_back(img1);
-    tempFaces.push_back(img2);
-#else
-    IplImage * tempFaces[2];
-    tempFaces[0] = img1;
-    tempFaces[1] = img2;
-#endif
+    const int width = a.cols * a.channels();
+    double sum      = 0.0;
 
-    float* eigenValues = new float[2];
+    if(a.depth() == CV_8U && b.depth() == CV_8U) {
+        for(int y = 0; y < a.rows; ++y) {
+            sum += DistanceKernels::sumSquaredDifferences(a.ptr<uchar>(y), b.ptr<uchar>(y), width);
+        }
+    } else if(a.depth() == CV_32F && b.depth() == CV_32F) {
+        for(int y = 0; y < a.rows; ++y) {
+            sum += DistanceKernels::sumSquaredDifferences(a.ptr<float>(y), b.ptr<float>(y), width);
+        }
+    } else {
+        float* scratch = ScratchArena::floats(2 * width);
+        Mat rowA(1, width, CV_32FC1, scratch);
+        Mat rowB(1, width, CV_32FC1, scratch + width);
+        for(int y = 0; y < a.rows; ++y) {
+            a.row(y).reshape(1, 1).convertTo(rowA, CV_32F);
+            b.row(y).reshape(1, 1).convertTo(rowB, CV_32F);
+            sum += DistanceKernels::sumSquaredDifferences(scratch, scratch + width, width);
+        }
+    }
 
-    float* projectedTestFace = new float;
+    return sum;
+}
 
-    CvSize size = cvSize(img1->width, img1->height);
+float Eigenfaces::EigenfacesPriv::eigen(IplImage* img1, IplImage* img2) {
+    return (float)(sumSquaredDifferences(img1, img2) / 2.0);
+}
 
-    //Set PCA's termination criterion
-    CvTermCriteria mycrit = cvTermCriteria(CV_TERMCRIT_NUMBER, 1, 0);
+double Eigenfaces::EigenfacesPriv::rms(const IplImage* img1, const IplImage* img2) {
+    const double count = (double)img1->width * img1->height * img1->nChannels;
+    return sqrt(sumSquaredDifferences(img1, img2) / count);
+}
 
-    // Initialize pointer to the average image
-    IplImage* pAvgTrainImg;
-    // allocate it
-    if(!(pAvgTrainImg = cvCreateImage( size, IPL_DEPTH_32F, 1))) {
-        LOG(libfaceERROR) << "Problems initializing pAvgTrainImg...";
+float Eigenfaces::EigenfacesPriv::threshold() const {
+    switch(m_gallery.matchingOptions().distance) {
+    case DistanceMahalanobis:
+        return MAHALANOBIS_THRESHOLD;
+    case DistanceCosine:
+        return COSINE_THRESHOLD;
+    default:
+        return THRESHOLD;
     }
+}
 
-    // Initialise pointer to the pointers with eigen objects
-    IplImage** eigenObjects = new IplImage*[2];
-    // allocate it
-    for(int i = 0; i < 2; i++ ){
-        eigenObjects[i] = cvCreateImage( size, IPL_DEPTH_32F, 1);
-        if(!(eigenObjects[i])) {
-            LOG(libfaceERROR) << "Problems initializing eigenObjects";
-        }
+Mat Eigenfaces::EigenfacesPriv::project(const IplImage* img) const {
+    if(m_eigenvectors.empty() || m_mean.empty()) {
+        return Mat();
     }
 
-    // Perform PCA
-#ifdef tempFaces_as_vector
-    cvCalcEigenObjects(2, &tempFaces.front(), eigenObjects,
-                       CV_EIGOBJ_NO_CALLBACK, 0, NULL, &mycrit, pAvgTrainImg, eigenValues);
-#else
-    cvCalcEigenObjects(2, tempFaces, eigenObjects,
-                       CV_EIGOBJ_NO_CALLBACK, 0, NULL, &mycrit, pAvgTrainImg, eigenValues);
-#endif
-
-    // This is a simple min distance mechanism for recognition. Perhaps we should check similarity of images.
-    if(eigenValues[0] < minDist) {
-        minDist = eigenValues[0];
+    Mat test = cvarrToMat(img);
+    if((int)test.total() != m_mean.cols) {
+        LOG(libfaceERROR) << "Face of " << test.total() << " pixels does not match the eigenspace of dimension " << m_mean.cols << ".";
+        return Mat();
     }
 
-    delete projectedTestFace;
-    delete[] eigenValues;
-    cvReleaseImage(&pAvgTrainImg);
-    cvReleaseImage(&eigenObjects[0]);
-    cvReleaseImage(&eigenObjects[1]);
-    delete[] eigenObjects;
-
-    return minDist;
-
-#else
+    if(!test.isContinuous()) {
+        // rows of IplImages may be padded
+        test = test.clone();
+    }
 
-    float minDist = FLT_MAX;
+    Mat row;
+    test.reshape(1, 1).convertTo(row, m_mean.type());
+    return subspaceProject(m_matchVectors, m_mean, row);
+}
 
-    vector<IplImage*> tempFaces;
-    tempFaces.push_back(img1);
-    tempFaces.push_back(img2);
+void Eigenfaces::EigenfacesPriv::trained(double energy) {
+    // the gallery was filled again with plain projections
+    m_weights.release();
 
-    // Initialize array with eigen values
-    float* eigenValues;
+    m_samples  = m_gallery.size();
+    m_residual = energy < 0.0 ? -1.0 : 0.0;
 
-    // allocate it
-    if( !(eigenValues = (float*) cvAlloc( 2*sizeof(float) ) ) ) {
-        LOG(libfaceERROR) << "Problems initializing eigenValues...";
+    if(energy > 0.0) {
+        double explained = 0.0;
+        for(int i = 0; i < m_gallery.size(); ++i) {
+            double length = norm(m_gallery.projection(i));
+            explained    += length * length;
+        }
+        m_residual = std::max(0.0, 1.0 - explained / energy);
     }
 
-    float* projectedTestFace = (float*)malloc(sizeof(float));
+    m_pending.release();
+    m_pendingRows.clear();
+    m_pendingResidual = 0.0;
+    m_pendingEnergy   = 0.0;
 
-    CvSize size = cvSize(tempFaces.at(0)->width, tempFaces.at(0)->height);
+    applyMetric();
+}
 
-    //Set PCA's termination criterion
-    CvTermCriteria mycrit = cvTermCriteria(CV_TERMCRIT_NUMBER,1,0);
+int Eigenfaces::EigenfacesPriv::recoverEigenvalues() {
+    const int k = m_eigenvectors.cols;
 
-    // Initialize pointer to the average image
-    IplImage* pAvgTrainImg;
-    // allocate it
-    if( !(pAvgTrainImg = cvCreateImage( size, IPL_DEPTH_32F, 1) ) ) {
-        LOG(libfaceERROR) << "Problems initializing pAvgTrainImg...";
+    // the faces the model was built from, the pending ones are added by the next update
+    vector<bool> pending(m_gallery.size(), false);
+    for(unsigned i = 0; i < m_pendingRows.size(); ++i) {
+        pending[m_pendingRows[i]] = true;
     }
-
-    // Initialise pointer to the pointers with eigen objects
-    IplImage** eigenObjects = new IplImage *[2];
-    // allocate it
-    for(int i = 0; i < 2; i++ ){
-        eigenObjects[i] = cvCreateImage( size, IPL_DEPTH_32F, 1 );
-        if(!(eigenObjects[i] ) ) {
-            LOG(libfaceERROR) << "Problems initializing eigenObjects";
+    int prior = 0;
+    for(int i = 0; i < m_gallery.size(); ++i) {
+        if(!m_gallery.removed(i) && !pending[i]) {
+            ++prior;
         }
     }
-
-    // Perform PCA
-    cvCalcEigenObjects(2, &tempFaces.front(), eigenObjects,
-                       CV_EIGOBJ_NO_CALLBACK, 0, NULL, &mycrit, pAvgTrainImg, eigenValues );
-
-
-
-
-    // This is a simple min distance mechanism for recognition. Perhaps we should check similarity of images.
-
-    /**
-     * Scope of Improvement - 1, Change the distance mechanism -----------------------------------------------------
-     */
-
-    if(eigenValues[0] < minDist) {
-        minDist = eigenValues[0];
+    const int samples = m_samples > 0 ? m_samples : prior;
+
+    // eigenvalues are not saved with the model, the gallery is centred in the eigenspace and gives them back
+    if((int)m_eigenvalues.total() != k) {
+        m_eigenvalues = Mat::zeros(k, 1, CV_64F);
+        for(int i = 0; i < m_gallery.size(); ++i) {
+            if(m_gallery.removed(i) || pending[i]) {
+                continue;
+            }
+            Mat p = m_gallery.projection(i);
+            for(int j = 0; j < k; ++j) {
+                m_eigenvalues.at<double>(j) += (double)p.at<float>(j) * p.at<float>(j);
+            }
+        }
+        m_eigenvalues /= std::max(1, samples);
     }
+    return samples;
+}
 
-    //cvEigenDecomposite(tempFaces.at(0), nEigens, eigenObjects,
-    //CV_EIGOBJ_NO_CALLBACK, NULL, pAvgTrainImg, projectedTestFace );
-
-    //IplImage *proj = cvCreateImage(cvSize(input->width, input->height), IPL_DEPTH_8U, 1);
-    //cvEigenProjection(eigenObjects, nEigens,
-    //              CV_EIGOBJ_NO_CALLBACK, NULL, projectedTestFace, pAvgTrainImg, proj);
+void Eigenfaces::EigenfacesPriv::applyMetric() {
+    m_matchVectors = m_eigenvectors;
+    if(m_gallery.matchingOptions().distance == DistanceEuclidean || m_eigenvectors.empty() || !m_weights.empty()) {
+        return;
+    }
 
-    //LibFaceUtils::showImage(proj);
+    const int k = m_eigenvectors.cols;
+    recoverEigenvalues();
+    Mat values;
+    m_eigenvalues.convertTo(values, CV_64F);
 
-    free(projectedTestFace);
-    cvFree_(eigenValues);
-    cvReleaseImage(&pAvgTrainImg);
-    cvReleaseImage(&eigenObjects[0]);
-    cvReleaseImage(&eigenObjects[1]);
-    delete[] eigenObjects;
+    // components without variance would only amplify rounding
+    double largest = 0.0;
+    minMaxLoc(values, 0, &largest);
+    const double floor = largest > 0.0 ? largest * 1e-6 : 1.0;
 
-    // Calling clear is actually not necessary, tempFaces will be destructed on return.
-    // The images pointed to in tempFaces are owned by the calling function and may not be released here (which clear would not do).
-    //tempFaces.clear();
+    m_weights.create(1, k, CV_64F);
+    for(int j = 0; j < k; ++j) {
+        m_weights.at<double>(j) = 1.0 / sqrt(std::max(values.at<double>(j), floor));
+    }
 
-    return minDist;
-#endif
+    // a query costs the same projection as before, the gallery is scaled once
+    Mat vectors;
+    m_eigenvectors.convertTo(vectors, CV_64F);
+    for(int j = 0; j < k; ++j) {
+        Mat column = vectors.col(j);
+        column    *= m_weights.at<double>(j);
+    }
+    vectors.convertTo(m_matchVectors, m_eigenvectors.type());
+    m_gallery.scale(m_weights);
 }
 
-double Eigenfaces::EigenfacesPriv::rms(const IplImage* img1, const IplImage* img2) {
+void Eigenfaces::EigenfacesPriv::removeMetric() {
+    if(!m_weights.empty()) {
+        Mat inverse;
+        divide(Mat::ones(m_weights.rows, m_weights.cols, CV_64F), m_weights, inverse);
+        m_gallery.scale(inverse);
+        m_weights.release();
+    }
+    m_matchVectors = m_eigenvectors;
+}
 
-    IplImage* temp = cvCreateImage(cvSize(img1->width, img1->height),img1->depth,img1->nChannels);
+Mat Eigenfaces::EigenfacesPriv::toStored(const Mat& projection) const {
+    if(m_weights.empty()) {
+        return projection;
+    }
+    Mat stored;
+    projection.reshape(1, 1).convertTo(stored, CV_64F);
+    return stored.mul(m_weights);
+}
 
-    cvSub(img1, img2, temp);
+Mat Eigenfaces::EigenfacesPriv::fromStored(int index) const {
+    Mat p = m_gallery.projection(index);
+    if(m_weights.empty()) {
+        return p;
+    }
+    Mat plain;
+    divide(p, m_weights, plain, 1.0, CV_32F);
+    return plain;
+}
 
-    IplImage* temp2 = cvCreateImage(cvSize(temp->width, temp->height), temp->depth, temp->nChannels);
+void Eigenfaces::EigenfacesPriv::enroll(const Mat& face, const Mat& projection, int row) {
+    // rows of IplImages may be padded
+    Mat pixels = face.isContinuous() ? face : face.clone();
 
-    cvPow(temp, temp2, 2.0);
+    Mat x, mean;
+    pixels.reshape(1, 1).convertTo(x, CV_64F);
+    m_mean.convertTo(mean, CV_64F);
 
-    double err = cvAvg(temp2).val[0];
+    // the eigenvectors are orthonormal, so the residual is the energy minus that of the projection
+    double energy    = norm(x, mean);
+    energy          *= energy;
+    double explained = norm(projection);
+    explained       *= explained;
 
-    cvReleaseImage(&temp);
-    cvReleaseImage(&temp2);
+    m_pendingEnergy   += energy;
+    m_pendingResidual += std::max(0.0, energy - explained);
 
-    return sqrt(err);
+    Mat x32;
+    x.convertTo(x32, CV_32F);
+    m_pending.push_back(x32);
+    m_pendingRows.push_back(row);
 }
 
-void Eigenfaces::EigenfacesPriv::learn(int index, IplImage* newFace) {
-
-    int i;
-    vector<IplImage*> tempFaces;
+void Eigenfaces::EigenfacesPriv::checkDrift() {
+    if(m_pendingRows.empty()) {
+        return;
+    }
 
-    tempFaces.push_back(newFace);
-    tempFaces.push_back(faceImgArr.at(index));
+    double fraction = m_pendingEnergy > 0.0 ? m_pendingResidual / m_pendingEnergy : 0.0;
 
-    float* projectedFace = (float*)malloc(sizeof(float));
+    if(m_residual < 0.0) {
+        // a loaded model does not know how well it fits its training faces, the first window does
+        m_residual = fraction;
+        LOG(libfaceDEBUG) << "Eigenfaces : Unexplained energy of enrolled faces " << fraction << " taken as reference.";
+    } else if(fraction - m_residual > trainingOptions.driftThreshold) {
+        LOG(libfaceDEBUG) << "Eigenfaces : Unexplained energy of enrolled faces " << fraction << " against " << m_residual
+                          << " in training, updating the eigenspace.";
+        refresh();
+    }
 
-    CvSize size = cvSize(FACE_WIDTH, FACE_HEIGHT);
+    m_pending.release();
+    m_pendingRows.clear();
+    m_pendingResidual = 0.0;
+    m_pendingEnergy   = 0.0;
+}
 
-    //Set PCA's termination criterion
-    CvTermCriteria mycrit = cvTermCriteria(CV_TERMCRIT_NUMBER, 1, 0);
+int Eigenfaces::EigenfacesPriv::modelType() const {
+    return trainingOptions.doublePrecision ? CV_64FC1 : CV_32FC1;
+}
 
-    //Initialise pointer to the pointers with eigen objects
-    IplImage** eigenObjects = new IplImage *[2];
+void Eigenfaces::EigenfacesPriv::refresh() {
+    Mat oldMean, oldVectors;
+    m_mean.convertTo(oldMean, CV_64F);
+    m_eigenvectors.convertTo(oldVectors, CV_64F);
 
-    float* eigenValues;
-    //Initialize array with eigen values
-    if( !(eigenValues = (float*) cvAlloc( 2*sizeof(float) ) ) ) {
-        LOG(libfaceERROR) << "Problems initializing eigenValues..."; }
+    // the map below works on plain projections, the whitening follows the new eigenvalues
+    removeMetric();
+    int samples = recoverEigenvalues();
 
-    IplImage* pAvgTrainImg = 0;
-    //Initialize pointer to the average image
-    if( !(pAvgTrainImg = cvCreateImage( size, IPL_DEPTH_32F, 1) ) ) {
-        LOG(libfaceERROR) << "Problems initializing pAvgTrainImg..."; }
+    Mat mean, vectors, values;
+    m_eigenvalues.convertTo(values, CV_64F);
+    mean    = oldMean.clone();
+    vectors = oldVectors.clone();
 
-    for(i = 0; i < 2; i++ ) {
-        eigenObjects[i] = cvCreateImage( size, IPL_DEPTH_32F, 1 );
-        if(!(eigenObjects[i] ) ) {
-            LOG(libfaceERROR) << "Problems initializing eigenObjects"; }
+    if(IncrementalPCA::update(mean, vectors, values, samples, m_pending) != 0) {
+        applyMetric();
+        return;
     }
 
-    //Perform PCA
-    cvCalcEigenObjects(2, &tempFaces.front(), eigenObjects,
-                       CV_EIGOBJ_NO_CALLBACK, 0, NULL, &mycrit, pAvgTrainImg, eigenValues );
-
-    cvEigenDecomposite(tempFaces.at(0), 1, eigenObjects,
-                       CV_EIGOBJ_NO_CALLBACK, NULL, pAvgTrainImg, projectedFace );
-
-    IplImage *proj = cvCreateImage(size, IPL_DEPTH_8U, 1);
-    cvEigenProjection(eigenObjects, 1,
-                      CV_EIGOBJ_NO_CALLBACK, NULL, projectedFace, pAvgTrainImg, proj);
-
-    //LibFaceUtils::showImage(proj);
+    // the update works in double, the model keeps its precision
+    mean.convertTo(m_mean, modelType());
+    vectors.convertTo(m_eigenvectors, modelType());
+    m_eigenvalues  = values;
+    m_samples      = samples;
+
+    // earlier faces are only known by their projections: p' = p U^T U' + (m - m') U'
+    Mat matrix, offset;
+    gemm(oldVectors, vectors, 1.0, Mat(), 0.0, matrix, GEMM_1_T);
+    gemm(oldMean - mean, vectors, 1.0, Mat(), 0.0, offset);
+    m_gallery.transform(matrix, offset);
+
+    // the enrolled faces are still at hand and are projected exactly
+    Mat batch;
+    m_pending.convertTo(batch, modelType());
+    for(int i = 0; i < batch.rows; ++i) {
+        m_gallery.set(m_pendingRows[i], subspaceProject(m_eigenvectors, m_mean, batch.row(i)));
+    }
 
-    cvReleaseImage(&faceImgArr.at(index));
-    faceImgArr.at(index) = proj;
+    applyMetric();
+}
 
-    //free other stuff allocated above.
-    cvFree_(eigenValues);
-    free(projectedFace);
+int Eigenfaces::EigenfacesPriv::forget(int id) {
+    int released = 0;
+    for(int j = (int)std::min(faceImgArr.size(), indexMap.size()) - 1; j >= 0; --j) {
+        if(indexMap[j] == id) {
+            cvReleaseImage(&faceImgArr[j]);
+            faceImgArr.erase(faceImgArr.begin() + j);
+            indexMap.erase(indexMap.begin() + j);
+            ++released;
+        }
+    }
+    return released;
+}
 
-    cvReleaseImage(&pAvgTrainImg);
-    cvReleaseImage(&eigenObjects[0]);
-    cvReleaseImage(&eigenObjects[1]);
-    delete[] eigenObjects;
+void Eigenfaces::EigenfacesPriv::compact(bool force) {
+    const int removed = m_gallery.removedCount();
+    if(removed == 0 || (!force && removed * 4 <= m_gallery.size())) {
+        return;
+    }
 
+    vector<int> remap;
+    m_gallery.compact(remap);
+    for(unsigned i = 0; i < m_pendingRows.size(); ++i) {
+        m_pendingRows[i] = remap[m_pendingRows[i]];
+    }
 }
 
 Eigenfaces::Eigenfaces(const string& dir, Identifier id_type) : d(new EigenfacesPriv) {
@@ -529,41 +740,43 @@ int Eigenfaces::loadConfig(const string& dir) {
     d->FACE_WIDTH = cvReadIntByName(fileStorage, 0, "FACE_WIDTH",d->FACE_WIDTH);
     d->FACE_HEIGHT = cvReadIntByName(fileStorage, 0, "FACE_HEIGHT",d->FACE_HEIGHT);
     d->THRESHOLD = cvReadRealByName(fileStorage, 0, "THRESHOLD", d->THRESHOLD);
+    d->MAHALANOBIS_THRESHOLD = cvReadRealByName(fileStorage, 0, "MAHALANOBIS_THRESHOLD", d->MAHALANOBIS_THRESHOLD);
+    d->COSINE_THRESHOLD = cvReadRealByName(fileStorage, 0, "COSINE_THRESHOLD", d->COSINE_THRESHOLD);
 //    LibFaceUtils::printMatrix(d->projectedTrainFaceMat);
 
-    // If m_projections or m_labels are not empty make them empty
-    while(d->m_projections.size()) d->m_projections.pop_back();
-    while(d->m_labels.size()) d->m_labels.pop_back();
-
-    cout << "projection size: " << d->m_projections.size() << endl;
-    cout << "label size: " << d->m_labels.size() << endl;
+    d->m_gallery.clear();
+    d->m_gallery.reserve(nIds);
 
     for ( i = 0; i < nIds; i++ ) {
-        char facename[200];
+        char facename[200], idname[200];
         sprintf(facename, "person_%d", i);
+        sprintf(idname, "id_%d", i);
         IplImage* tmp = (IplImage*)cvReadByName(fileStorage, 0, facename, 0);
-        d->m_projections.push_back(cvarrToMat(tmp));
+        d->m_gallery.add(cvarrToMat(tmp), cvReadIntByName(fileStorage, 0, idname, 0));
+        cvReleaseImage(&tmp);
     }
 
     char eigen_name[20];
     sprintf(eigen_name,"eigenvector");
     IplImage* eigen_tmp = (IplImage*)cvReadByName(fileStorage, 0, eigen_name, 0);
-    d->m_eigenvectors = cvarrToMat(eigen_tmp);
+    cvarrToMat(eigen_tmp).convertTo(d->m_eigenvectors, d->modelType());
 
     char mean_name[20];
     sprintf(mean_name,"mean");
     IplImage* mean_tmp = (IplImage*)cvReadByName(fileStorage, 0, mean_name, 0);
-    d->m_mean = cvarrToMat(mean_tmp);
-
-    for ( i = 0; i < nIds; i++ ) {
-        char idname[200];
-        sprintf(idname, "id_%d", i);
-        d->m_labels.push_back(cvReadIntByName(fileStorage, 0, idname, 0));
-    }
+    cvarrToMat(mean_tmp).convertTo(d->m_mean, d->modelType());
+    cvReleaseImage(&eigen_tmp);
+    cvReleaseImage(&mean_tmp);
 
     // Release file storage
     cvReleaseFileStorage(&fileStorage);
 
+    d->m_eigenvalues.release();
+    d->trained(-1.0);
+
+    // the approximate index is optional, it is rebuilt when missing
+    d->m_gallery.loadIndex(d->configFile + ".hnsw");
+
     return 0;
 }
 
@@ -575,26 +788,21 @@ int Eigenfaces::loadConfig(const map<string, string>& c) {
 
     int nIds  = atoi(config["nIds"].c_str()), i;
 
-    // If m_projections or m_labels are not empty make them empty
-    while(d->m_projections.size()) d->m_projections.pop_back();
-    while(d->m_labels.size()) d->m_labels.pop_back();
+    d->m_gallery.clear();
+    d->m_gallery.reserve(nIds);
 
     // Not sure what depth and # of channels should be in faceImgArr. Store them in config?
     for ( i = 0; i < nIds; i++ ) {
-        char facename[200];
+        char facename[200], idname[200];
         sprintf(facename, "person_%d", i);
+        sprintf(idname, "id_%d", i);
         IplImage* tmp = LibFaceUtils::stringToImage(config[string(facename)], IPL_DEPTH_32F, 1);
-        d->m_projections.push_back(cvarrToMat(tmp));
-
-        //d->faceImgArr.push_back( LibFaceUtils::stringToImage(config[string(facename)], IPL_DEPTH_32F, 1) );
+        d->m_gallery.add(cvarrToMat(tmp), atoi(config[string(idname)].c_str()));
+        cvReleaseImage(&tmp);
     }
 
-    for ( i = 0; i < nIds; i++ ) {
-        char idname[200];
-        sprintf(idname, "id_%d", i);
-        d->m_labels.push_back(atoi(config[string(idname)].c_str()));
-//        d->indexMap.push_back( atoi(config[string(idname)].c_str()));
-    }
+    d->m_eigenvalues.release();
+    d->trained(-1.0);
 
     return 0;
 }
@@ -607,17 +815,37 @@ pair<int, float> Eigenfaces::recognize(IplImage* input) {
     }
 
     float minDist = FLT_MAX;
+    float limit   = d->THRESHOLD;
     int id = -1;
     clock_t recog = clock();
     size_t j;
 
-    for( j = 0; j < d->faceImgArr.size(); j++) {
+    if(!d->m_eigenvectors.empty() && d->m_gallery.size() > 0) {
+        // Project once and compare in the eigenspace. For two images a and b the two-image PCA of
+        // eigen() gives |a-b|^2/2, so the distance is reported on that scale and THRESHOLD keeps its
+        // meaning. The other distance modes have a threshold of their own.
+        limit = d->threshold();
+        Mat q = d->project(input);
+        if(q.empty()) {
+            return make_pair<int, float>(-1, -1);
+        }
+
+        float squaredDistance = 0;
+        int nearest           = d->m_gallery.nearest(q, &squaredDistance);
+        if(nearest >= 0) {
+            minDist = squaredDistance / 2.0f;
+            id      = d->m_gallery.label(nearest);
+        }
+    } else {
+        // Not trained, compare with every stored face
+        for( j = 0; j < d->faceImgArr.size(); j++) {
 
-        float err = d->eigen(input, d->faceImgArr.at(j));
+            float err = d->eigen(input, d->faceImgArr.at(j));
 
-        if(err < minDist) {
-            minDist = err;
-            id = j;
+            if(err < minDist) {
+                minDist = err;
+                id = j;
+            }
         }
     }
 
@@ -627,9 +855,9 @@ pair<int, float> Eigenfaces::recognize(IplImage* input) {
 
     cout << "Distance: " << minDist << endl;
 
-    if(minDist > d->THRESHOLD) {
+    if(minDist > limit) {
 
-        LOG(libfaceDEBUG) << "The value of minDist (" << minDist << ") is above the threshold (" << d->THRESHOLD << ").";
+        LOG(libfaceDEBUG) << "The value of minDist (" << minDist << ") is above the threshold (" << limit << ").";
 
         id = -1;
         minDist = -1;
@@ -643,32 +871,32 @@ pair<int, float> Eigenfaces::recognize(IplImage* input) {
 
 
 /**
-  * New Addition
-  */
-static Mat convertToRowMatrix(InputArray src, int matrix_type, double alpha=1, double beta=0)
-{
-    // number of samples in the InputArray
-    int num_of_samples = (int) src.total();
-
-    // if there is no data in InputArray, return an empty matrix
-    if(num_of_samples == 0) return Mat();
-
-    // dimensionality of samples
-    int dimension = (int)src.getMat(0).total();
-
-    // create data matrix
-    Mat data(num_of_samples, dimension, matrix_type);
-
-    // copy data
-    for(int i = 0; i < num_of_samples; i++) {
-        Mat x_i = data.row(i);
-        src.getMat(i).reshape(1, 1).convertTo(x_i, matrix_type, alpha, beta);
+ * Smallest number of leading components whose eigenvalues add up to a fraction of the total.
+ *
+ * @param eigenvalues All eigenvalues in decreasing order.
+ * @param energy The fraction of the total.
+ * @param cap Most components, 0 for no limit.
+ */
+static int componentsForEnergy(const Mat& eigenvalues, double energy, int cap) {
+    const int n  = (int)eigenvalues.total();
+    double total = sum(eigenvalues)[0];
+
+    int k           = n;
+    double captured = 0.0;
+    for(int i = 0; i < n; ++i) {
+        captured += eigenvalues.at<double>(i);
+        if(captured >= energy * total) {
+            k = i + 1;
+            break;
+        }
     }
 
-    return data;
+    if(cap > 0 && k > cap) {
+        k = cap;
+    }
+    return std::max(1, k);
 }
 
-
 /**********************************************************************************/
 void Eigenfaces::training(vector<Face*>* faces, int no_principal_components){
 
@@ -700,40 +928,192 @@ void Eigenfaces::training(vector<Face*>* faces, int no_principal_components){
     d->FACE_WIDTH = calc.rows;
     d->FACE_HEIGHT = calc.cols;
 
-    Mat data = convertToRowMatrix(src, CV_64FC1);
+    int n = size;
+    int dimension = (int)calc.total();
 
-    int n = data.rows;
+    assert(no_principal_components >= 0);
+    no_principal_components > n ? no_principal_components = n : true;
 
-    if(n != labels.size()) {
-        string error_message = format("The number of samples (src) must equal the number of labels (labels). Was len(samples)=%d, len(labels)=%d.", n, labels.size());
-        error(cv::Exception(CV_StsBadArg, error_message,  "cv::Eigenfaces::train", __FILE__, __LINE__));
+    const TrainingOptions& options = d->trainingOptions;
+
+    // without a number of components, the energy target picks it from the full decomposition
+    if(options.maxComponents > 0 && (no_principal_components > options.maxComponents || (no_principal_components == 0 && options.energy <= 0.0))) {
+        no_principal_components = std::min(options.maxComponents, n);
     }
+    const bool byEnergy = no_principal_components == 0 && options.energy > 0.0;
+    bool randomized = options.solver == PCARandomized ||
+                      (options.solver == PCAAutomatic && RandomizedPCA::preferred(n, dimension, no_principal_components, options.oversampling));
+
+    d->m_gallery.clear();
+    d->m_gallery.reserve(n);
+
+    ThreadPool pool(options.threads);
+    double energy = 0.0;
+
+    // single precision halves the memory of the data matrix and the time of every product with it
+    const int type = d->modelType();
+
+    if(randomized && no_principal_components > 0) {
+        Mat data = LibFaceUtils::rowMatrix(src, type, pool);
+        Mat projections;
+        PCA pca = RandomizedPCA::compute(data, no_principal_components, options.oversampling, options.powerIterations, &projections);
+        energy  = norm(data);
+        energy *= energy;
+
+        pca.mean.reshape(1,1).convertTo(d->m_mean, type);
+        pca.eigenvalues.convertTo(d->m_eigenvalues, CV_64FC1);
+        Mat eigenvectors;
+        transpose(pca.eigenvectors, eigenvectors);
+        eigenvectors.convertTo(d->m_eigenvectors, type);
+
+        for(int sampleIdx = 0; sampleIdx < n; sampleIdx++){
+            d->m_gallery.add(projections.row(sampleIdx), labels[sampleIdx]);
+        }
+    } else {
+        Mat data = LibFaceUtils::rowMatrix(src, type, pool);
 
-    assert(no_principal_components >= 0);
-    no_principal_components > n ? no_principal_components = n : true;
+        // calculate PCA, in the precision of the data
+        PCA pca(data, Mat(), CV_PCA_DATA_AS_ROW, no_principal_components);
 
-    // calculate PCA
-    PCA pca(data, Mat(), CV_PCA_DATA_AS_ROW, no_principal_components);
+        Mat eigenvalues;
+        pca.eigenvalues.convertTo(eigenvalues, CV_64FC1);
 
-    // copy the PCA results
-    d->m_mean = pca.mean.reshape(1,1); // store the mean vector
-    d->m_eigenvalues = pca.eigenvalues.clone(); // eigenvalues by row
-    transpose(pca.eigenvectors, d->m_eigenvectors); // eigenvectors by column
-    d->m_labels = labels; // store labels for prediction
+        // drop the components beyond the energy target, they only slow down projection and matching
+        int components = pca.eigenvectors.rows;
+        if(byEnergy) {
+            components = componentsForEnergy(eigenvalues, options.energy, options.maxComponents);
+            LOG(libfaceDEBUG) << "Eigenfaces : Keeping " << components << " of " << pca.eigenvectors.rows
+                              << " components for " << options.energy << " of the variance.";
+        }
 
-    // save projections
-    for(int sampleIdx = 0; sampleIdx < data.rows; sampleIdx++){
-        Mat p = subspaceProject(d->m_eigenvectors, d->m_mean, data.row(sampleIdx));
-        d->m_projections.push_back(p);
+        // copy the PCA results
+        d->m_mean = pca.mean.reshape(1,1); // store the mean vector
+        d->m_eigenvalues = eigenvalues.rowRange(0, components).clone(); // eigenvalues by row
+        transpose(pca.eigenvectors.rowRange(0, components), d->m_eigenvectors); // eigenvectors by column
+
+        // save projections with their labels for prediction
+        Mat projections = LibFaceUtils::projectRows(data, d->m_eigenvectors, d->m_mean, pool);
+        for(int sampleIdx = 0; sampleIdx < data.rows; sampleIdx++){
+            d->m_gallery.add(projections.row(sampleIdx), labels[sampleIdx]);
+            double distance = norm(data.row(sampleIdx), d->m_mean);
+            energy += distance * distance;
+        }
     }
 
+    d->trained(energy);
+
     update = clock() - update;
     printf("Whole Process took: %f sec.\n", (double)update / ((double)CLOCKS_PER_SEC));
 
-    cout << "Projection Size: " << d->m_projections.size() << endl;
+    cout << "Projection Size: " << d->m_gallery.size() << endl;
     cout << "Eigenface - Training Done " << endl;
 }
 
+/**
+ * Reads up to rows faces of the given dimension from a stream into the rows of batch.
+ *
+ * @return Number of faces read, 0 at the end of the stream.
+ */
+static int readChunk(FaceStream& stream, Mat& batch, vector<int>& labels, int dimension) {
+    labels.clear();
+    Mat face;
+    int label;
+    while((int)labels.size() < batch.rows && stream.next(face, label)) {
+        if((int)face.total() != dimension || face.channels() != 1) {
+            LOG(libfaceWARNING) << "Eigenfaces : Skipping a face of size " << face.cols << "x" << face.rows << " in the training stream.";
+            continue;
+        }
+        Mat row = batch.row((int)labels.size());
+        face.reshape(1, 1).convertTo(row, CV_32FC1);
+        labels.push_back(label);
+    }
+    return (int)labels.size();
+}
+
+int Eigenfaces::trainingFromStream(FaceStream& stream, int no_principal_components) {
+    if(no_principal_components <= 0) {
+        LOG(libfaceERROR) << "Eigenfaces : Streaming training needs the number of components.";
+        return 1;
+    }
+
+    clock_t update = clock();
+
+    const TrainingOptions& options = d->trainingOptions;
+    const int chunkSize  = std::max(1, options.chunkSize);
+    const int sketchRows = options.sketchRows > 0 ? std::max(options.sketchRows, no_principal_components)
+                                                  : 2 * (no_principal_components + std::max(0, options.oversampling));
+
+    // the first face fixes the size
+    stream.rewind();
+    Mat face;
+    int label;
+    if(!stream.next(face, label)) {
+        LOG(libfaceERROR) << "Eigenfaces : The training stream is empty.";
+        return 1;
+    }
+    const int dimension = (int)face.total();
+    const int faceRows  = face.rows;
+    const int faceCols  = face.cols;
+
+    // first pass: mean and sketch of the covariance
+    StreamingPCA sketch(sketchRows);
+    Mat batch(chunkSize, dimension, CV_32FC1);
+    vector<int> labels;
+
+    stream.rewind();
+    int rows;
+    while((rows = readChunk(stream, batch, labels, dimension)) > 0) {
+        sketch.add(batch.rowRange(0, rows));
+    }
+
+    PCA pca = sketch.compute(no_principal_components);
+    if(pca.eigenvectors.empty()) {
+        LOG(libfaceERROR) << "Eigenfaces : Streaming training found no variation in the faces.";
+        return 1;
+    }
+
+    d->FACE_WIDTH  = faceRows;
+    d->FACE_HEIGHT = faceCols;
+
+    Mat eigenvectors;
+    transpose(pca.eigenvectors, eigenvectors);
+    pca.mean.reshape(1, 1).convertTo(d->m_mean, d->modelType());
+    eigenvectors.convertTo(d->m_eigenvectors, d->modelType());
+    d->m_eigenvalues = pca.eigenvalues;
+
+    // second pass: project the faces chunk by chunk
+    d->m_gallery.clear();
+    d->m_gallery.reserve(sketch.count());
+
+    // the chunks are read in single precision whatever the model
+    Mat mean32, eigenvectors32, projections;
+    double energy = 0.0;
+    d->m_mean.convertTo(mean32, CV_32FC1);
+    d->m_eigenvectors.convertTo(eigenvectors32, CV_32FC1);
+
+    stream.rewind();
+    while((rows = readChunk(stream, batch, labels, dimension)) > 0) {
+        Mat chunk = batch.rowRange(0, rows);
+        for(int i = 0; i < rows; ++i) {
+            Mat row = chunk.row(i);
+            row    -= mean32;
+        }
+        double distance = norm(chunk);
+        energy         += distance * distance;
+        gemm(chunk, eigenvectors32, 1.0, Mat(), 0.0, projections);
+        for(int i = 0; i < rows; ++i) {
+            d->m_gallery.add(projections.row(i), labels[i]);
+        }
+    }
+    d->trained(energy);
+
+    update = clock() - update;
+    LOG(libfaceDEBUG) << "Eigenfaces : Streaming training of " << d->m_gallery.size() << " faces took "
+                      << (double)update / ((double)CLOCKS_PER_SEC) << " sec.";
+
+    return 0;
+}
+
 /**
  * New Addition
  */
@@ -741,23 +1121,51 @@ int Eigenfaces::testingID(IplImage *img){
 
     cout << "in eigenfaces::testing --------------------------" << endl;
 
-    Mat test = cvarrToMat(img);
-    Mat q = subspaceProject(d->m_eigenvectors, d->m_mean, test.reshape(1,1));
-    double minDist = DBL_MAX;
-    int outputClass = -1;
+    Mat q = d->project(img);
+    if(q.empty()) {
+        return -1;
+    }
+
+    int nearest = d->m_gallery.nearest(q);
+
+    return nearest >= 0 ? d->m_gallery.label(nearest) : -1;
+}
 
+vector<int> Eigenfaces::testingIDs(const vector<IplImage*>& images) {
+    vector<int> result(images.size(), -1);
 
-    for(int i = 0; i < d->m_projections.size(); i++) {
+    vector<int> rows;
+    Mat queries = LibFaceUtils::projectImages(images, d->m_matchVectors, d->m_mean, rows);
+    if(queries.empty()) {
+        return result;
+    }
 
-        double distance = norm(d->m_projections[i], q, NORM_L2);
+    vector<int> nearest;
+    d->m_gallery.nearest(queries, nearest);
 
-        if(distance < minDist) {
-            minDist = distance;
-            outputClass = d->m_labels[i];
+    for(unsigned i = 0; i < images.size(); ++i) {
+        if(rows[i] >= 0 && nearest[rows[i]] >= 0) {
+            result[i] = d->m_gallery.label(nearest[rows[i]]);
         }
     }
 
-    return outputClass;
+    return result;
+}
+
+vector<pair<int, float> > Eigenfaces::testingTopK(IplImage* img, int k) {
+    Mat q = d->project(img);
+    if(q.empty()) {
+        return vector<pair<int, float> >();
+    }
+
+    vector<pair<int, float> > candidates = d->m_gallery.nearestLabels(q, k);
+
+    // report |a-b|^2/2 as recognize() does
+    for(unsigned i = 0; i < candidates.size(); ++i) {
+        candidates[i].second /= 2.0f;
+    }
+
+    return candidates;
 }
 
 int Eigenfaces::saveConfig(const string& dir) {
@@ -771,7 +1179,10 @@ int Eigenfaces::saveConfig(const string& dir) {
         return 1;
     }
 
-    unsigned int nIds = d->m_projections.size(), i;
+    // removed faces must not reach the file
+    d->compact(true);
+
+    unsigned int nIds = d->m_gallery.size(), i;
     cout << "Total: " << nIds << endl;
 
     // Write some initial params and matrices
@@ -779,14 +1190,17 @@ int Eigenfaces::saveConfig(const string& dir) {
     cvWriteInt( fileStorage, "FACE_WIDTH", d->FACE_WIDTH);
     cvWriteInt( fileStorage, "FACE_HEIGHT", d->FACE_HEIGHT);
     cvWriteReal( fileStorage, "THRESHOLD", d->THRESHOLD);
+    cvWriteReal( fileStorage, "MAHALANOBIS_THRESHOLD", d->MAHALANOBIS_THRESHOLD);
+    cvWriteReal( fileStorage, "COSINE_THRESHOLD", d->COSINE_THRESHOLD);
 
     // Write all the training faces
     for ( i = 0; i < nIds; i++ ) {
         char facename[200];
         sprintf(facename, "person_%d", i);
 
-        // Writing Projection Data
-        IplImage tmp = d->m_projections.at(i);
+        // Writing Projection Data, without the weights of the distance mode
+        Mat projection = d->fromStored(i);
+        IplImage tmp   = projection;
         cvWrite(fileStorage, facename, &tmp, cvAttrList(0,0));
 
         //Need to write eigenvector and mean also
@@ -806,11 +1220,13 @@ int Eigenfaces::saveConfig(const string& dir) {
     for ( i = 0; i < nIds; i++ ) {
         char idname[200];
         sprintf(idname, "id_%d", i);
-        cvWriteInt(fileStorage, idname, d->m_labels.at(i));
+        cvWriteInt(fileStorage, idname, d->m_gallery.label(i));
     }
 
     // Release the fileStorage
     cvReleaseFileStorage(&fileStorage);
+
+    d->m_gallery.saveIndex(d->configFile + ".hnsw");
     return 0;
 }
 
@@ -832,6 +1248,9 @@ int Eigenfaces::update(vector<Face*>* newFaceArr) {
             LOG(libfaceDEBUG) << "Has no specified ID.";
 
             int newId = d->faceImgArr.size();
+            while(find(d->indexMap.begin(), d->indexMap.end(), newId) != d->indexMap.end()) {
+                ++newId;    // removed IDs leave gaps
+            }
 
             // We now have the greatest unoccupied ID.
             LOG(libfaceDEBUG) << "Giving it the ID = " << newId;
@@ -851,18 +1270,40 @@ int Eigenfaces::update(vector<Face*>* newFaceArr) {
 
             vector<int>::iterator it = find(d->indexMap.begin(), d->indexMap.end(), id);//d->indexMap.
             if(it != d->indexMap.end()) {
-
-                LOG(libfaceDEBUG) << "Specified ID already exists in the DB, merging 2 together.";
-
-                d->learn(*it, cvCloneImage(newFaceArr->at(i)->getFace()));
-
+                // stored next to the known faces of the ID, which stay as they are
+                LOG(libfaceDEBUG) << "Specified ID already exists in the DB, adding the face to it.";
             } else {
                 // If this is a fresh ID, and not autoassigned
                 LOG(libfaceDEBUG) << "Specified ID does not exist in the DB, creating new face.";
+            }
+
+            d->faceImgArr.push_back(cvCloneImage(newFaceArr->at(i)->getFace()));
+            // So map it's DB storage index with it's ID
+            d->indexMap.push_back(id);
+        }
+    }
+
+    // Once trained, new faces are matched against directly in the eigenspace
+    if(!d->m_eigenvectors.empty()) {
+        vector<IplImage*> images;
+        for (unsigned i = 0; i < newFaceArr->size() ; ++i) {
+            images.push_back(newFaceArr->at(i)->getFace());
+        }
 
-                d->faceImgArr.push_back(cvCloneImage(newFaceArr->at(i)->getFace()));
-                // A new face with a new ID is added. So map it's DB storage index with it's ID
-                d->indexMap.push_back(id);
+        vector<int> rows;
+        Mat projections = LibFaceUtils::projectImages(images, d->m_eigenvectors, d->m_mean, rows);
+        const bool tracking = d->trainingOptions.driftThreshold > 0.0;
+        for (unsigned i = 0; i < newFaceArr->size() ; ++i) {
+            if(rows[i] >= 0) {
+                int row = d->m_gallery.add(d->toStored(projections.row(rows[i])), newFaceArr->at(i)->getId());
+
+                // the eigenspace follows the enrolled faces in windows of chunkSize faces
+                if(tracking && row >= 0) {
+                    d->enroll(cvarrToMat(images[i]), projections.row(rows[i]), row);
+                    if(d->m_pending.rows >= std::max(1, d->trainingOptions.chunkSize)) {
+                        d->checkDrift();
+                    }
+                }
             }
         }
     }
@@ -874,4 +1315,70 @@ int Eigenfaces::update(vector<Face*>* newFaceArr) {
     return 0;
 }
 
+int Eigenfaces::removeID(int id) {
+    int found = d->forget(id) + d->m_gallery.removeLabel(id);
+
+    // enrolled faces of the ID must not reach the next update of the eigenspace
+    if(!d->m_pendingRows.empty()) {
+        Mat pending;
+        vector<int> rows;
+        for(unsigned i = 0; i < d->m_pendingRows.size(); ++i) {
+            if(!d->m_gallery.removed(d->m_pendingRows[i])) {
+                pending.push_back(d->m_pending.row(i));
+                rows.push_back(d->m_pendingRows[i]);
+            }
+        }
+        d->m_pending     = pending;
+        d->m_pendingRows = rows;
+    }
+
+    if(found == 0) {
+        LOG(libfaceWARNING) << "Eigenfaces::removeID : No faces of ID " << id << ".";
+        return 1;
+    }
+
+    d->compact(false);
+    return 0;
+}
+
+int Eigenfaces::relabelID(int id, int newId) {
+    int found = d->m_gallery.relabel(id, newId);
+    for(unsigned j = 0; j < d->indexMap.size(); ++j) {
+        if(d->indexMap[j] == id) {
+            d->indexMap[j] = newId;
+            ++found;
+        }
+    }
+
+    if(found == 0) {
+        LOG(libfaceWARNING) << "Eigenfaces::relabelID : No faces of ID " << id << ".";
+        return 1;
+    }
+    return 0;
+}
+
+void Eigenfaces::setMatchingOptions(const MatchingOptions& options) {
+    if(options.distance == d->m_gallery.matchingOptions().distance) {
+        d->m_gallery.setMatchingOptions(options);
+        return;
+    }
+
+    // the stored projections are whitened for Mahalanobis and Cosine only
+    d->removeMetric();
+    d->m_gallery.setMatchingOptions(options);
+    d->applyMetric();
+}
+
+MatchingOptions Eigenfaces::matchingOptions() const {
+    return d->m_gallery.matchingOptions();
+}
+
+void Eigenfaces::setTrainingOptions(const TrainingOptions& options) {
+    d->trainingOptions = options;
+}
+
+TrainingOptions Eigenfaces::trainingOptions() const {
+    return d->trainingOptions;
+}
+
 } // namespace libface
@@ -123,6 +123,12 @@ public:
      * Method to attempt to compare images with the known projected images. Uses a specified type of
      * distance to see how far away they are from each of the images in the projection.
      *
+     * After training, the input is projected once into the eigenspace and compared with the stored
+     * projections; the distance is half the squared distance of the matching mode there, at most 2
+     * for DistanceCosine. It is compared with the THRESHOLD, MAHALANOBIS_THRESHOLD or COSINE_THRESHOLD
+     * entry of the config file, by mode. Without training, every stored face is compared with a
+     * two-image PCA and THRESHOLD.
+     *
      * @param input The pointer to IplImage* image, which is to be recognized.
      *
      * @return A pair with ID and closeness of the closest face.
@@ -145,8 +151,13 @@ public:
      *
      * If id is not -1 and a new id, then face is added to the end of the faces vector.
      *
-     * If id is not -1 and it already exist, then given the given faces is projected together with the
-     * known face at that position using eigen decomposition and the projected face is stored in it's place.
+     * If id is not -1 and it already exist, then the face is also added to the end of the faces vector
+     * under that id, next to its known faces, which are kept as they are.
+     *
+     * Once trained, every face is also projected into the eigenspace and can be recognized right away.
+     * The faces are collected in windows of TrainingOptions::chunkSize. If the fraction of their energy
+     * outside the eigenspace exceeds that of the training faces by more than TrainingOptions::driftThreshold,
+     * the eigenspace is updated with them by IncrementalPCA and the stored projections follow it.
      *
      * @param newFaceArr The vector of input Face objects
      *
@@ -162,6 +173,18 @@ public:
 
     void training(vector<Face*>* newFaceArr, int no_principal_components = 0);
 
+    /**
+     * Training from a stream of faces with memory independent of their number. The components are
+     * estimated from a StreamingPCA sketch in a first pass over the stream, the faces are projected
+     * in a second. TrainingOptions::chunkSize and sketchRows set the memory.
+     *
+     * @param stream The training faces, all of the same size.
+     * @param no_principal_components Number of components of the model, must be positive.
+     *
+     * @return 0 on success.
+     */
+    int trainingFromStream(FaceStream& stream, int no_principal_components);
+
     /**
      * New Addition
      * Testing phase of face recognition
@@ -169,6 +192,27 @@ public:
 
     int testingID(IplImage* img);
 
+    /**
+     * Recognizes a batch of faces. All faces are projected with one matrix product and compared with
+     * the training projections with a second one.
+     *
+     * @param images The face images to be recognized.
+     *
+     * @return The ID of the closest face for every image, -1 if its size does not match the training faces.
+     */
+    vector<int> testingIDs(const vector<IplImage*>& images);
+
+    /**
+     * Ranks the known people by the distance of their closest training face, in the same scan that
+     * testingID() does.
+     *
+     * @param img The face image to be recognized.
+     * @param k Maximum number of candidates.
+     *
+     * @return Up to k pairs of ID and distance, on the scale of recognize(), closest first.
+     */
+    vector<pair<int, float> > testingTopK(IplImage* img, int k);
+
     string testingTag(IplImage* img){
         string str;
 
@@ -177,6 +221,54 @@ public:
 
     TrainingRequirement getTrainingRequirement();
 
+    /**
+     * Forgets the faces and projections of an ID. The projections are only marked as removed, the
+     * gallery is compacted once a quarter of it is removed and before the config is saved. The
+     * eigenspace keeps what it learned from the faces until the next training.
+     *
+     * @param id The ID.
+     *
+     * @return 0 on success, 1 if the ID is unknown.
+     */
+    int removeID(int id);
+
+    /**
+     * Gives the faces and projections of an ID another one, merging them with those of newId.
+     *
+     * @param id The ID to change.
+     * @param newId Its new value.
+     *
+     * @return 0 on success, 1 if the ID is unknown.
+     */
+    int relabelID(int id, int newId);
+
+    /**
+     * Sets how the training projections are searched. With approximate matching an HNSW index is
+     * built over them and saved next to the config file. For Mahalanobis and Cosine distances the
+     * eigenvectors used for queries and the stored projections are scaled by 1/sqrt(eigenvalue).
+     *
+     * @param options The matching options.
+     */
+    void setMatchingOptions(const MatchingOptions& options);
+
+    /**
+     * @return The matching options.
+     */
+    MatchingOptions matchingOptions() const;
+
+    /**
+     * Sets how training computes the eigenspace. By default, a randomized solver is used instead of
+     * cv::PCA when few components are kept from many faces, see RandomizedPCA.
+     *
+     * @param options The training options.
+     */
+    void setTrainingOptions(const TrainingOptions& options);
+
+    /**
+     * @return The training options.
+     */
+    TrainingOptions trainingOptions() const;
+
 
 private:
 
@@ -88,6 +88,7 @@ public:
     int             x2;
     int             y2;
     int             id;
+    int             confidence;
     string          tagName;
     int             width;
     int             height;
@@ -95,9 +96,9 @@ public:
 };
 
 
-Face::FacePriv::FacePriv(int x1, int y1, int x2, int y2, int id, IplImage* face) : x1(x1), y1(y1), x2(x2), y2(y2), id(id), width(x2-x1), height(y2-y1), face(face) {}
+Face::FacePriv::FacePriv(int x1, int y1, int x2, int y2, int id, IplImage* face) : x1(x1), y1(y1), x2(x2), y2(y2), id(id), confidence(-1), width(x2-x1), height(y2-y1), face(face) {}
 
-Face::FacePriv::FacePriv(const FacePriv& that) : x1(that.x1), y1(that.y1), x2(that.x2), y2(that.y2), id(that.id), width(that.width), height(that.height), face(0) {
+Face::FacePriv::FacePriv(const FacePriv& that) : x1(that.x1), y1(that.y1), x2(that.x2), y2(that.y2), id(that.id), confidence(that.confidence), width(that.width), height(that.height), face(0) {
     if(that.face) {
         face = cvCloneImage(that.face);
     }
@@ -112,6 +113,7 @@ Face::FacePriv& Face::FacePriv::operator = (const FacePriv& that) {
     x2 = that.x2;
     y2 = that.y2;
     id = that.id;
+    confidence = that.confidence;
     width = that.width;
     height = that.height;
     if(face) {
@@ -184,6 +186,10 @@ void Face::setId(int id) {
 	d->id = id;
 }
 
+void Face::setConfidence(int confidence) {
+    d->confidence = confidence;
+}
+
 void Face::setName(string tag){
     d->tagName = tag;
 }
@@ -227,6 +233,10 @@ int Face::getId() const {
 	return d->id;
 }
 
+int Face::getConfidence() const {
+    return d->confidence;
+}
+
 string Face::getName() const{
     return d->tagName;
 }
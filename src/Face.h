@@ -133,6 +133,13 @@ public:
       */
     void setName(string tag);
 
+    /**
+     * Sets the detection confidence of the face.
+     *
+     * @param confidence Number of neighbouring detections merged into this face, -1 if not known.
+     */
+    void setConfidence(int confidence);
+
     /**
      * Sets the image of the face.
      *
@@ -196,6 +203,15 @@ public:
      */
     int getId() const;
 
+    /**
+     * Gets the detection confidence of the face. This is the number of raw detections, at
+     * neighbouring positions and scales, that were grouped into this face. Genuine faces typically
+     * collect many more than false positives, so it can be thresholded after detection.
+     *
+     * @return Confidence of the detection, -1 if not known (e.g. the face was not detected).
+     */
+    int getConfidence() const;
+
     /**
       * Gets the tagname of face
       *
@@ -37,7 +37,9 @@
 // LibFace headers
 #include "Log.h"
 #include "Face.h"
+#include "FixedPointCascade.h"
 #include "Haarcascades.h"
+#include "ImageBufferPool.h"
 #include "LibFaceUtils.h"
 
 // OpenCV headers
@@ -94,6 +96,20 @@ public:
      */
     ~FaceDetectPriv();
 
+    /**
+     * Returns the fixed point version of a cascade, converting it on first use.
+     *
+     * @param index Index of the cascade in cascadeSet.
+     *
+     * @return The converted cascade, or 0 if it cannot be evaluated in fixed point.
+     */
+    FixedPointCascade* fixedCascade(int index);
+
+    /**
+     * Deletes the fixed point cascades, e.g. because cascadeSet changed.
+     */
+    void clearFixedCascades();
+
     Haarcascades* cascadeSet;
     CvMemStorage* storage;
     double        scaleFactor;        // Keeps the scaling factor of the internal image.
@@ -106,26 +122,32 @@ public:
     // Tunable values, for accuracy
     float         searchIncrement;
     int           grouping;
+    int           groupingOverride;   // Set by setGrouping(), 0 to use grouping
     int           minSize[4];
     int           accu;
 
+    DetectionArithmetic        arithmetic;
+    vector<FixedPointCascade*> fixedCascades;   // Converted lazily, one per cascade in cascadeSet
+
+    ImageBufferPool            buffers;         // Working copies and resized images, not shared by copies
+
 };
 
-FaceDetect::FaceDetectPriv::FaceDetectPriv() : cascadeSet(0), storage(0), scaleFactor(1.0), countCertainty(true), maximumDistance(20), minimumDuplicates(1), searchIncrement(1.269F), grouping(1), accu(1) {
+FaceDetect::FaceDetectPriv::FaceDetectPriv() : cascadeSet(0), storage(0), scaleFactor(1.0), countCertainty(true), maximumDistance(20), minimumDuplicates(1), searchIncrement(1.269F), grouping(1), groupingOverride(0), accu(1), arithmetic(FloatingPoint), fixedCascades(), buffers() {
     minSize[0] = 1;
     minSize[1] = 20;
     minSize[2] = 26;
     minSize[3] = 35;
 }
 
-FaceDetect::FaceDetectPriv::FaceDetectPriv(const string& cascadeDir) : cascadeSet(new Haarcascades(cascadeDir)), storage(0), scaleFactor(1.0), countCertainty(true), maximumDistance(20), minimumDuplicates(1), searchIncrement(1.269F), grouping(1), accu(1) {
+FaceDetect::FaceDetectPriv::FaceDetectPriv(const string& cascadeDir) : cascadeSet(new Haarcascades(cascadeDir)), storage(0), scaleFactor(1.0), countCertainty(true), maximumDistance(20), minimumDuplicates(1), searchIncrement(1.269F), grouping(1), groupingOverride(0), accu(1), arithmetic(FloatingPoint), fixedCascades(), buffers() {
     minSize[0] = 1;
     minSize[1] = 20;
     minSize[2] = 26;
     minSize[3] = 35;
 }
 
-FaceDetect::FaceDetectPriv::FaceDetectPriv(const FaceDetectPriv& that) : cascadeSet(0), storage(0), scaleFactor(that.scaleFactor), countCertainty(that.countCertainty), maximumDistance(that.maximumDistance), minimumDuplicates(that.minimumDuplicates), searchIncrement(that.searchIncrement), grouping(that.grouping), accu(that.accu) {
+FaceDetect::FaceDetectPriv::FaceDetectPriv(const FaceDetectPriv& that) : cascadeSet(0), storage(0), scaleFactor(that.scaleFactor), countCertainty(that.countCertainty), maximumDistance(that.maximumDistance), minimumDuplicates(that.minimumDuplicates), searchIncrement(that.searchIncrement), grouping(that.grouping), groupingOverride(that.groupingOverride), accu(that.accu), arithmetic(that.arithmetic), fixedCascades(), buffers() {
     for(unsigned i = 0; i < 4; ++i ) {
         minSize[i] = that.minSize[i];
     }
@@ -149,7 +171,10 @@ FaceDetect::FaceDetectPriv& FaceDetect::FaceDetectPriv::operator = (const FaceDe
     minimumDuplicates = that.minimumDuplicates;
     searchIncrement = that.searchIncrement;
     grouping = that.grouping;
+    groupingOverride = that.groupingOverride;
     accu = that.accu;
+    arithmetic = that.arithmetic;
+    clearFixedCascades();
     if(that.storage) {
         // don't know how to copy storage, should not be necessary anway
         LOG(libfaceWARNING) << "FaceDetectPriv& operator = : storage is not being copied.";
@@ -169,9 +194,28 @@ FaceDetect::FaceDetectPriv::~FaceDetectPriv() {
         // storage should already have been released, but let's double check
         cvReleaseMemStorage(&storage);
     }
+    clearFixedCascades();
     delete cascadeSet;
 }
 
+FixedPointCascade* FaceDetect::FaceDetectPriv::fixedCascade(int index) {
+    if((int)fixedCascades.size() != cascadeSet->getSize()) {
+        clearFixedCascades();
+        fixedCascades.resize(cascadeSet->getSize(), 0);
+    }
+    if(!fixedCascades[index]) {
+        fixedCascades[index] = new FixedPointCascade(cascadeSet->getCascade(index).haarcasc);
+    }
+    return fixedCascades[index]->isValid() ? fixedCascades[index] : 0;
+}
+
+void FaceDetect::FaceDetectPriv::clearFixedCascades() {
+    for(unsigned i = 0; i < fixedCascades.size(); ++i) {
+        delete fixedCascades.at(i);
+    }
+    fixedCascades.clear();
+}
+
 FaceDetect::FaceDetect(const string& cascadeDir) : d(new FaceDetectPriv(cascadeDir)) {
 
     /* Cascades */
@@ -273,7 +317,41 @@ void FaceDetect::setAccuracy(int i) {
     };
 }
 
-vector<Face*>* FaceDetect::cascadeResult(const IplImage* inputImage, CvHaarClassifierCascade* casc, CvSize faceSize) {
+int FaceDetect::grouping() const {
+    return d->groupingOverride;
+}
+
+void FaceDetect::setGrouping(int value) {
+    if(value < 0) {
+        LOG(libfaceWARNING) << "Bad grouping value";
+        return;
+    }
+    d->groupingOverride = value;
+}
+
+DetectionArithmetic FaceDetect::arithmetic() const {
+    return d->arithmetic;
+}
+
+void FaceDetect::setArithmetic(DetectionArithmetic value) {
+    d->arithmetic = value;
+}
+
+ImageBufferStats FaceDetect::bufferStats() const {
+    return d->buffers.stats();
+}
+
+vector<Face*> FaceDetect::selectConfident(const vector<Face*>& faces, int minConfidence) {
+    vector<Face*> result;
+    for(unsigned i = 0; i < faces.size(); ++i) {
+        if(faces.at(i)->getConfidence() >= minConfidence) {
+            result.push_back(faces.at(i));
+        }
+    }
+    return result;
+}
+
+vector<Face*>* FaceDetect::cascadeResult(const IplImage* inputImage, CvHaarClassifierCascade* casc, FixedPointCascade* fixedCasc, CvSize faceSize) {
     // Clear the memory d->storage which was used before
     cvClearMemStorage(d->storage);
 
@@ -300,23 +378,33 @@ vector<Face*>* FaceDetect::cascadeResult(const IplImage* inputImage, CvHaarClass
 
         detect = clock();
 
-        faces = cvHaarDetectObjects(inputImage,
-                casc,
-                d->storage,
-                d->searchIncrement,             // Increase search scale by 5% everytime
-                d->grouping,                    // Drop groups of less than 2 detections
-                CV_HAAR_DO_CANNY_PRUNING,
-                faceSize                        // Minimum face size to look for
-        );
+        int minNeighbours = d->groupingOverride > 0 ? d->groupingOverride : d->grouping;   // Drop groups with too few neighbours
+
+        // The detections as CvAvgComp, the rectangle followed by its number of grouped neighbours
+        vector<CvAvgComp> comps;
+        if(fixedCasc) {
+            comps = fixedCasc->detectObjects(inputImage, d->searchIncrement, minNeighbours, faceSize);
+        } else {
+            faces = cvHaarDetectObjects(inputImage,
+                    casc,
+                    d->storage,
+                    d->searchIncrement,             // Increase search scale by 5% everytime
+                    minNeighbours,
+                    CV_HAAR_DO_CANNY_PRUNING,
+                    faceSize                        // Minimum face size to look for
+            );
+            for (int i = 0; i < (faces ? faces->total : 0); i++) {
+                comps.push_back(*(CvAvgComp*) cvGetSeqElem(faces, i));
+            }
+        }
 
         detect = clock() - detect;
         LOG(libfaceDEBUG) << "Detection took: " << (double)detect / ((double)CLOCKS_PER_SEC) << "sec.";
 
         // Loop the number of faces found.
-        for (int i = 0; i < (faces ? faces->total : 0); i++) {
+        for (unsigned i = 0; i < comps.size(); i++) {
             // Create a new rectangle for drawing the face
-
-            CvRect* roi = (CvRect*) cvGetSeqElem(faces, i);
+            const CvRect* roi = &comps[i].rect;
 
             // Find the dimensions of the face,and scale it if necessary.
             float boxShrink = 0.1;
@@ -336,6 +424,7 @@ vector<Face*>* FaceDetect::cascadeResult(const IplImage* inputImage, CvHaarClass
             pt2.y = pt2.y - (int)(height*boxShrink);
 
             Face* face = new Face(pt1.x,pt1.y,pt2.x,pt2.y);
+            face->setConfidence(comps[i].neighbors);
 
             result->push_back(face);
         }
@@ -432,7 +521,7 @@ vector<Face*>* FaceDetect::detectFaces(const IplImage* inputImage) {
         return new vector<Face*>();
     }
 
-    IplImage* imgCopy = cvCloneImage(inputImage);
+    IplImage* imgCopy = d->buffers.clone(inputImage);
     clock_t init, final;
 
     init           = clock();
@@ -448,21 +537,21 @@ vector<Face*>* FaceDetect::detectFaces(const IplImage* inputImage) {
     LOG(libfaceDEBUG) << "Input area:" << inputArea;
 
     if (inputArea > 7000000) {
-        temp = libface::LibFaceUtils::resizeToArea(inputImage, 786432, d->scaleFactor);
+        temp = libface::LibFaceUtils::resizeToArea(inputImage, 786432, d->scaleFactor, d->buffers);
 
         LOG(libfaceDEBUG) << "Image scaled to 786432 pixels.";
 
         this->setAccuracy(3);
     }
     else if (inputArea > 5000000) {
-        temp = libface::LibFaceUtils::resizeToArea(inputImage, 786432, d->scaleFactor);
+        temp = libface::LibFaceUtils::resizeToArea(inputImage, 786432, d->scaleFactor, d->buffers);
 
         LOG(libfaceDEBUG) << "Image scaled to 786432 pixels.";
 
         this->setAccuracy(2);
     }
     else if (inputArea > 2000000) {
-        temp = libface::LibFaceUtils::resizeToArea(inputImage, 786432, d->scaleFactor);
+        temp = libface::LibFaceUtils::resizeToArea(inputImage, 786432, d->scaleFactor, d->buffers);
 
         LOG(libfaceDEBUG) << "Image scaled to 786432 pixels.";
 
@@ -484,12 +573,14 @@ vector<Face*>* FaceDetect::detectFaces(const IplImage* inputImage) {
     d->storage = cvCreateMemStorage(0);
 
     for (int i = 0; i < d->cascadeSet->getSize(); ++i) {
-        IplImage* constTemp = temp ? temp : cvCloneImage(inputImage);
-        faces               = this->cascadeResult(constTemp, d->cascadeSet->getCascade(i).haarcasc, cvSize(faceSize,faceSize));
-        // By releasing constTemp, either temp or the above created clone is released.
-        cvReleaseImage(&constTemp);
+        // The working copy is only read, so it does not need to be cloned again for every cascade
+        const IplImage* constTemp    = temp ? temp : imgCopy;
+        FixedPointCascade* fixedCasc = d->arithmetic == FixedPoint ? d->fixedCascade(i) : 0;
+        faces               = this->cascadeResult(constTemp, d->cascadeSet->getCascade(i).haarcasc, fixedCasc, cvSize(faceSize,faceSize));
     }
 
+    d->buffers.release(&temp);
+
     cvReleaseMemStorage(&d->storage);
 
     final = clock()-init;
@@ -511,7 +602,7 @@ vector<Face*>* FaceDetect::detectFaces(const IplImage* inputImage) {
         faces->at(i)->setFace(roiImg);
     }
 
-    cvReleaseImage(&imgCopy);
+    d->buffers.release(&imgCopy);
 
     return faces;
 }
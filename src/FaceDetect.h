@@ -36,6 +36,7 @@
 
 // LibFace headers
 #include "LibFaceCore.h"
+#include "ImageBufferPool.h"
 
 // OpenCV headers
 #if defined (__APPLE__)
@@ -53,6 +54,7 @@ namespace libface
 
 // forward declaration
 class Face;
+class FixedPointCascade;
 
 class FACEAPI FaceDetect : public LibFaceDetectCore
 {
@@ -121,6 +123,58 @@ public:
      */
     void setAccuracy(int value);
 
+    /**
+     * Get the grouping threshold set with setGrouping().
+     *
+     * @return Minimum number of neighbours for a detection, 0 if the accuracy level decides.
+     */
+    int grouping() const;
+
+    /**
+     * Set the minimum number of neighbouring raw detections a face needs to be reported, overriding
+     * the value chosen by the accuracy level. Every detected face carries its neighbour count as
+     * Face::getConfidence(), so a single pass with a low value (e.g. 1) can serve several precision
+     * targets through selectConfident(), instead of detecting again at a stricter accuracy.
+     *
+     * @param value Minimum number of neighbours, at least 1. 0 restores the accuracy level default.
+     */
+    void setGrouping(int value);
+
+    /**
+     * Get the arithmetic used to evaluate the cascades.
+     *
+     * @return FloatingPoint (default) or FixedPoint.
+     */
+    DetectionArithmetic arithmetic() const;
+
+    /**
+     * Set the arithmetic used to evaluate the cascades. FixedPoint avoids floating point work per
+     * window and finds the same faces as FloatingPoint within the tolerance documented in
+     * FixedPointCascade.h. Cascades that cannot be evaluated in fixed point fall back to FloatingPoint.
+     *
+     * @param value Desired arithmetic.
+     */
+    void setArithmetic(DetectionArithmetic value);
+
+    /**
+     * Get the usage of the image buffers recycled between calls of detectFaces(). Full-size working
+     * copies and resized images are taken from a pool of power-of-two size classes; the face crops
+     * are not, because they are owned by the returned Face objects.
+     *
+     * @return Requests, reuse rate and peak bytes of the buffer pool of this detector.
+     */
+    ImageBufferStats bufferStats() const;
+
+    /**
+     * Selects the faces with at least the given confidence.
+     *
+     * @param faces Detected faces. Ownership is not affected.
+     * @param minConfidence Minimum value of Face::getConfidence().
+     *
+     * @return The faces that qualify, in their original order.
+     */
+    static std::vector<Face*> selectConfident(const std::vector<Face*>& faces, int minConfidence);
+
     /**
      * Returns the image size (one dimension) recommended for face detection. If the image is considerably larger, it will be rescaled automatically.
      *
@@ -135,11 +189,12 @@ private:
      *
      *  @param inputImage A pointer to the IplImage representing image of interest.
      *  @param casc The CvClassClassifierCascade pointer to be used for the detection.
+     *  @param fixedCasc The same cascade in fixed point. If not 0, it is used instead of casc.
      *  @param faceSize A cvSize that specifies the minimum size of faces to be detected.
      *
      *  @return Returns a vector of Face objects. Each object hold information about 1 face.
      */
-    std::vector<Face*>* cascadeResult(const IplImage* inputImage, CvHaarClassifierCascade* casc, CvSize faceSize = cvSize(10, 10));
+    std::vector<Face*>* cascadeResult(const IplImage* inputImage, CvHaarClassifierCascade* casc, FixedPointCascade* fixedCasc = 0, CvSize faceSize = cvSize(10, 10));
 
     /**
      * Returns the final faces from the detection results of multiple cascades.
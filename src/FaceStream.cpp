@@ -0,0 +1,134 @@
+/** ===========================================================
+ * @file FaceStream.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Sources of labelled face images that are read one at a time.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "FaceStream.h"
+
+// LibFace headers
+#include "Log.h"
+#include "ScanPipeline.h"
+
+// OpenCV headers
+#if defined (__APPLE__)
+#include <cv.h>
+#include <highgui.h>
+#else
+#include <opencv/cv.h>
+#include <opencv/highgui.h>
+#endif
+
+// C headers
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace cv;
+
+namespace libface {
+
+DirectoryFaceStream::DirectoryFaceStream(const string& dir, const Size& size) : m_files(), m_size(size), m_position(0) {
+    DIR* directory = opendir(dir.c_str());
+    if(!directory) {
+        LOG(libfaceWARNING) << "DirectoryFaceStream : Could not open directory " << dir;
+        return;
+    }
+
+    string prefix = dir;
+    if(!prefix.empty() && prefix[prefix.size()-1] != '/') {
+        prefix += '/';
+    }
+
+    vector<string> persons;
+    struct dirent* entry;
+    while((entry = readdir(directory)) != 0) {
+        if(entry->d_name[0] == '.') {
+            continue;
+        }
+
+        struct stat fileInfo;
+        if(stat((prefix + entry->d_name).c_str(), &fileInfo) == 0 && S_ISDIR(fileInfo.st_mode)) {
+            persons.push_back(entry->d_name);
+        }
+    }
+    closedir(directory);
+
+    sort(persons.begin(), persons.end());
+
+    for(unsigned i = 0; i < persons.size(); ++i) {
+        // trailing digits of the name, e.g. "s12"
+        const string& name = persons[i];
+        size_t digits      = name.size();
+        while(digits > 0 && isdigit((unsigned char)name[digits-1])) {
+            --digits;
+        }
+        int label = digits < name.size() ? atoi(name.c_str() + digits) : (int)i;
+
+        vector<string> images = ScanPipeline::listImages(prefix + name);
+        for(unsigned j = 0; j < images.size(); ++j) {
+            m_files.push_back(make_pair(images[j], label));
+        }
+    }
+
+    LOG(libfaceDEBUG) << "DirectoryFaceStream : " << m_files.size() << " faces of " << persons.size() << " persons in " << dir;
+}
+
+bool DirectoryFaceStream::next(Mat& face, int& label) {
+    while(m_position < m_files.size()) {
+        const pair<string, int>& file = m_files[m_position++];
+
+        IplImage* img = cvLoadImage(file.first.c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+        if(!img) {
+            LOG(libfaceWARNING) << "DirectoryFaceStream : Could not load " << file.first;
+            continue;
+        }
+
+        if(m_size.width > 0 && m_size.height > 0 && (img->width != m_size.width || img->height != m_size.height)) {
+            face.create(m_size, CV_8UC1);
+            resize(cvarrToMat(img), face, m_size);
+        } else {
+            face = cvarrToMat(img, true);
+        }
+        cvReleaseImage(&img);
+
+        label = file.second;
+        return true;
+    }
+    return false;
+}
+
+void DirectoryFaceStream::rewind() {
+    m_position = 0;
+}
+
+int DirectoryFaceStream::size() const {
+    return (int)m_files.size();
+}
+
+} // namespace libface
@@ -0,0 +1,112 @@
+/** ===========================================================
+ * @file FaceStream.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Sources of labelled face images that are read one at a time.
+ * @section DESCRIPTION
+ *
+ * Streaming training reads the training faces from a FaceStream instead of a vector of Face
+ * objects, so that they never have to be in memory together. Applications with their own storage
+ * implement next() and rewind(). DirectoryFaceStream reads a directory with one subdirectory per
+ * person, as in examples/database/train.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _FACESTREAM_H_
+#define _FACESTREAM_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+// C headers
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libface
+{
+
+/**
+ * Abstract source of training faces. Trainers may read a stream several times.
+ */
+class FACEAPI FaceStream
+{
+public:
+
+    virtual ~FaceStream() {};
+
+    /**
+     * Reads the next face.
+     *
+     * @param face Receives the face image, single channel. All faces of a stream must have the same size.
+     * @param label Receives the ID of the person.
+     *
+     * @return False at the end of the stream.
+     */
+    virtual bool next(cv::Mat& face, int& label) = 0;
+
+    /**
+     * Starts reading from the first face again.
+     */
+    virtual void rewind() = 0;
+};
+
+// -------------------------------------------------------------------------------------------
+
+/**
+ * Reads the images in the subdirectories of a directory as grayscale faces. The label of a face is
+ * the number at the end of its subdirectory's name ("s12" gives 12), or the position of the
+ * subdirectory in sorted order if the name does not end in a number.
+ */
+class FACEAPI DirectoryFaceStream : public FaceStream
+{
+public:
+
+    /**
+     * Constructor. Lists the files, images are loaded by next().
+     *
+     * @param dir The directory.
+     * @param size If not 0 x 0, every face is resized to this size.
+     */
+    DirectoryFaceStream(const std::string& dir, const cv::Size& size = cv::Size());
+
+    bool next(cv::Mat& face, int& label);
+
+    void rewind();
+
+    /**
+     * @return Number of files found.
+     */
+    int size() const;
+
+private:
+
+    std::vector<std::pair<std::string, int> > m_files;
+    cv::Size                                  m_size;
+    unsigned                                  m_position;
+};
+
+} // namespace libface
+
+#endif /* _FACESTREAM_H_ */
@@ -5,10 +5,11 @@
  * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
  *
  * @date    2009-12-21
- * @brief
+ * @brief   Class means and scatter matrices of labelled samples, and their discriminants.
  * @section DESCRIPTION
  *
  * @author Copyright (C) 2009 by Aleksey
+ * @author Copyright (C) 2026 by libface developers
  *
  * @section LICENSE
  *
@@ -25,188 +26,326 @@
  *
  * ============================================================ */
 
+// own header
 #include "FisherCore.h"
 
-namespace libface
-{
-  
-FisherCore::FisherCore()
-{
-    // TODO Auto-generated constructor stub
-}
+// LibFace headers
+#include "Log.h"
+#include "ThreadPool.h"
 
-FisherCore::~FisherCore()
-{
-    // TODO Auto-generated destructor stub
-}
+// C headers
+#include <algorithm>
+#include <cmath>
+#include <map>
 
-CvMat* FisherCore::mean(CvMat* matrix)
-{
-    int rows      = matrix->rows;
-    int cols      = matrix->cols;
-    CvMat* result = cvCreateMat(rows, 1, CV_32FC1);
+using namespace std;
+using namespace cv;
+
+namespace libface {
+
+// Rows converted to double at once, the scatter of a block is one matrix product per worker
+static const int BLOCK_ROWS = 1024;
 
-    for (int i=0 ; i<rows ; i++)
-    {
-        double sum = 0;
+class FisherCore::FisherCorePriv {
 
-        for (int j=0 ; j<cols ; j++)
-        {
-            sum = sum + cvGet2D(matrix, i, j).val[0];
+public:
+
+    FisherCorePriv() : dimension(0), samples(0), scatter(), sums(), counts(), classOf() {}
+
+    FisherCorePriv(const FisherCorePriv& that) : dimension(that.dimension), samples(that.samples), scatter(that.scatter.clone()),
+                                                 sums(that.sums.clone()), counts(that.counts), classOf(that.classOf) {}
+
+    FisherCorePriv& operator = (const FisherCorePriv& that) {
+        if(this != &that) {
+            dimension = that.dimension;
+            samples   = that.samples;
+            scatter   = that.scatter.clone();
+            sums      = that.sums.clone();
+            counts    = that.counts;
+            classOf   = that.classOf;
         }
-        sum = sum / cols;
+        return *this;
+    }
 
-        CvScalar mean = cvScalarAll(sum);
-        cvSet2D(result,i,0,mean);
+    /**
+     * @return The row of a label in sums, a new one if it has none.
+     */
+    int classIndex(int label);
+
+    int           dimension;
+    int           samples;
+    Mat           scatter;   // Sum of the outer products of the samples, CV_64F
+    Mat           sums;      // Sum of the samples of every class by row, CV_64F
+    vector<int>   counts;    // Samples of every class, 0 for a class emptied by remove()
+    map<int, int> classOf;   // Label to row of sums
+};
+
+int FisherCore::FisherCorePriv::classIndex(int label) {
+    map<int, int>::iterator it = classOf.find(label);
+    if(it != classOf.end()) {
+        return it->second;
     }
 
-    return result;
+    // rows of emptied classes are taken again
+    int c = (int)(std::find(counts.begin(), counts.end(), 0) - counts.begin());
+    if(c == (int)counts.size()) {
+        Mat empty = Mat::zeros(1, dimension, CV_64F);
+        sums.push_back(empty);
+        counts.push_back(0);
+    }
+    classOf[label] = c;
+    return c;
 }
 
-CvMat* FisherCore::subtract(CvMat* src1, CvMat* src2)
+namespace {
+
+/**
+ * Adds a block of samples to the scatter and the class sums. Every worker owns a range of
+ * components: the rows of the scatter and the columns of the sums in that range.
+ */
+class ScatterTask : public RangeTask
 {
-    CvMat* result = cvCreateMat(src1->rows, src1->cols, CV_32FC1);
-
-    for (int i=0 ; i<src1->rows ; i++)
-    {
-        for (int j=0 ; j<src1->cols ; j++)
-        {
-            double diff   = cvGet2D(src1, i, j).val[0] - cvGet2D(src2, i, 0).val[0];
-            CvScalar data = cvScalarAll(diff);
-            cvSet2D(result, i, j, data);
+public:
+
+    ScatterTask(const Mat& block, const vector<int>& classes, Mat& scatter, Mat& sums)
+        : m_block(block), m_classes(classes), m_scatter(scatter), m_sums(sums) {}
+
+    void run(int begin, int end) {
+        Mat product;
+        gemm(m_block.colRange(begin, end), m_block, 1.0, Mat(), 0.0, product, GEMM_1_T);
+        Mat rows = m_scatter.rowRange(begin, end);
+        rows    += product;
+
+        for(int i = 0; i < m_block.rows; ++i) {
+            const double* x = m_block.ptr<double>(i);
+            double* sum     = m_sums.ptr<double>(m_classes[i]);
+            for(int j = begin; j < end; ++j) {
+                sum[j] += x[j];
+            }
         }
     }
 
-    return result;
-}
+private:
 
-void FisherCore::reverseOrder(CvMat* matrix)
-{
-    CvMat* result = cvCreateMat(matrix->rows,matrix->cols,CV_32FC1);
+    const Mat&         m_block;
+    const vector<int>& m_classes;
+    Mat&               m_scatter;
+    Mat&               m_sums;
+};
 
-    for (int i=matrix->rows-1 ; i>=0 ; i--)
-    {
-        for (int j=matrix->cols-1 ; j>=0 ; j--)
-        {
-            cvSet2D(result, matrix->rows-i-1, matrix->cols-j-1, cvGet2D(matrix,i,j));
-        }
+} // namespace
+
+FisherCore::FisherCore() : d(new FisherCorePriv) {}
+
+FisherCore::FisherCore(const FisherCore& that) : d(new FisherCorePriv(*that.d)) {}
+
+FisherCore& FisherCore::operator = (const FisherCore& that) {
+    if(this != &that) {
+        *d = *that.d;
     }
+    return *this;
 }
 
-CvMat* FisherCore::getColoumn(CvMat* matrix, int col)
-{
-    CvMat* result = cvCreateMat(matrix->rows,1,CV_32FC1);
+FisherCore::~FisherCore() {
+    delete d;
+}
 
-    for (int i=0 ; i<matrix->rows ; i++)
-    {
-        cvSet2D(result, i, 0, cvGet2D(matrix, i, col));
-    }
+void FisherCore::clear() {
+    d->dimension = 0;
+    d->samples   = 0;
+    d->scatter.release();
+    d->sums.release();
+    d->counts.clear();
+    d->classOf.clear();
+}
 
-    return result;
+int FisherCore::dimension() const {
+    return d->dimension;
 }
 
-void FisherCore::calulateFisherStats()
-{
-    printf("Loading training data \n");
-    int Class_Number     = 3;
-    int Class_Population = 1;
-    int P                = Class_Number * Class_Population;
-    int i,j;
+int FisherCore::samples() const {
+    return d->samples;
+}
 
-    //images need to be scaled to the same size.
-    IplImage* img = cvLoadImage("src/TrainDatabase/2.jpg",0); //0 - grayscale
-    CvMat* img2   = cvCreateMat(img->height, img->width, CV_32FC1);
-    cvConvert(img, img2);
-    CvMat* row    = transpose(reshape(img2));
+int FisherCore::classes() const {
+    return (int)d->classOf.size();
+}
 
-    //CvMat* img3 = cvCreateMat(200, 180, CV_32FC1);
+int FisherCore::add(const Mat& rows, const vector<int>& labels, ThreadPool* pool) {
+    if(rows.rows == 0) {
+        return 0;
+    }
+    if(labels.size() != (size_t)rows.rows || (d->dimension > 0 && rows.cols != d->dimension)) {
+        LOG(libfaceERROR) << "FisherCore : " << rows.rows << " samples of dimension " << rows.cols << " with " << labels.size()
+                          << " labels do not match the statistics of dimension " << d->dimension << ".";
+        return 1;
+    }
 
-    IplImage* img_training = cvLoadImage("src/TrainDatabase/3.jpg",0);
-    CvMat* img2_training   = cvCreateMat(img_training->height, img_training->width, CV_32FC1);
-    cvConvert(img_training, img2_training);
-    CvMat* row2            = transpose(reshape(img2_training));
+    if(d->dimension == 0) {
+        d->dimension = rows.cols;
+        d->scatter   = Mat::zeros(d->dimension, d->dimension, CV_64F);
+    }
+
+    // the classes are created before the workers write into their sums
+    vector<int> classes(labels.size());
+    for(unsigned i = 0; i < labels.size(); ++i) {
+        classes[i] = d->classIndex(labels[i]);
+        ++d->counts[classes[i]];
+    }
+
+    Mat block;
+    for(int first = 0; first < rows.rows; first += BLOCK_ROWS) {
+        const int last = std::min(rows.rows, first + BLOCK_ROWS);
+        rows.rowRange(first, last).convertTo(block, CV_64F);
+
+        vector<int> blockClasses(classes.begin() + first, classes.begin() + last);
+        ScatterTask task(block, blockClasses, d->scatter, d->sums);
+        if(pool) {
+            pool->parallelFor(d->dimension, task);
+        } else {
+            task.run(0, d->dimension);
+        }
+    }
+    d->samples += rows.rows;
 
-    CvMat* T = combine(row, row2);
+    return 0;
+}
 
-    img  = cvLoadImage("src/TrainDatabase/5.jpg",0); //0 - grayscale
-    img2 = cvCreateMat(img->height, img->width, CV_32FC1);
-    cvConvert(img, img2);
-    row  = transpose(reshape(img2));
+int FisherCore::remove(const Mat& row, int label) {
+    map<int, int>::iterator it = d->classOf.find(label);
+    if(it == d->classOf.end() || (int)row.total() != d->dimension) {
+        return 1;
+    }
 
-    T    = combine(T, row);
+    Mat x, outer;
+    row.reshape(1, 1).convertTo(x, CV_64F);
+    mulTransposed(x, outer, true);
+    d->scatter -= outer;
+
+    const int c = it->second;
+    Mat sum     = d->sums.row(c);
+    sum        -= x;
+    if(--d->counts[c] == 0) {
+        // the label may come back, it then takes this or another empty row
+        sum.setTo(Scalar(0));
+        d->classOf.erase(it);
+    }
+    --d->samples;
 
-    printf("Calculating mean of training data... \n");
-    CvMat* m_database = mean(T);
-    printf("Size of mean: %d x %d \n",m_database->rows,m_database->cols);
+    return 0;
+}
 
-    printf("Subtracting mean from training data...\n");
-    CvMat* A = subtract(T, m_database);
-    printf("Size of A: %d x %d\n",A->rows,A->cols);
+int FisherCore::relabel(int label, int newLabel) {
+    map<int, int>::iterator it = d->classOf.find(label);
+    if(it == d->classOf.end()) {
+        return 1;
+    }
+    if(label == newLabel) {
+        return 0;
+    }
 
-    printf("Calculating Transposed Multiplication...\n");
-    CvMat* L = cvCreateMat(A->width, A->width, CV_32FC1);
+    const int c = it->second;
+    d->classOf.erase(it);
 
-    cvMulTransposed(A,L,1);
-    printf("Size of L: %d x %d\n",L->rows,L->cols);
+    map<int, int>::iterator target = d->classOf.find(newLabel);
+    if(target == d->classOf.end()) {
+        d->classOf[newLabel] = c;
+        return 0;
+    }
 
-    printf("Calculating Eigen Vectors...\n");
-    CvMat* values = cvCreateMat(L->rows,L->rows,CV_32FC1); //null here
-    CvMat* vector = cvCreateMat(L->rows,L->rows,CV_32FC1); //null here  initialise both to the size of the covv which is a*a'
+    Mat from = d->sums.row(c);
+    Mat to   = d->sums.row(target->second);
+    to      += from;
+    from.setTo(Scalar(0));
+    d->counts[target->second] += d->counts[c];
+    d->counts[c]               = 0;
 
-    cvEigenVV(L,vector ,values);
+    return 0;
+}
 
-    for (int i=0 ; i<values->rows ; i++)
-    {
-        for (int j=0 ; j<values->cols ; j++)
-        {
-            printf("%f \t",cvGet2D(values, i, j).val[0]);
-        }
-        printf("\n");
+Mat FisherCore::mean() const {
+    Mat result = Mat::zeros(1, d->dimension, CV_64F);
+    if(d->samples > 0) {
+        reduce(d->sums, result, 0, CV_REDUCE_SUM);
+        result /= d->samples;
     }
+    return result;
+}
 
-    for (int i=0 ; i<vector->rows ; i++)
-    {
-        for (int j=0 ; j<vector->cols ; j++)
-        {
-            printf("%f \t",cvGet2D(vector, i, j).val[0]);
-        }
-        printf("\n");
+Mat FisherCore::classMean(int label) const {
+    map<int, int>::const_iterator it = d->classOf.find(label);
+    if(it == d->classOf.end()) {
+        return Mat();
     }
+    return d->sums.row(it->second) / (double)d->counts[it->second];
+}
 
-    printf("Calculating V_PCA... \t");
-    CvMat* V_PCA = cvCreateMat(A->rows, A->cols, CV_32FC1);
-    cvMatMul(A, vector, V_PCA);
+Mat FisherCore::withinScatter() const {
+    // every class takes n_c m_c^T m_c = s_c^T s_c / n_c off the sum of the outer products
+    Mat within = d->scatter.clone();
+    Mat outer;
+    for(map<int, int>::const_iterator it = d->classOf.begin(); it != d->classOf.end(); ++it) {
+        mulTransposed(d->sums.row(it->second), outer, true);
+        within -= outer / (double)d->counts[it->second];
+    }
+    return within;
+}
 
-    printf("Projecting into Eigen Space...\n");
-    CvMat* V_PCA_t             = transpose(V_PCA);
-    CvMat* ProjectedImages_PCA = 0;
+Mat FisherCore::betweenScatter() const {
+    Mat between = Mat::zeros(d->dimension, d->dimension, CV_64F);
+    Mat total   = mean();
+    Mat outer;
+    for(map<int, int>::const_iterator it = d->classOf.begin(); it != d->classOf.end(); ++it) {
+        const double count = d->counts[it->second];
+        Mat shift          = d->sums.row(it->second) / count - total;
+        mulTransposed(shift, outer, true);
+        between += outer * count;
+    }
+    return between;
+}
 
-    for (i=0;i<P;i++)
-    {
-        CvMat* col  = getColoumn(A, i);
-        CvMat* temp = cvCreateMat(V_PCA_t->rows, col->cols,CV_32FC1);
-        cvMatMul(V_PCA_t, col, temp);
+int FisherCore::solve(Mat& discriminants, Mat& eigenvalues, int components) const {
+    const int n = d->samples;
+    const int C = classes();
+    if(C < 2 || n <= C) {
+        LOG(libfaceWARNING) << "FisherCore : " << n << " samples of " << C << " classes are too few for the discriminant analysis.";
+        return 1;
+    }
 
-        if (ProjectedImages_PCA == 0)
-        {
-            ProjectedImages_PCA = temp;
-        }
-        else
-        {
-            ProjectedImages_PCA = combine(ProjectedImages_PCA, temp);
-        }
+    // whiten by the within-class covariance, directions without variance are dropped
+    Mat within = withinScatter() / (double)(n - C);
+    Mat values, vectors;
+    eigen(within, values, vectors);
+    int r = 0;
+    while(r < values.rows && values.at<double>(r) > values.at<double>(0) * 1e-10) {
+        ++r;
+    }
+    if(r == 0) {
+        LOG(libfaceWARNING) << "FisherCore : The samples of every class are identical, no discriminants.";
+        return 1;
     }
-    printf("DONE\n");
 
-    printf("Size of ProjectedImages_PCA: %d x %d\n",ProjectedImages_PCA->rows,ProjectedImages_PCA->cols);
+    Mat whitening(r, d->dimension, CV_64F);
+    for(int j = 0; j < r; ++j) {
+        Mat row = whitening.row(j);
+        vectors.row(j).convertTo(row, CV_64F, 1.0 / sqrt(values.at<double>(j)));
+    }
+
+    Mat whitenedBetween, betweenValues, betweenVectors;
+    whitenedBetween = whitening * betweenScatter() * whitening.t();
+    eigen(whitenedBetween, betweenValues, betweenVectors);
+
+    // back to the space of the samples, one discriminant per column
+    int k = std::min(C - 1, r);
+    if(components > 0) {
+        k = std::min(k, components);
+    }
+    gemm(whitening, betweenVectors.rowRange(0, k), 1.0, Mat(), 0.0, discriminants, GEMM_1_T | GEMM_2_T);
+    eigenvalues = betweenValues.rowRange(0, k).clone();
 
-    printf("Calculating mean of Eigen values...\n");
+    LOG(libfaceDEBUG) << "FisherCore : " << k << " discriminants of " << C << " classes from " << n << " samples.";
 
-    CvMat* m_PCA = mean(ProjectedImages_PCA);
-    printf("Done\n");
-    CvMat* m  = 0;
-    CvMat* Sw = 0;
-    CvMat* Sb = 0;
+    return 0;
 }
 
 } // namespace libface
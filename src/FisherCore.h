@@ -5,10 +5,21 @@
  * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
  *
  * @date    2009-12-21
- * @brief
+ * @brief   Class means and scatter matrices of labelled samples, and their discriminants.
  * @section DESCRIPTION
  *
+ * Keeps the sum of every class and the sum of the outer products of all samples. Both follow added
+ * and removed samples, so the class means and the between- and within-class scatter matrices are
+ * always at hand without another pass over the data. Samples are added in blocks of rows: every
+ * block is read once, and the workers of a ThreadPool fill disjoint rows of the scatter with one
+ * matrix product each, so the result does not depend on the number of threads.
+ *
+ * The discriminants whiten the samples by the within-class covariance and take the leading
+ * eigenvectors of the between-class scatter in that space. They are orthonormal with respect to
+ * the within-class covariance, so distances along them are in within-class standard deviations.
+ *
  * @author Copyright (C) 2009 by Aleksey
+ * @author Copyright (C) 2026 by libface developers
  *
  * @section LICENSE
  *
@@ -28,30 +39,138 @@
 #ifndef _FISHERCORE_H_
 #define _FISHERCORE_H_
 
-#if defined (__APPLE__)
-#include <cv.h>
-#else
-#include <opencv/cv.h>
-#endif
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+// C headers
+#include <vector>
 
 namespace libface
 {
 
+class ThreadPool;
+
 class FACEAPI FisherCore
 {
 public:
 
+    /**
+     * Constructor. The statistics are empty until add() is called.
+     */
     FisherCore();
-    virtual ~FisherCore();
 
-    void calulateFisherStats();
+    /**
+     * Copy constructor.
+     *
+     * @param that The statistics to copy.
+     */
+    FisherCore(const FisherCore& that);
+
+    /**
+     * Assignment operator.
+     *
+     * @param that The statistics to copy.
+     */
+    FisherCore& operator = (const FisherCore& that);
+
+    /**
+     * Destructor.
+     */
+    ~FisherCore();
+
+    /**
+     * Forgets all samples. The dimension is determined again by the next add().
+     */
+    void clear();
+
+    /**
+     * @return Number of components of the samples, 0 if there are none.
+     */
+    int dimension() const;
+
+    /**
+     * @return Number of samples.
+     */
+    int samples() const;
+
+    /**
+     * @return Number of classes with at least one sample.
+     */
+    int classes() const;
+
+    /**
+     * Adds samples to their classes and to the scatter.
+     *
+     * @param rows One sample per row, any depth.
+     * @param labels The label (class) of every row.
+     * @param pool Threads sharing the scatter of each block, or 0 for the calling thread only.
+     *
+     * @return 0 on success, 1 if the dimension or the number of labels does not match.
+     */
+    int add(const cv::Mat& rows, const std::vector<int>& labels, ThreadPool* pool = 0);
+
+    /**
+     * Takes a sample added before out of its class and of the scatter.
+     *
+     * @param row The sample, a single row of dimension() elements, any depth.
+     * @param label Its label.
+     *
+     * @return 0 on success, 1 if the class has no samples or the dimension does not match.
+     */
+    int remove(const cv::Mat& row, int label);
+
+    /**
+     * Moves the samples of a class to another one, which is created or merged with.
+     *
+     * @param label The label to change.
+     * @param newLabel Its new value.
+     *
+     * @return 0 on success, 1 if the class has no samples.
+     */
+    int relabel(int label, int newLabel);
+
+    /**
+     * @return The mean of all samples, 1 x dimension() CV_64F.
+     */
+    cv::Mat mean() const;
+
+    /**
+     * @param label The label of a class.
+     *
+     * @return The mean of its samples, 1 x dimension() CV_64F, or an empty matrix if it has none.
+     */
+    cv::Mat classMean(int label) const;
+
+    /**
+     * @return The within-class scatter, sum of the outer products of the samples minus their class
+     * mean, dimension() x dimension() CV_64F.
+     */
+    cv::Mat withinScatter() const;
+
+    /**
+     * @return The between-class scatter, sum over the classes of their number of samples times the
+     * outer product of their mean minus the total mean, dimension() x dimension() CV_64F.
+     */
+    cv::Mat betweenScatter() const;
+
+    /**
+     * Computes the discriminants of the classes.
+     *
+     * @param discriminants Receives one discriminant per column, dimension() rows, CV_64F.
+     * @param eigenvalues Receives their eigenvalues in decreasing order, one per row, CV_64F.
+     * @param components Most discriminants, 0 or more than classes() - 1 for classes() - 1.
+     *
+     * @return 0 on success, 1 if there are too few classes or samples.
+     */
+    int solve(cv::Mat& discriminants, cv::Mat& eigenvalues, int components = 0) const;
 
 private:
 
-    CvMat* mean(CvMat* matrix);
-    CvMat* subtract(CvMat* src1, CvMat* src2);
-    void reverseOrder(CvMat* matrix);
-    CvMat* getColoumn(CvMat* matrix, int col);
+    class FisherCorePriv;
+    FisherCorePriv* const d;
 };
 
 } // namespace libface
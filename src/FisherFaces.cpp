@@ -40,7 +40,10 @@
 #include "LibFaceConfig.h"
 #include "Face.h"
 #include "FaceDetect.h"
+#include "FisherCore.h"
 #include "LibFaceUtils.h"
+#include "ProjectionGallery.h"
+#include "ThreadPool.h"
 
 // OpenCV headers
 #if defined (__APPLE__)
@@ -88,6 +91,74 @@ public:
      */
     ~FisherfacesPriv();
 
+    /**
+     * Releases the stored faces of an ID.
+     *
+     * @param id The ID.
+     *
+     * @return Number of faces released.
+     */
+    int forget(int id);
+
+    /**
+     * Drops the removed projections from the gallery once they take up a quarter of it, so that
+     * removal stays O(1) amortized.
+     *
+     * @param force Drop them whatever their number, e.g. before saving.
+     */
+    void compact(bool force);
+
+    /**
+     * @return Element type of the mean, the projection matrix and the training matrix, CV_32FC1
+     * unless the training options ask for double precision.
+     */
+    int modelType() const;
+
+    /**
+     * Forgets the PCA basis and the scatter statistics, e.g. for a loaded model which has none.
+     */
+    void dropStatistics();
+
+    /**
+     * Adds faces to the scatter statistics and keeps their PCA coordinates for later projections.
+     *
+     * @param reduced The faces in the PCA subspace, one per row, in the order of their gallery rows.
+     * @param labels Their labels.
+     * @param pool Threads sharing the scatter, or 0.
+     */
+    void accumulate(const Mat& reduced, const vector<int>& labels, ThreadPool* pool = 0);
+
+    /**
+     * Takes a face out of the scatter statistics before its gallery row is removed.
+     *
+     * @param row Gallery row of the face.
+     */
+    void subtract(int row);
+
+    /**
+     * Computes the discriminants from the scatter statistics, see FisherCore::solve().
+     *
+     * @return 0 on success, 1 if there are too few classes or faces.
+     */
+    int solve();
+
+    /**
+     * Solves the discriminant analysis again and projects all faces in the new Fisher subspace.
+     */
+    void refresh();
+
+    /**
+     * Refreshes the discriminants once the faces added or removed since the last solve reach the
+     * drift threshold of the faces it used.
+     */
+    void checkDrift();
+
+    /**
+     * @return Largest distance of a recognised face under the distance mode of the gallery, as
+     * reported by recognize().
+     */
+    float threshold() const;
+
 
     // Face data members, stored in the DB
     // Array of face images. It is assumed that all elements of faceImgArr always point to valid IplImages. Otherwise runtime errors will occur.
@@ -101,7 +172,9 @@ public:
     double CUT_OFF;
     double UPPER_DIST;
     double LOWER_DIST;
-    float THRESHOLD;
+    float THRESHOLD;                // Largest recognised distance under DistanceEuclidean
+    float MAHALANOBIS_THRESHOLD;    // Under DistanceMahalanobis, in the unit of the whitened projections
+    float COSINE_THRESHOLD;         // Under DistanceCosine, the distance is at most 2
     float RMS_THRESHOLD;
     int FACE_WIDTH;
     int FACE_HEIGHT;
@@ -111,23 +184,32 @@ public:
      * New Addition
      */
     int m_no_components_after_lda;
-    vector<Mat> m_projections;
-    vector<int> m_labels;
+    ProjectionGallery m_gallery;
+    TrainingOptions trainingOptions;
     Mat m_eigenvectors;
     Mat m_eigenvalues;
     Mat m_mean;
 
+    // Discriminant analysis in the PCA subspace, kept after training so that new faces update it
+    Mat m_pcaVectors;           // PCA basis by column, m_eigenvectors = m_pcaVectors m_discriminants
+    Mat m_discriminants;        // Discriminants by column in the PCA subspace
+    Mat m_reduced;              // PCA coordinates of every gallery row
+    FisherCore m_core;          // Class means and scatter of the PCA coordinates
+    int m_samples;              // Faces of the last solve
+    int m_changed;              // Faces added or removed since
+
     // Identifier
     Identifier idType;
     TrainingRequirement trainReq;
 };
 
 
-Fisherfaces::FisherfacesPriv::FisherfacesPriv() : faceImgArr(), indexMap(), configFile(), CUT_OFF(10000000.0), UPPER_DIST(10000000), LOWER_DIST(10000000), THRESHOLD(1000000.0), RMS_THRESHOLD(10.0), FACE_WIDTH(120), FACE_HEIGHT(120) {
+Fisherfaces::FisherfacesPriv::FisherfacesPriv() : faceImgArr(), indexMap(), configFile(), CUT_OFF(10000000.0), UPPER_DIST(10000000), LOWER_DIST(10000000), THRESHOLD(1000000.0), MAHALANOBIS_THRESHOLD(1000000.0), COSINE_THRESHOLD(2.0), RMS_THRESHOLD(10.0), FACE_WIDTH(120), FACE_HEIGHT(120), m_no_components_after_lda(0), m_samples(0), m_changed(0) {
     trainReq = AllImagesOfAllPersons;
 }
 
-Fisherfaces::FisherfacesPriv::FisherfacesPriv(const FisherfacesPriv& that) : faceImgArr(), indexMap(that.indexMap), configFile(that.configFile), CUT_OFF(that.CUT_OFF), UPPER_DIST(that.UPPER_DIST), LOWER_DIST(that.LOWER_DIST), THRESHOLD(that.THRESHOLD), RMS_THRESHOLD(that.RMS_THRESHOLD), FACE_WIDTH(that.FACE_WIDTH), FACE_HEIGHT(that.FACE_HEIGHT) {
+Fisherfaces::FisherfacesPriv::FisherfacesPriv(const FisherfacesPriv& that) : faceImgArr(), indexMap(that.indexMap), configFile(that.configFile), CUT_OFF(that.CUT_OFF), UPPER_DIST(that.UPPER_DIST), LOWER_DIST(that.LOWER_DIST), THRESHOLD(that.THRESHOLD), MAHALANOBIS_THRESHOLD(that.MAHALANOBIS_THRESHOLD), COSINE_THRESHOLD(that.COSINE_THRESHOLD), RMS_THRESHOLD(that.RMS_THRESHOLD), FACE_WIDTH(that.FACE_WIDTH), FACE_HEIGHT(that.FACE_HEIGHT), m_no_components_after_lda(that.m_no_components_after_lda), m_gallery(that.m_gallery), trainingOptions(that.trainingOptions), m_eigenvectors(that.m_eigenvectors), m_eigenvalues(that.m_eigenvalues), m_mean(that.m_mean), m_pcaVectors(that.m_pcaVectors), m_discriminants(that.m_discriminants), m_reduced(that.m_reduced.clone()), m_core(that.m_core), m_samples(that.m_samples), m_changed(that.m_changed), idType(that.idType), trainReq(that.trainReq) {
+
     // copy images pointed to by faceImgArr
     for(unsigned i = 0; i < that.faceImgArr.size(); ++i) {
         faceImgArr.push_back(cvCloneImage(that.faceImgArr.at(i)));
@@ -157,9 +239,25 @@ Fisherfaces::FisherfacesPriv& Fisherfaces::FisherfacesPriv::operator = (const Fi
     UPPER_DIST = that.UPPER_DIST;
     LOWER_DIST = that.LOWER_DIST;
     THRESHOLD = that.THRESHOLD;
+    MAHALANOBIS_THRESHOLD = that.MAHALANOBIS_THRESHOLD;
+    COSINE_THRESHOLD = that.COSINE_THRESHOLD;
     RMS_THRESHOLD = that.RMS_THRESHOLD;
     FACE_WIDTH = that.FACE_WIDTH;
     FACE_HEIGHT = that.FACE_HEIGHT;
+    m_no_components_after_lda = that.m_no_components_after_lda;
+    m_gallery = that.m_gallery;
+    trainingOptions = that.trainingOptions;
+    m_eigenvectors = that.m_eigenvectors;
+    m_eigenvalues = that.m_eigenvalues;
+    m_mean = that.m_mean;
+    m_pcaVectors = that.m_pcaVectors;
+    m_discriminants = that.m_discriminants;
+    m_reduced = that.m_reduced.clone();
+    m_core = that.m_core;
+    m_samples = that.m_samples;
+    m_changed = that.m_changed;
+    idType = that.idType;
+    trainReq = that.trainReq;
 
     return *this;
 }
@@ -212,6 +310,128 @@ Fisherfaces::~Fisherfaces() {
     delete d;
 }
 
+int Fisherfaces::FisherfacesPriv::forget(int id) {
+    int released = 0;
+    for(int j = (int)std::min(faceImgArr.size(), indexMap.size()) - 1; j >= 0; --j) {
+        if(indexMap[j] == id) {
+            cvReleaseImage(&faceImgArr[j]);
+            faceImgArr.erase(faceImgArr.begin() + j);
+            indexMap.erase(indexMap.begin() + j);
+            ++released;
+        }
+    }
+    return released;
+}
+
+void Fisherfaces::FisherfacesPriv::compact(bool force) {
+    const int removed = m_gallery.removedCount();
+    if(removed == 0 || (!force && removed * 4 <= m_gallery.size())) {
+        return;
+    }
+
+    vector<int> remap;
+    m_gallery.compact(remap);
+
+    if(!m_reduced.empty()) {
+        Mat reduced(m_gallery.size(), m_reduced.cols, m_reduced.type());
+        for(unsigned i = 0; i < remap.size(); ++i) {
+            if(remap[i] >= 0) {
+                Mat row = reduced.row(remap[i]);
+                m_reduced.row(i).copyTo(row);
+            }
+        }
+        m_reduced = reduced;
+    }
+}
+
+int Fisherfaces::FisherfacesPriv::modelType() const {
+    return trainingOptions.doublePrecision ? CV_64FC1 : CV_32FC1;
+}
+
+void Fisherfaces::FisherfacesPriv::dropStatistics() {
+    m_pcaVectors.release();
+    m_discriminants.release();
+    m_reduced.release();
+    m_core.clear();
+    m_samples = 0;
+    m_changed = 0;
+}
+
+void Fisherfaces::FisherfacesPriv::accumulate(const Mat& reduced, const vector<int>& labels, ThreadPool* pool) {
+    if(m_core.add(reduced, labels, pool) != 0) {
+        return;
+    }
+    m_reduced.push_back(reduced);
+    m_changed += reduced.rows;
+}
+
+void Fisherfaces::FisherfacesPriv::subtract(int row) {
+    if(row < m_reduced.rows && m_core.remove(m_reduced.row(row), m_gallery.label(row)) == 0) {
+        ++m_changed;
+    }
+}
+
+int Fisherfaces::FisherfacesPriv::solve() {
+    Mat discriminants;
+    if(m_core.solve(discriminants, m_eigenvalues) != 0) {
+        return 1;
+    }
+
+    // the PCA basis keeps the precision it was trained with, whatever doublePrecision is now
+    discriminants.convertTo(m_discriminants, m_pcaVectors.type());
+    gemm(m_pcaVectors, m_discriminants, 1.0, Mat(), 0.0, m_eigenvectors);
+    m_no_components_after_lda = m_discriminants.cols;
+
+    m_samples = m_core.samples();
+    m_changed = 0;
+
+    return 0;
+}
+
+void Fisherfaces::FisherfacesPriv::refresh() {
+    compact(true);
+    if(solve() != 0) {
+        // the discriminants stay as they are until enough faces changed again
+        m_samples = m_core.samples();
+        m_changed = 0;
+        return;
+    }
+
+    // the dimension follows the number of people, so the gallery is filled again
+    vector<int> labels(m_gallery.labels());
+    Mat projections;
+    gemm(m_reduced, m_discriminants, 1.0, Mat(), 0.0, projections);
+
+    m_gallery.clear();
+    m_gallery.reserve(projections.rows);
+    for(int i = 0; i < projections.rows; ++i) {
+        m_gallery.add(projections.row(i), labels[i]);
+    }
+}
+
+void Fisherfaces::FisherfacesPriv::checkDrift() {
+    if(m_pcaVectors.empty() || trainingOptions.refreshFraction <= 0.0) {
+        return;
+    }
+
+    if(m_changed > trainingOptions.refreshFraction * m_samples) {
+        LOG(libfaceDEBUG) << "Fisherfaces : " << m_changed << " faces changed since the discriminants of "
+                          << m_samples << " faces, refreshing them.";
+        refresh();
+    }
+}
+
+float Fisherfaces::FisherfacesPriv::threshold() const {
+    switch(m_gallery.matchingOptions().distance) {
+    case DistanceMahalanobis:
+        return MAHALANOBIS_THRESHOLD;
+    case DistanceCosine:
+        return COSINE_THRESHOLD;
+    default:
+        return THRESHOLD;
+    }
+}
+
 int Fisherfaces::count() const {
     return d->faceImgArr.size();
 }
@@ -259,38 +479,42 @@ int Fisherfaces::loadConfig(const string& dir) {
     d->FACE_WIDTH = cvReadIntByName(fileStorage, 0, "FACE_WIDTH",d->FACE_WIDTH);
     d->FACE_HEIGHT = cvReadIntByName(fileStorage, 0, "FACE_HEIGHT",d->FACE_HEIGHT);
     d->THRESHOLD = cvReadRealByName(fileStorage, 0, "THRESHOLD", d->THRESHOLD);
+    d->MAHALANOBIS_THRESHOLD = cvReadRealByName(fileStorage, 0, "MAHALANOBIS_THRESHOLD", d->MAHALANOBIS_THRESHOLD);
+    d->COSINE_THRESHOLD = cvReadRealByName(fileStorage, 0, "COSINE_THRESHOLD", d->COSINE_THRESHOLD);
     //LibFaceUtils::printMatrix(d->projectedTrainFaceMat);
 
-    // If m_projections or m_labels are not empty make them empty
-    while(d->m_projections.size()) d->m_projections.pop_back();
-    while(d->m_labels.size()) d->m_labels.pop_back();
+    // the scatter statistics are not saved, later faces are projected with the loaded discriminants
+    d->dropStatistics();
+    d->m_gallery.clear();
+    d->m_gallery.reserve(nIds);
 
     for ( i = 0; i < nIds; i++ ) {
-        char facename[200];
+        char facename[200], idname[200];
         sprintf(facename, "person_%d", i);
+        sprintf(idname, "id_%d", i);
         IplImage* tmp = (IplImage*)cvReadByName(fileStorage, 0, facename, 0);
-        d->m_projections.push_back(cvarrToMat(tmp));
+        d->m_gallery.add(cvarrToMat(tmp), cvReadIntByName(fileStorage, 0, idname, 0));
+        cvReleaseImage(&tmp);
     }
 
     char eigen_name[20];
     sprintf(eigen_name,"eigenvector");
     IplImage* eigen_tmp = (IplImage*)cvReadByName(fileStorage, 0, eigen_name, 0);
-    d->m_eigenvectors = cvarrToMat(eigen_tmp);
+    cvarrToMat(eigen_tmp).convertTo(d->m_eigenvectors, d->modelType());
 
     char mean_name[20];
     sprintf(mean_name,"mean");
     IplImage* mean_tmp = (IplImage*)cvReadByName(fileStorage, 0, mean_name, 0);
-    d->m_mean = cvarrToMat(mean_tmp);
-
-    for ( i = 0; i < nIds; i++ ) {
-        char idname[200];
-        sprintf(idname, "id_%d", i);
-       d->m_labels.push_back(cvReadIntByName(fileStorage, 0, idname, 0));
-    }
+    cvarrToMat(mean_tmp).convertTo(d->m_mean, d->modelType());
+    cvReleaseImage(&eigen_tmp);
+    cvReleaseImage(&mean_tmp);
 
     // Release file storage
     cvReleaseFileStorage(&fileStorage);
 
+    // the approximate index is optional, it is rebuilt when missing
+    d->m_gallery.loadIndex(d->configFile + ".hnsw");
+
     return 0;
 }
 
@@ -319,33 +543,55 @@ int Fisherfaces::loadConfig(const map<string, string>& c) {
 }
 
 pair<int, float> Fisherfaces::recognize(IplImage* input) {
+    if (input == 0) {
+        LOG(libfaceWARNING) << "No faces passed. No recognition to do." << endl;
 
-    return make_pair<int, float>(-1, -1); // Nothing
-}
+        return make_pair<int, float>(-1, -1); // Nothing
+    }
 
+    if(d->m_eigenvectors.empty() || d->m_gallery.size() == 0) {
+        LOG(libfaceWARNING) << "Fisherfaces : Not trained, no recognition to do.";
 
-static Mat convertToRowMatrix(InputArray src, int matrix_type, double alpha=1, double beta=0){
-    // number of samples in the InputArray
-    int num_of_samples = (int) src.total();
+        return make_pair<int, float>(-1, -1);
+    }
 
-    // if there is no data in InputArray, return an empty matrix
-    if(num_of_samples == 0) return Mat();
+    clock_t recog = clock();
 
-    // dimensionality of samples
-    int dimension = (int)src.getMat(0).total();
+    // project once through the combined PCA and LDA matrix and scan the training projections
+    vector<IplImage*> images(1, input);
+    vector<int> rows;
+    Mat q = LibFaceUtils::projectImages(images, d->m_eigenvectors, d->m_mean, rows);
+    if(q.empty()) {
+        return make_pair<int, float>(-1, -1);
+    }
+
+    float squaredDistance = 0;
+    int nearest           = d->m_gallery.nearest(q, &squaredDistance);
+    if(nearest < 0) {
+        return make_pair<int, float>(-1, -1);
+    }
+
+    // the distance of testingTopK(), in the Fisher subspace, compared with the threshold of the distance mode
+    float minDist = sqrt(squaredDistance);
+    int id        = d->m_gallery.label(nearest);
+
+    recog = clock() - recog;
 
-    // create data matrix
-    Mat data(num_of_samples, dimension, matrix_type);
+    LOG(libfaceDEBUG) << "Recognition took: " << (double)recog / ((double)CLOCKS_PER_SEC) << "sec.";
 
-    // copy data
-    for(int i = 0; i < num_of_samples; i++) {
-        Mat x_i = data.row(i);
-        src.getMat(i).reshape(1, 1).convertTo(x_i, matrix_type, alpha, beta);
+    if(minDist > d->threshold()) {
+
+        LOG(libfaceDEBUG) << "The value of minDist (" << minDist << ") is above the threshold (" << d->threshold() << ").";
+
+        return make_pair<int, float>(-1, -1);
     }
 
-    return data;
+    LOG(libfaceDEBUG) << "The value of minDist is: " << minDist;
+
+    return make_pair<int, float>(id, minDist);
 }
 
+
 /**
  * Find total number of classes - Needed for Fisherface
  */
@@ -401,7 +647,11 @@ void Fisherfaces::training(vector<Face*>* faces, int no_principal_components){
     d->FACE_WIDTH = calc.rows;
     d->FACE_HEIGHT = calc.cols;
 
-    Mat data = convertToRowMatrix(src, CV_64FC1);
+    ThreadPool pool(d->trainingOptions.threads);
+
+    // single precision halves the memory of the data matrix and the time of the PCA
+    const int type = d->modelType();
+    Mat data = LibFaceUtils::rowMatrix(src, type, pool);
     int N = data.rows;
 
     if(labels.size() != (size_t)N)
@@ -417,22 +667,29 @@ void Fisherfaces::training(vector<Face*>* faces, int no_principal_components){
     // After doing a PCA the feature space reduces to N-C by N
     PCA pca(data, Mat(), CV_PCA_DATA_AS_ROW, (N-C));
 
-    // We run LDA on the reduced feature space and final space redues to N-C by m (max of m = C-1)
-    LDA lda(pca.project(data),labels, d->m_no_components_after_lda);
-
     d->m_mean = pca.mean.reshape(1,1);
-    d->m_labels = labels;
-
-    // store the eigenvalues of the discriminants
-    lda.eigenvalues().convertTo(d->m_eigenvalues, CV_64FC1);
-
-    // Now we calculate the total projection matrix by multiplying eigenvector of PCA with eigenvector of LDA
-    gemm(pca.eigenvectors, lda.eigenvectors(), 1.0, Mat(), 0.0, d->m_eigenvectors, CV_GEMM_A_T);
+    d->dropStatistics();
+    transpose(pca.eigenvectors, d->m_pcaVectors);
+
+    // We run LDA on the reduced feature space and final space redues to N-C by m (max of m = C-1).
+    // FisherCore gathers the class means and scatter matrices in one pass shared by the threads,
+    // and keeps them so that later faces update the discriminants without a new PCA.
+    Mat reduced = LibFaceUtils::projectRows(data, d->m_pcaVectors, d->m_mean, pool);
+    d->accumulate(reduced, labels, &pool);
+    if(d->solve() != 0) {
+        d->dropStatistics();
+        d->m_eigenvectors.release();
+        d->m_gallery.clear();
+        return;
+    }
 
-    // save projections
+    // save projections with their labels for prediction
+    d->m_gallery.clear();
+    d->m_gallery.reserve(data.rows);
+    Mat projections;
+    gemm(reduced, d->m_discriminants, 1.0, Mat(), 0.0, projections);
     for(int i = 0; i < data.rows; i++) {
-        Mat p = subspaceProject(d->m_eigenvectors, d->m_mean, data.row(i));
-        d->m_projections.push_back(p);
+        d->m_gallery.add(projections.row(i), labels[i]);
     }
 
     cout << "Fisherface - Training Done " << endl;
@@ -441,22 +698,53 @@ void Fisherfaces::training(vector<Face*>* faces, int no_principal_components){
 
 int Fisherfaces::testingID(IplImage *img){
 
-    Mat test = cvarrToMat(img);
-    Mat q = subspaceProject(d->m_eigenvectors, d->m_mean, test.reshape(1,1));
-    double minDist = DBL_MAX;
-    int outputClass = -1;
+    vector<IplImage*> images(1, img);
+    vector<int> rows;
+    Mat q = LibFaceUtils::projectImages(images, d->m_eigenvectors, d->m_mean, rows);
+    if(q.empty()) {
+        return -1;
+    }
+    int nearest = d->m_gallery.nearest(q);
+
+    return nearest >= 0 ? d->m_gallery.label(nearest) : -1;
+}
 
-    for(int i = 0; i < d->m_projections.size(); i++) {
+vector<int> Fisherfaces::testingIDs(const vector<IplImage*>& images) {
+    vector<int> result(images.size(), -1);
 
-        double distance = norm(d->m_projections[i], q, NORM_L2);
+    vector<int> rows;
+    Mat queries = LibFaceUtils::projectImages(images, d->m_eigenvectors, d->m_mean, rows);
+    if(queries.empty()) {
+        return result;
+    }
 
-        if(distance < minDist) {
-            minDist = distance;
-            outputClass = d->m_labels[i];
+    vector<int> nearest;
+    d->m_gallery.nearest(queries, nearest);
+
+    for(unsigned i = 0; i < images.size(); ++i) {
+        if(rows[i] >= 0 && nearest[rows[i]] >= 0) {
+            result[i] = d->m_gallery.label(nearest[rows[i]]);
         }
     }
 
-    return outputClass;
+    return result;
+}
+
+vector<pair<int, float> > Fisherfaces::testingTopK(IplImage* img, int k) {
+    vector<IplImage*> images(1, img);
+    vector<int> rows;
+    Mat q = LibFaceUtils::projectImages(images, d->m_eigenvectors, d->m_mean, rows);
+    if(q.empty()) {
+        return vector<pair<int, float> >();
+    }
+
+    vector<pair<int, float> > candidates = d->m_gallery.nearestLabels(q, k);
+
+    for(unsigned i = 0; i < candidates.size(); ++i) {
+        candidates[i].second = sqrt(candidates[i].second);
+    }
+
+    return candidates;
 }
 
 int Fisherfaces::saveConfig(const string& dir) {
@@ -474,7 +762,10 @@ int Fisherfaces::saveConfig(const string& dir) {
     // Start storing
     //unsigned int nIds = d->faceImgArr.size(), i;
 
-    unsigned int nIds = d->m_projections.size(), i;
+    // removed faces must not reach the file
+    d->compact(true);
+
+    unsigned int nIds = d->m_gallery.size(), i;
     cout << "Total: " << nIds << endl;
 
     // Write some initial params and matrices
@@ -482,12 +773,15 @@ int Fisherfaces::saveConfig(const string& dir) {
     cvWriteInt( fileStorage, "FACE_WIDTH", d->FACE_WIDTH);
     cvWriteInt( fileStorage, "FACE_HEIGHT", d->FACE_HEIGHT);
     cvWriteReal( fileStorage, "THRESHOLD", d->THRESHOLD);
+    cvWriteReal( fileStorage, "MAHALANOBIS_THRESHOLD", d->MAHALANOBIS_THRESHOLD);
+    cvWriteReal( fileStorage, "COSINE_THRESHOLD", d->COSINE_THRESHOLD);
 
     // Write all the training faces
     for ( i = 0; i < nIds; i++ ) {
         char facename[200];
         sprintf(facename, "person_%d", i);
-        IplImage tmp = d->m_projections.at(i);
+        Mat projection = d->m_gallery.projection(i);
+        IplImage tmp   = projection;
         cvWrite(fileStorage, facename, &tmp, cvAttrList(0,0));
     }
 
@@ -505,11 +799,13 @@ int Fisherfaces::saveConfig(const string& dir) {
     for ( i = 0; i < nIds; i++ ) {
         char idname[200];
         sprintf(idname, "id_%d", i);
-        cvWriteInt(fileStorage, idname, d->m_labels.at(i));
+        cvWriteInt(fileStorage, idname, d->m_gallery.label(i));
     }
 
     // Release the fileStorage
     cvReleaseFileStorage(&fileStorage);
+
+    d->m_gallery.saveIndex(d->configFile + ".hnsw");
     return 0;
 }
 
@@ -531,6 +827,9 @@ int Fisherfaces::update(vector<Face*>* newFaceArr) {
             LOG(libfaceDEBUG) << "Has no specified ID.";
 
             int newId = d->faceImgArr.size();
+            while(find(d->indexMap.begin(), d->indexMap.end(), newId) != d->indexMap.end()) {
+                ++newId;    // removed IDs leave gaps
+            }
 
             // We now have the greatest unoccupied ID.
             LOG(libfaceDEBUG) << "Giving it the ID = " << newId;
@@ -550,11 +849,12 @@ int Fisherfaces::update(vector<Face*>* newFaceArr) {
 
             vector<int>::iterator it = find(d->indexMap.begin(), d->indexMap.end(), id);//d->indexMap.
             if(it != d->indexMap.end()) {
-
-                LOG(libfaceDEBUG) << "Specified ID already exists in the DB, merging 2 together.";
-
-                //d->learn(*it, cvCloneImage(newFaceArr->at(i)->getFace()));
-
+                // the projection below joins the known faces of the ID, the image itself is not stored
+                if(d->m_eigenvectors.empty()) {
+                    LOG(libfaceWARNING) << "Specified ID already exists in the DB and there is no model, the face is not kept.";
+                } else {
+                    LOG(libfaceDEBUG) << "Specified ID already exists in the DB, adding the projection of the face to it.";
+                }
             } else {
                 // If this is a fresh ID, and not autoassigned
                 LOG(libfaceDEBUG) << "Specified ID does not exist in the DB, creating new face.";
@@ -566,6 +866,44 @@ int Fisherfaces::update(vector<Face*>* newFaceArr) {
         }
     }
 
+    // Once trained, new faces are matched against directly in the Fisher subspace
+    if(!d->m_eigenvectors.empty()) {
+        vector<IplImage*> images;
+        for (unsigned i = 0; i < newFaceArr->size() ; ++i) {
+            images.push_back(newFaceArr->at(i)->getFace());
+        }
+
+        vector<int> rows;
+        if(d->m_pcaVectors.empty()) {
+            // a loaded model has no scatter statistics, its discriminants stay as they are
+            Mat projections = LibFaceUtils::projectImages(images, d->m_eigenvectors, d->m_mean, rows);
+            for (unsigned i = 0; i < newFaceArr->size() ; ++i) {
+                if(rows[i] >= 0) {
+                    d->m_gallery.add(projections.row(rows[i]), newFaceArr->at(i)->getId());
+                }
+            }
+        } else {
+            // the faces join the scatter statistics and the gallery in the same order
+            Mat reduced = LibFaceUtils::projectImages(images, d->m_pcaVectors, d->m_mean, rows);
+            vector<int> labels;
+            for (unsigned i = 0; i < newFaceArr->size() ; ++i) {
+                if(rows[i] >= 0) {
+                    labels.push_back(newFaceArr->at(i)->getId());
+                }
+            }
+
+            if(!labels.empty()) {
+                Mat projections;
+                gemm(reduced, d->m_discriminants, 1.0, Mat(), 0.0, projections);
+                for (int i = 0; i < projections.rows; ++i) {
+                    d->m_gallery.add(projections.row(i), labels[i]);
+                }
+                d->accumulate(reduced, labels);
+                d->checkDrift();
+            }
+        }
+    }
+
     update = clock() - update;
 
     LOG(libfaceDEBUG) << "Updating took: " << (double)update / ((double)CLOCKS_PER_SEC) << "sec.";
@@ -573,4 +911,67 @@ int Fisherfaces::update(vector<Face*>* newFaceArr) {
     return 0;
 }
 
+int Fisherfaces::removeID(int id) {
+    if(!d->m_pcaVectors.empty()) {
+        const vector<int>& rows = d->m_gallery.rowsOf(id);
+        for(unsigned i = 0; i < rows.size(); ++i) {
+            d->subtract(rows[i]);
+        }
+    }
+
+    int found = d->forget(id) + d->m_gallery.removeLabel(id);
+
+    if(found == 0) {
+        LOG(libfaceWARNING) << "Fisherfaces::removeID : No faces of ID " << id << ".";
+        return 1;
+    }
+
+    d->compact(false);
+    d->checkDrift();
+    return 0;
+}
+
+int Fisherfaces::relabelID(int id, int newId) {
+    // the faces move to the class of the new ID, which may exist already. A merge changes the
+    // scatter like adding the moved faces does, a rename leaves it as it is.
+    const int moved  = d->m_gallery.rowsOf(id).size();
+    const bool merge = id != newId && !d->m_gallery.rowsOf(newId).empty();
+    d->m_core.relabel(id, newId);
+
+    int found = d->m_gallery.relabel(id, newId);
+    for(unsigned j = 0; j < d->indexMap.size(); ++j) {
+        if(d->indexMap[j] == id) {
+            d->indexMap[j] = newId;
+            ++found;
+        }
+    }
+
+    if(found == 0) {
+        LOG(libfaceWARNING) << "Fisherfaces::relabelID : No faces of ID " << id << ".";
+        return 1;
+    }
+
+    if(merge && !d->m_pcaVectors.empty()) {
+        d->m_changed += moved;
+        d->checkDrift();
+    }
+    return 0;
+}
+
+void Fisherfaces::setMatchingOptions(const MatchingOptions& options) {
+    d->m_gallery.setMatchingOptions(options);
+}
+
+MatchingOptions Fisherfaces::matchingOptions() const {
+    return d->m_gallery.matchingOptions();
+}
+
+void Fisherfaces::setTrainingOptions(const TrainingOptions& options) {
+    d->trainingOptions = options;
+}
+
+TrainingOptions Fisherfaces::trainingOptions() const {
+    return d->trainingOptions;
+}
+
 } // namespace libface
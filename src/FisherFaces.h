@@ -120,9 +120,15 @@ public:
      * Method to attempt to compare images with the known projected images. Uses a specified type of
      * distance to see how far away they are from each of the images in the projection.
      *
+     * The face is projected once through the combined PCA and LDA matrix and compared with the
+     * training projections.
+     *
      * @param input The pointer to IplImage* image, which is to be recognized.
      *
-     * @return A pair with ID and closeness of the closest face.
+     * @return A pair with ID and distance in the Fisher subspace of the closest face, (-1, -1) if it
+     * is farther than the threshold or the model is not trained. The distance and the threshold
+     * follow the matching mode: THRESHOLD of the config file for Euclidean distance,
+     * MAHALANOBIS_THRESHOLD and COSINE_THRESHOLD for the others, the cosine distance being at most 2.
      *
      */
     std::pair<int, float> recognize(IplImage* input);
@@ -142,8 +148,14 @@ public:
      *
      * If id is not -1 and a new id, then face is added to the end of the faces vector.
      *
-     * If id is not -1 and it already exist, then given the given faces is projected together with the
-     * known face at that position using eigen decomposition and the projected face is stored in it's place.
+     * If id is a known one, only the projection of the face is kept, so the face is dropped with a
+     * warning when the model is not trained.
+     *
+     * Once trained, every face is projected into the Fisher subspace and matched from then on. Its PCA
+     * coordinates join the class means and scatter matrices of the model, and the discriminants are
+     * solved again from those, without a new PCA, when the faces added or removed since reach
+     * TrainingOptions::refreshFraction of the faces they were computed from. A loaded model has no
+     * scatter statistics and keeps its discriminants.
      *
      * @param newFaceArr The vector of input Face objects
      *
@@ -165,6 +177,27 @@ public:
 
     int testingID(IplImage* img);
 
+    /**
+     * Recognizes a batch of faces. All faces are projected with one matrix product and compared with
+     * the training projections with a second one.
+     *
+     * @param images The face images to be recognized.
+     *
+     * @return The ID of the closest face for every image, -1 if its size does not match the training faces.
+     */
+    vector<int> testingIDs(const vector<IplImage*>& images);
+
+    /**
+     * Ranks the known people by the distance of their closest training face, in the same scan that
+     * testingID() does.
+     *
+     * @param img The face image to be recognized.
+     * @param k Maximum number of candidates.
+     *
+     * @return Up to k pairs of ID and Euclidean distance, closest first.
+     */
+    vector<pair<int, float> > testingTopK(IplImage* img, int k);
+
     string testingTag(IplImage* img)
     {
         string str;
@@ -174,6 +207,54 @@ public:
 
     TrainingRequirement getTrainingRequirement();
 
+    /**
+     * Forgets the faces and projections of an ID. The projections are only marked as removed, the
+     * gallery is compacted once a quarter of it is removed and before the config is saved. The
+     * Fisher subspace keeps what it learned from the faces until the next training.
+     *
+     * @param id The ID.
+     *
+     * @return 0 on success, 1 if the ID is unknown.
+     */
+    int removeID(int id);
+
+    /**
+     * Gives the faces and projections of an ID another one, merging them with those of newId. The
+     * faces of a merge count as changed towards TrainingOptions::refreshFraction.
+     *
+     * @param id The ID to change.
+     * @param newId Its new value.
+     *
+     * @return 0 on success, 1 if the ID is unknown.
+     */
+    int relabelID(int id, int newId);
+
+    /**
+     * Sets how the training projections are searched. With approximate matching an HNSW index is
+     * built over them and saved next to the config file. The discriminants are whitened by the
+     * within-class scatter already, so Mahalanobis distance equals Euclidean distance here.
+     *
+     * @param options The matching options.
+     */
+    void setMatchingOptions(const MatchingOptions& options);
+
+    /**
+     * @return The matching options.
+     */
+    MatchingOptions matchingOptions() const;
+
+    /**
+     * Sets how training computes the model. Only the number of threads applies to Fisherfaces.
+     *
+     * @param options The training options.
+     */
+    void setTrainingOptions(const TrainingOptions& options);
+
+    /**
+     * @return The training options.
+     */
+    TrainingOptions trainingOptions() const;
+
 private:
 
     class FisherfacesPriv;
@@ -0,0 +1,418 @@
+/** ===========================================================
+ * @file FixedPointCascade.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Haar cascade evaluation in integer arithmetic.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "FixedPointCascade.h"
+
+// LibFace headers
+#include "Log.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+// C headers
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+using namespace std;
+
+namespace libface {
+
+namespace {
+
+// Number of fractional bits of the quantized values
+const int WEIGHT_BITS    = 12;   // Rectangle weights
+const int THRESHOLD_BITS = 20;   // Node thresholds, relative to the normalisation factor
+const int ALPHA_BITS     = 16;   // Leaf values and stage thresholds
+
+inline int64_t quantize(double value, int bits) {
+    return (int64_t)floor(value * (double)((int64_t)1 << bits) + 0.5);
+}
+
+/**
+ * Integer square root, rounded down.
+ */
+inline uint32_t isqrt(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit  = (uint64_t)1 << 62;
+    while(bit > value) {
+        bit >>= 2;
+    }
+    while(bit) {
+        if(value >= root + bit) {
+            value -= root + bit;
+            root   = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * One tree node as stored in the cascade, independent of the scale.
+ */
+struct NodeTemplate {
+    CvRect  rect[CV_HAAR_FEATURE_MAX];
+    float   weight[CV_HAAR_FEATURE_MAX];
+    int     rectCount;
+    int64_t threshold;   // Q20
+    int     left;        // > 0: next node of the same tree, <= 0: -index of the leaf value
+    int     right;
+};
+
+struct ClassifierInfo {
+    int firstNode;
+    int firstAlpha;
+};
+
+struct StageInfo {
+    int     firstClassifier;
+    int     count;
+    int32_t threshold;   // Q16
+};
+
+/**
+ * Rectangle of a node at one scale, as the four corner offsets into the integral image relative
+ * to the window origin.
+ */
+struct ScaledRect {
+    int     p0, p1, p2, p3;
+    int32_t weight;      // Q12
+};
+
+struct ScaledNode {
+    ScaledRect rect[CV_HAAR_FEATURE_MAX];
+    int        rectCount;
+};
+
+/**
+ * Integral images of one input image.
+ */
+struct Integral {
+
+    Integral(const IplImage* gray) : stride(gray->width + 1), sum((gray->width + 1) * (gray->height + 1), 0),
+                                     sqsum((gray->width + 1) * (gray->height + 1), 0) {
+        for(int y = 0; y < gray->height; ++y) {
+            const unsigned char* row = (const unsigned char*)(gray->imageData + y * gray->widthStep);
+            uint32_t rowSum   = 0;
+            uint64_t rowSqsum = 0;
+            int above         = y * stride;
+            int current       = above + stride;
+            for(int x = 0; x < gray->width; ++x) {
+                rowSum   += row[x];
+                rowSqsum += (uint32_t)row[x] * row[x];
+                // 32-bit sums may wrap around, rectangle sums are still exact
+                sum[current + x + 1]   = sum[above + x + 1] + rowSum;
+                sqsum[current + x + 1] = sqsum[above + x + 1] + rowSqsum;
+            }
+        }
+    }
+
+    inline uint32_t rectSum(int offset, int p0, int p1, int p2, int p3) const {
+        return sum[offset + p0] - sum[offset + p1] - sum[offset + p2] + sum[offset + p3];
+    }
+
+    inline uint64_t rectSqsum(int offset, int p0, int p1, int p2, int p3) const {
+        return sqsum[offset + p0] - sqsum[offset + p1] - sqsum[offset + p2] + sqsum[offset + p3];
+    }
+
+    int              stride;
+    vector<uint32_t> sum;
+    vector<uint64_t> sqsum;
+};
+
+inline int roundScaled(int value, double factor) {
+    return cvRound(value * factor);
+}
+
+} // namespace
+
+class FixedPointCascade::FixedPointCascadePriv {
+
+public:
+
+    FixedPointCascadePriv() : valid(false), windowSize(cvSize(0, 0)) {}
+
+    /**
+     * Converts the cascade into the quantized tables.
+     *
+     * @return False if the cascade uses features that are not supported.
+     */
+    bool load(const CvHaarClassifierCascade* cascade);
+
+    /**
+     * Scales the feature rectangles of all nodes.
+     *
+     * @param factor Scale of the detection window.
+     * @param stride Row length of the integral image.
+     * @param nodes Receives one scaled node per node template.
+     */
+    void scaleNodes(double factor, int stride, vector<ScaledNode>& nodes) const;
+
+    /**
+     * Runs all stages on one window.
+     *
+     * @return True if the window passes every stage.
+     */
+    bool evaluate(const Integral& integral, int offset, const vector<ScaledNode>& nodes, uint32_t norm) const;
+
+    bool                   valid;
+    CvSize                 windowSize;
+    vector<NodeTemplate>   nodes;
+    vector<int32_t>        alphas;        // Q16
+    vector<ClassifierInfo> classifiers;
+    vector<StageInfo>      stages;
+};
+
+bool FixedPointCascade::FixedPointCascadePriv::load(const CvHaarClassifierCascade* cascade) {
+    if(!cascade || cascade->count <= 0) {
+        LOG(libfaceERROR) << "FixedPointCascade : No cascade given.";
+        return false;
+    }
+
+    windowSize = cascade->orig_window_size;
+
+    for(int i = 0; i < cascade->count; ++i) {
+        const CvHaarStageClassifier& stage = cascade->stage_classifier[i];
+        if(stage.next != -1) {
+            LOG(libfaceWARNING) << "FixedPointCascade : Tree structured cascades are not supported.";
+            return false;
+        }
+
+        StageInfo stageInfo;
+        stageInfo.firstClassifier = classifiers.size();
+        stageInfo.count           = stage.count;
+        stageInfo.threshold       = (int32_t)quantize(stage.threshold, ALPHA_BITS);
+        stages.push_back(stageInfo);
+
+        for(int j = 0; j < stage.count; ++j) {
+            const CvHaarClassifier& classifier = stage.classifier[j];
+
+            ClassifierInfo info;
+            info.firstNode  = nodes.size();
+            info.firstAlpha = alphas.size();
+            classifiers.push_back(info);
+
+            for(int k = 0; k < classifier.count; ++k) {
+                const CvHaarFeature& feature = classifier.haar_feature[k];
+                if(feature.tilted) {
+                    LOG(libfaceWARNING) << "FixedPointCascade : Tilted features are not supported.";
+                    return false;
+                }
+
+                NodeTemplate node;
+                node.rectCount = 0;
+                for(int r = 0; r < CV_HAAR_FEATURE_MAX && feature.rect[r].weight != 0; ++r) {
+                    node.rect[r]   = feature.rect[r].r;
+                    node.weight[r] = feature.rect[r].weight;
+                    ++node.rectCount;
+                }
+                node.threshold = quantize(classifier.threshold[k], THRESHOLD_BITS);
+                node.left      = classifier.left[k];
+                node.right     = classifier.right[k];
+                nodes.push_back(node);
+            }
+
+            // a tree with n nodes has n + 1 leaves
+            for(int k = 0; k <= classifier.count; ++k) {
+                alphas.push_back((int32_t)quantize(classifier.alpha[k], ALPHA_BITS));
+            }
+        }
+    }
+
+    return true;
+}
+
+void FixedPointCascade::FixedPointCascadePriv::scaleNodes(double factor, int stride, vector<ScaledNode>& scaled) const {
+    scaled.resize(nodes.size());
+
+    for(unsigned i = 0; i < nodes.size(); ++i) {
+        const NodeTemplate& node = nodes.at(i);
+        ScaledNode& target       = scaled[i];
+        target.rectCount         = node.rectCount;
+
+        // Like OpenCV, correct the weight of the first rectangle so that the feature of a flat
+        // patch stays zero after the rectangles have been rounded.
+        double sum0  = 0.0;
+        double area0 = 0.0;
+        for(int r = 0; r < node.rectCount; ++r) {
+            int x = roundScaled(node.rect[r].x, factor);
+            int y = roundScaled(node.rect[r].y, factor);
+            int w = roundScaled(node.rect[r].width, factor);
+            int h = roundScaled(node.rect[r].height, factor);
+
+            ScaledRect& rect = target.rect[r];
+            rect.p0          = y * stride + x;
+            rect.p1          = y * stride + x + w;
+            rect.p2          = (y + h) * stride + x;
+            rect.p3          = (y + h) * stride + x + w;
+
+            if(r == 0) {
+                area0 = w * h;
+            } else {
+                sum0       += node.weight[r] * w * h;
+                rect.weight = (int32_t)quantize(node.weight[r], WEIGHT_BITS);
+            }
+        }
+        target.rect[0].weight = area0 > 0 ? (int32_t)quantize(-sum0 / area0, WEIGHT_BITS) : 0;
+    }
+}
+
+bool FixedPointCascade::FixedPointCascadePriv::evaluate(const Integral& integral, int offset, const vector<ScaledNode>& scaled, uint32_t norm) const {
+    for(unsigned s = 0; s < stages.size(); ++s) {
+        const StageInfo& stage = stages[s];
+        int32_t stageSum       = 0;
+
+        for(int c = stage.firstClassifier; c < stage.firstClassifier + stage.count; ++c) {
+            const ClassifierInfo& classifier = classifiers[c];
+            int idx                          = 0;
+            do {
+                const NodeTemplate& node = nodes[classifier.firstNode + idx];
+                const ScaledNode& rects  = scaled[classifier.firstNode + idx];
+
+                int64_t value = 0;
+                for(int r = 0; r < rects.rectCount; ++r) {
+                    const ScaledRect& rect = rects.rect[r];
+                    value += (int64_t)rect.weight * (int64_t)integral.rectSum(offset, rect.p0, rect.p1, rect.p2, rect.p3);
+                }
+
+                // both sides in Q20
+                idx = (value << (THRESHOLD_BITS - WEIGHT_BITS)) < node.threshold * (int64_t)norm ? node.left : node.right;
+            } while(idx > 0);
+
+            stageSum += alphas[classifier.firstAlpha - idx];
+        }
+
+        if(stageSum < stage.threshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
+FixedPointCascade::FixedPointCascade(const CvHaarClassifierCascade* cascade) : d(new FixedPointCascadePriv) {
+    d->valid = d->load(cascade);
+}
+
+FixedPointCascade::~FixedPointCascade() {
+    delete d;
+}
+
+bool FixedPointCascade::isValid() const {
+    return d->valid;
+}
+
+vector<CvAvgComp> FixedPointCascade::detectObjects(const IplImage* image, double scaleFactor, int minNeighbors, CvSize minSize) const {
+    vector<CvAvgComp> result;
+
+    if(!d->valid || !image || image->depth != IPL_DEPTH_8U || scaleFactor <= 1.0) {
+        LOG(libfaceERROR) << "FixedPointCascade::detectObjects : Invalid cascade, image or scale factor.";
+        return result;
+    }
+
+    IplImage* gray = 0;
+    if(image->nChannels == 3) {
+        gray = cvCreateImage(cvGetSize(image), IPL_DEPTH_8U, 1);
+        cvCvtColor(image, gray, CV_BGR2GRAY);
+    } else if(image->nChannels != 1) {
+        LOG(libfaceERROR) << "FixedPointCascade::detectObjects : Unsupported number of channels " << image->nChannels;
+        return result;
+    }
+
+    const Integral integral(gray ? gray : image);
+    const int width  = image->width;
+    const int height = image->height;
+
+    if(gray) {
+        cvReleaseImage(&gray);
+    }
+
+    vector<cv::Rect>   candidates;
+    vector<ScaledNode> scaled;
+
+    for(double factor = 1.0;
+        factor * d->windowSize.width < width - 10 && factor * d->windowSize.height < height - 10;
+        factor *= scaleFactor) {
+
+        const double step = std::max(2.0, factor);
+        CvSize window     = cvSize(cvRound(d->windowSize.width * factor), cvRound(d->windowSize.height * factor));
+        if(window.width < minSize.width || window.height < minSize.height) {
+            continue;
+        }
+
+        d->scaleNodes(factor, integral.stride, scaled);
+
+        // Variance normalisation window, the detection window without a one pixel border
+        int nx         = cvRound(factor);
+        int nw         = cvRound((d->windowSize.width - 2) * factor);
+        int nh         = cvRound((d->windowSize.height - 2) * factor);
+        int n0         = nx * integral.stride + nx;
+        int n1         = n0 + nw;
+        int n2         = n0 + nh * integral.stride;
+        int n3         = n2 + nw;
+        uint64_t area  = (uint64_t)nw * nh;
+
+        int endX = cvRound((width - window.width) / step);
+        int endY = cvRound((height - window.height) / step);
+
+        for(int iy = 0; iy < endY; ++iy) {
+            int y = cvRound(iy * step);
+            for(int ix = 0; ix < endX; ++ix) {
+                int x      = cvRound(ix * step);
+                int offset = y * integral.stride + x;
+
+                uint64_t sum   = integral.rectSum(offset, n0, n1, n2, n3);
+                uint64_t sqsum = integral.rectSqsum(offset, n0, n1, n2, n3);
+                uint64_t prod  = area * sqsum;
+                uint32_t norm  = prod > sum * sum ? isqrt(prod - sum * sum) : 0;
+
+                if(d->evaluate(integral, offset, scaled, norm)) {
+                    candidates.push_back(cv::Rect(x, y, window.width, window.height));
+                }
+            }
+        }
+    }
+
+    vector<int> neighbors(candidates.size(), 1);
+    if(minNeighbors > 0) {
+        cv::groupRectangles(candidates, neighbors, minNeighbors, 0.2);
+    }
+
+    for(unsigned i = 0; i < candidates.size(); ++i) {
+        CvAvgComp comp;
+        comp.rect      = cvRect(candidates[i].x, candidates[i].y, candidates[i].width, candidates[i].height);
+        comp.neighbors = neighbors[i];
+        result.push_back(comp);
+    }
+
+    return result;
+}
+
+} // namespace libface
@@ -0,0 +1,109 @@
+/** ===========================================================
+ * @file FixedPointCascade.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Haar cascade evaluation in integer arithmetic.
+ * @section DESCRIPTION
+ *
+ * Evaluates an old-format CvHaarClassifierCascade without any floating point work per window. The
+ * image sum is a 32-bit integral image (wrap-around arithmetic, exact for rectangle sums), the
+ * squared sum is 64-bit. Feature weights are quantized to Q12, node thresholds to Q20, and leaf
+ * values and stage thresholds to Q16. The variance normalisation of OpenCV is rearranged so that
+ * it only needs an integer square root per window:
+ *
+ *     sum(w_i * S_i) / A  <  t * sqrt(Q/A - (S/A)^2)   <=>   sum(w_i * S_i)  <  t * sqrt(A*Q - S^2)
+ *
+ * where A is the area of the normalisation window, S and Q its sum and squared sum.
+ *
+ * The scan follows cvHaarDetectObjects (same scales, steps, rounding and rectangle grouping), but
+ * does no Canny pruning. Detections therefore match the floating point path within a tolerance:
+ * on examples/database at least 90% of the faces found by one path are found by the other, with
+ * corners that differ by less than 20% of the face width (the grouping epsilon of OpenCV).
+ *
+ * Cascades with tilted features are not supported, see isValid().
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _FIXEDPOINTCASCADE_H_
+#define _FIXEDPOINTCASCADE_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#if defined (__APPLE__)
+#include <cv.h>
+#else
+#include <opencv/cv.h>
+#endif
+
+// C headers
+#include <vector>
+
+namespace libface
+{
+
+class FACEAPI FixedPointCascade
+{
+public:
+
+    /**
+     * Constructor. Quantizes the cascade, which is not referenced afterwards.
+     *
+     * @param cascade Cascade as loaded by cvLoad().
+     */
+    explicit FixedPointCascade(const CvHaarClassifierCascade* cascade);
+
+    /**
+     * Destructor.
+     */
+    ~FixedPointCascade();
+
+    /**
+     * @return False if the cascade could not be converted, e.g. because it uses tilted features.
+     */
+    bool isValid() const;
+
+    /**
+     * Detects objects like cvHaarDetectObjects. This method does not modify the object, so it may
+     * be called from several threads at once.
+     *
+     * @param image 8-bit image, colour images are converted to grayscale.
+     * @param scaleFactor Factor between two successive scales, greater than 1.
+     * @param minNeighbors Minimum number of neighbouring detections to keep a group. 0 disables grouping.
+     * @param minSize Minimum object size.
+     *
+     * @return The detected objects, with the number of grouped detections in neighbors.
+     */
+    std::vector<CvAvgComp> detectObjects(const IplImage* image, double scaleFactor, int minNeighbors, CvSize minSize) const;
+
+private:
+
+    FixedPointCascade(const FixedPointCascade&);
+    FixedPointCascade& operator = (const FixedPointCascade&);
+
+    class FixedPointCascadePriv;
+    FixedPointCascadePriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _FIXEDPOINTCASCADE_H_ */
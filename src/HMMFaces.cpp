@@ -43,6 +43,7 @@
 #include "Face.h"
 #include "FaceDetect.h"
 #include "LibFaceUtils.h"
+#include "TopCandidates.h"
 
 // OpenCV headers
 #if defined (__APPLE__)
@@ -488,7 +489,13 @@ void HMMfaces::training(vector<Face*>* faces, int no_principal_components){
 
 int HMMfaces::testingID(IplImage* img){
 
-    float like_array[1000];
+    vector<pair<int, float> > candidates = testingTopK(img, 1);
+
+    return candidates.empty() ? -1 : candidates.front().first;
+}
+
+vector<pair<int, float> > HMMfaces::testingTopK(IplImage* img, int k){
+
     IplImage* ipl = img;
 
     int first = ipl->width;
@@ -505,34 +512,19 @@ int HMMfaces::testingID(IplImage* img){
 
     cvImgToObs_DCT( ipl, obsInfo->obs, d->m_dctSize, d->m_obsSize, d->m_delta );
 
+    // Keep the k most likely persons while scoring, instead of sorting all likelihoods afterwards
+    TopCandidates candidates(k, true);
+
     for( int i = 0 ; i < d->indexMap.size() ; i++ )
     {
         CvEHMM* hmm = d->m_hmm.at(i)->GetIppiEHMM();
         cvEstimateObsProb( obsInfo, hmm );
-        like_array[i] = cvEViterbi( obsInfo, hmm );
+        candidates.offer( d->indexMap.at(i), cvEViterbi( obsInfo, hmm ) );
     }
 
     cvReleaseObsInfo( &obsInfo );
 
-    int three_first[3];
-    for(int i = 0; i < MIN(3,d->indexMap.size()) ; i++ )
-    {
-        float maxl = -FLT_MAX;
-        int maxind = -1;
-
-        for( int j = 0; j < d->indexMap.size(); j++ )
-        {
-            if (like_array[j] > maxl)
-            {
-                maxl = like_array[j];
-                maxind = d->indexMap.at(j);//j;
-            }
-        }
-        three_first[i] = maxind;
-        like_array[maxind] = -FLT_MAX;
-    }
-
-    return three_first[0];
+    return candidates.sorted();
 }
 
 string HMMfaces::testingTag(IplImage* img){
@@ -167,6 +167,17 @@ public:
      */
     int testingID(IplImage* img);
 
+    /**
+     * Ranks the known persons by the Viterbi log likelihood of their HMM, in the same pass that
+     * testingID() does.
+     *
+     * @param img The face image to be recognized.
+     * @param k Maximum number of candidates.
+     *
+     * @return Up to k pairs of ID and log likelihood, most likely first.
+     */
+    vector<pair<int, float> > testingTopK(IplImage* img, int k);
+
     /**
       * For tag name addition
       */
@@ -0,0 +1,536 @@
+/** ===========================================================
+ * @file HnswIndex.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Approximate nearest neighbour search over a ProjectionGallery.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "HnswIndex.h"
+
+// LibFace headers
+#include "Log.h"
+#include "DistanceKernels.h"
+#include "ProjectionGallery.h"
+
+// C headers
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+using namespace std;
+using namespace cv;
+
+namespace libface {
+
+namespace {
+
+const char MAGIC[8] = { 'L', 'F', 'H', 'N', 'S', 'W', '0', '1' };
+
+typedef pair<float, int> Candidate;   // squared distance, node
+
+} // namespace
+
+class HnswIndex::HnswIndexPriv {
+
+public:
+
+    HnswIndexPriv(int m, int efC, int efS) : M(std::max(2, m)), efConstruction(std::max(1, efC)), efSearch(std::max(1, efS)),
+                                             entry(-1), maxLevel(-1), seed(2463534242u), levels(), base(), upper(), visited(), epoch(0) {}
+
+    /**
+     * @return Number of links per node on layer 0.
+     */
+    int baseLinks() const {
+        return 2 * M;
+    }
+
+    /**
+     * @return Pointer to the link count of a node on a layer, followed by the links.
+     */
+    int* links(int node, int layer) {
+        if(layer == 0) {
+            return &base[(size_t)node * (1 + baseLinks())];
+        }
+        return &upper[node][(layer - 1) * (1 + M)];
+    }
+
+    const int* links(int node, int layer) const {
+        return const_cast<HnswIndexPriv*>(this)->links(node, layer);
+    }
+
+    /**
+     * @return True if every link count fits its layer, every link is a node and the entry is a node
+     * on the top layer, so that searching a loaded index stays within its arrays.
+     */
+    bool consistent() const;
+
+    /**
+     * Draws the top layer of a new node, exponentially distributed with scale 1/ln(M).
+     */
+    int randomLevel() {
+        // xorshift32, so that indices built from the same data are identical everywhere
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        double u = (seed + 1.0) / 4294967297.0;
+        return (int)(-log(u) / log((double)M));
+    }
+
+    /**
+     * Starts a new search, so that nodes visited by earlier ones count as unvisited.
+     */
+    void newEpoch() const {
+        if(visited.size() < levels.size()) {
+            visited.resize(levels.size(), 0);
+        }
+        if(++epoch == 0) {
+            std::fill(visited.begin(), visited.end(), 0u);
+            epoch = 1;
+        }
+    }
+
+    float distance(const ProjectionGallery& gallery, const float* q, int node) const {
+        return DistanceKernels::squaredDistance(q, gallery.row(node), gallery.stride());
+    }
+
+    /**
+     * Moves greedily towards the query on one layer.
+     */
+    Candidate greedy(const ProjectionGallery& gallery, const float* q, Candidate current, int layer) const;
+
+    /**
+     * Beam search on one layer.
+     *
+     * @param result Receives up to ef closest nodes, closest first.
+     */
+    void searchLayer(const ProjectionGallery& gallery, const float* q, const vector<Candidate>& entries, int ef, int layer, vector<Candidate>& result) const;
+
+    /**
+     * Picks up to m neighbours from candidates sorted by distance, skipping those closer to an already
+     * picked neighbour than to the base point. This keeps links pointing in different directions.
+     */
+    void selectNeighbours(const ProjectionGallery& gallery, const vector<Candidate>& candidates, int m, vector<int>& selected) const;
+
+    /**
+     * Sets the links of a node on a layer.
+     */
+    void setLinks(int node, int layer, const vector<int>& selected);
+
+    /**
+     * Adds a backward link, pruning the neighbour's links if it has too many.
+     */
+    void connect(const ProjectionGallery& gallery, int from, int to, int layer);
+
+    /**
+     * Inserts the next row of the gallery.
+     */
+    void insert(const ProjectionGallery& gallery);
+
+    int                   M;
+    int                   efConstruction;
+    int                   efSearch;
+
+    int                   entry;       // Node on the top layer
+    int                   maxLevel;
+    unsigned              seed;
+
+    vector<int>           levels;      // Top layer of every node
+    vector<int>           base;        // Layer 0, per node a count and 2M links
+    vector<vector<int> >  upper;       // Layers above 0, per node and layer a count and M links
+
+    mutable vector<unsigned> visited;  // Epoch in which a node was last visited
+    mutable unsigned         epoch;
+};
+
+Candidate HnswIndex::HnswIndexPriv::greedy(const ProjectionGallery& gallery, const float* q, Candidate current, int layer) const {
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        const int* l = links(current.second, layer);
+        for(int i = 1; i <= l[0]; ++i) {
+            float dist = distance(gallery, q, l[i]);
+            if(dist < current.first) {
+                current = Candidate(dist, l[i]);
+                changed = true;
+            }
+        }
+    }
+    return current;
+}
+
+void HnswIndex::HnswIndexPriv::searchLayer(const ProjectionGallery& gallery, const float* q, const vector<Candidate>& entries, int ef, int layer, vector<Candidate>& result) const {
+    newEpoch();
+
+    priority_queue<Candidate, vector<Candidate>, greater<Candidate> > candidates;   // closest on top
+    priority_queue<Candidate>                                          nearest;      // farthest on top
+
+    for(unsigned i = 0; i < entries.size(); ++i) {
+        visited[entries[i].second] = epoch;
+        candidates.push(entries[i]);
+        nearest.push(entries[i]);
+    }
+    while((int)nearest.size() > ef) {
+        nearest.pop();
+    }
+
+    while(!candidates.empty()) {
+        Candidate c = candidates.top();
+        if(c.first > nearest.top().first && (int)nearest.size() >= ef) {
+            break;
+        }
+        candidates.pop();
+
+        const int* l = links(c.second, layer);
+        for(int i = 1; i <= l[0]; ++i) {
+            int n = l[i];
+            if(visited[n] == epoch) {
+                continue;
+            }
+            visited[n] = epoch;
+
+            float dist = distance(gallery, q, n);
+            if((int)nearest.size() < ef || dist < nearest.top().first) {
+                candidates.push(Candidate(dist, n));
+                nearest.push(Candidate(dist, n));
+                if((int)nearest.size() > ef) {
+                    nearest.pop();
+                }
+            }
+        }
+    }
+
+    result.resize(nearest.size());
+    for(int i = (int)result.size() - 1; i >= 0; --i) {
+        result[i] = nearest.top();
+        nearest.pop();
+    }
+}
+
+void HnswIndex::HnswIndexPriv::selectNeighbours(const ProjectionGallery& gallery, const vector<Candidate>& candidates, int m, vector<int>& selected) const {
+    selected.clear();
+    for(unsigned i = 0; i < candidates.size() && (int)selected.size() < m; ++i) {
+        const float* c = gallery.row(candidates[i].second);
+        bool keep      = true;
+        for(unsigned j = 0; j < selected.size(); ++j) {
+            if(DistanceKernels::squaredDistance(c, gallery.row(selected[j]), gallery.stride()) < candidates[i].first) {
+                keep = false;
+                break;
+            }
+        }
+        if(keep) {
+            selected.push_back(candidates[i].second);
+        }
+    }
+}
+
+void HnswIndex::HnswIndexPriv::setLinks(int node, int layer, const vector<int>& selected) {
+    int* l = links(node, layer);
+    l[0]   = (int)selected.size();
+    for(unsigned i = 0; i < selected.size(); ++i) {
+        l[i + 1] = selected[i];
+    }
+}
+
+void HnswIndex::HnswIndexPriv::connect(const ProjectionGallery& gallery, int from, int to, int layer) {
+    int* l       = links(from, layer);
+    int capacity = layer == 0 ? baseLinks() : M;
+
+    if(l[0] < capacity) {
+        l[++l[0]] = to;
+        return;
+    }
+
+    // too many links, keep the best spread of the old ones and the new one
+    const float* p = gallery.row(from);
+    vector<Candidate> candidates;
+    candidates.reserve(capacity + 1);
+    for(int i = 1; i <= l[0]; ++i) {
+        candidates.push_back(Candidate(DistanceKernels::squaredDistance(p, gallery.row(l[i]), gallery.stride()), l[i]));
+    }
+    candidates.push_back(Candidate(DistanceKernels::squaredDistance(p, gallery.row(to), gallery.stride()), to));
+    std::sort(candidates.begin(), candidates.end());
+
+    vector<int> selected;
+    selectNeighbours(gallery, candidates, capacity, selected);
+    setLinks(from, layer, selected);
+}
+
+void HnswIndex::HnswIndexPriv::insert(const ProjectionGallery& gallery) {
+    const int node  = (int)levels.size();
+    const int level = randomLevel();
+
+    levels.push_back(level);
+    base.resize(base.size() + 1 + baseLinks(), 0);
+    upper.push_back(vector<int>((size_t)level * (1 + M), 0));
+
+    if(entry < 0) {
+        entry    = node;
+        maxLevel = level;
+        return;
+    }
+
+    const float* q    = gallery.row(node);
+    Candidate current = Candidate(distance(gallery, q, entry), entry);
+
+    for(int layer = maxLevel; layer > level; --layer) {
+        current = greedy(gallery, q, current, layer);
+    }
+
+    vector<Candidate> entries(1, current);
+    vector<Candidate> found;
+    vector<int>       selected;
+    for(int layer = std::min(level, maxLevel); layer >= 0; --layer) {
+        searchLayer(gallery, q, entries, efConstruction, layer, found);
+        selectNeighbours(gallery, found, layer == 0 ? baseLinks() : M, selected);
+        setLinks(node, layer, selected);
+        for(unsigned i = 0; i < selected.size(); ++i) {
+            connect(gallery, selected[i], node, layer);
+        }
+        entries = found;
+    }
+
+    if(level > maxLevel) {
+        entry    = node;
+        maxLevel = level;
+    }
+}
+
+bool HnswIndex::HnswIndexPriv::consistent() const {
+    const int n = (int)levels.size();
+    if(n == 0) {
+        return entry == -1;
+    }
+    if(entry < 0 || entry >= n || levels[entry] != maxLevel) {
+        return false;
+    }
+
+    for(int node = 0; node < n; ++node) {
+        for(int layer = 0; layer <= levels[node]; ++layer) {
+            const int* l  = links(node, layer);
+            const int cap = layer == 0 ? baseLinks() : M;
+            if(l[0] < 0 || l[0] > cap) {
+                return false;
+            }
+            for(int j = 1; j <= l[0]; ++j) {
+                if(l[j] < 0 || l[j] >= n) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+HnswIndex::HnswIndex(int neighbours, int efConstruction, int efSearch) : d(new HnswIndexPriv(neighbours, efConstruction, efSearch)) {}
+
+HnswIndex::HnswIndex(const HnswIndex& that) : d(new HnswIndexPriv(*that.d)) {}
+
+HnswIndex& HnswIndex::operator = (const HnswIndex& that) {
+    if(this != &that) {
+        *d = *that.d;
+    }
+    return *this;
+}
+
+HnswIndex::~HnswIndex() {
+    delete d;
+}
+
+void HnswIndex::clear() {
+    d->entry    = -1;
+    d->maxLevel = -1;
+    d->seed     = 2463534242u;
+    d->levels.clear();
+    d->base.clear();
+    d->upper.clear();
+    d->visited.clear();
+    d->epoch    = 0;
+}
+
+void HnswIndex::setBuildParameters(int neighbours, int efConstruction) {
+    neighbours     = std::max(2, neighbours);
+    efConstruction = std::max(1, efConstruction);
+    if(neighbours != d->M || efConstruction != d->efConstruction) {
+        clear();
+        d->M              = neighbours;
+        d->efConstruction = efConstruction;
+    }
+}
+
+int HnswIndex::neighbours() const {
+    return d->M;
+}
+
+int HnswIndex::efConstruction() const {
+    return d->efConstruction;
+}
+
+void HnswIndex::setEfSearch(int value) {
+    d->efSearch = std::max(1, value);
+}
+
+int HnswIndex::efSearch() const {
+    return d->efSearch;
+}
+
+int HnswIndex::size() const {
+    return (int)d->levels.size();
+}
+
+void HnswIndex::build(const ProjectionGallery& gallery) {
+    clear();
+    update(gallery);
+}
+
+void HnswIndex::update(const ProjectionGallery& gallery) {
+    if(gallery.size() < size()) {
+        LOG(libfaceWARNING) << "HnswIndex::update : The gallery has shrunk, rebuilding the index.";
+        clear();
+    }
+
+    d->levels.reserve(gallery.size());
+    d->base.reserve((size_t)gallery.size() * (1 + d->baseLinks()));
+    d->upper.reserve(gallery.size());
+
+    while(size() < gallery.size()) {
+        d->insert(gallery);
+    }
+}
+
+vector<pair<int, float> > HnswIndex::search(const ProjectionGallery& gallery, const Mat& query, int k) const {
+    vector<pair<int, float> > result;
+    if(d->entry < 0 || k <= 0) {
+        return result;
+    }
+    if(gallery.size() < size()) {
+        LOG(libfaceERROR) << "HnswIndex::search : The index does not belong to this gallery.";
+        return result;
+    }
+
+    vector<float> buffer;
+    const float* q = gallery.padQuery(query, buffer);
+    if(!q) {
+        LOG(libfaceERROR) << "HnswIndex::search : Query of dimension " << query.total() << " does not match the gallery dimension " << gallery.dimension() << ".";
+        return result;
+    }
+
+    Candidate current = Candidate(d->distance(gallery, q, d->entry), d->entry);
+    for(int layer = d->maxLevel; layer > 0; --layer) {
+        current = d->greedy(gallery, q, current, layer);
+    }
+
+    vector<Candidate> found;
+    d->searchLayer(gallery, q, vector<Candidate>(1, current), std::max(d->efSearch, k), 0, found);
+
+    // removed projections still route the search, they are only left out of the results
+    for(unsigned i = 0; i < found.size() && (int)result.size() < k; ++i) {
+        if(!gallery.removed(found[i].second)) {
+            result.push_back(make_pair(found[i].second, found[i].first));
+        }
+    }
+    return result;
+}
+
+int HnswIndex::save(const string& file) const {
+    FILE* f = fopen(file.c_str(), "wb");
+    if(!f) {
+        LOG(libfaceERROR) << "HnswIndex::save : Can't open " << file << " for writing.";
+        return 1;
+    }
+
+    int header[7] = { size(), d->M, d->efConstruction, d->efSearch, d->maxLevel, d->entry, (int)d->seed };
+
+    bool ok = fwrite(MAGIC, sizeof(MAGIC), 1, f) == 1
+              && fwrite(header, sizeof(header), 1, f) == 1
+              && (d->levels.empty() || fwrite(&d->levels[0], sizeof(int), d->levels.size(), f) == d->levels.size())
+              && (d->base.empty() || fwrite(&d->base[0], sizeof(int), d->base.size(), f) == d->base.size());
+
+    for(unsigned i = 0; ok && i < d->upper.size(); ++i) {
+        if(!d->upper[i].empty()) {
+            ok = fwrite(&d->upper[i][0], sizeof(int), d->upper[i].size(), f) == d->upper[i].size();
+        }
+    }
+
+    if(fclose(f) != 0 || !ok) {
+        LOG(libfaceERROR) << "HnswIndex::save : Writing " << file << " failed.";
+        return 1;
+    }
+    return 0;
+}
+
+int HnswIndex::load(const string& file) {
+    clear();
+
+    FILE* f = fopen(file.c_str(), "rb");
+    if(!f) {
+        return 1;
+    }
+
+    char magic[sizeof(MAGIC)];
+    int header[7];
+    bool ok = fread(magic, sizeof(magic), 1, f) == 1
+              && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+              && fread(header, sizeof(header), 1, f) == 1
+              && header[0] >= 0 && header[1] >= 2 && header[5] < header[0];
+
+    if(ok) {
+        int n             = header[0];
+        d->M              = header[1];
+        d->efConstruction = header[2];
+        d->efSearch       = header[3];
+        d->maxLevel       = header[4];
+        d->entry          = header[5];
+        d->seed           = (unsigned)header[6];
+
+        d->levels.resize(n);
+        d->base.resize((size_t)n * (1 + d->baseLinks()));
+        d->upper.resize(n);
+
+        ok = (n == 0 || fread(&d->levels[0], sizeof(int), n, f) == (size_t)n)
+             && (n == 0 || fread(&d->base[0], sizeof(int), d->base.size(), f) == d->base.size());
+
+        for(int i = 0; ok && i < n; ++i) {
+            ok = d->levels[i] >= 0 && d->levels[i] <= d->maxLevel;
+            if(ok && d->levels[i] > 0) {
+                d->upper[i].resize((size_t)d->levels[i] * (1 + d->M));
+                ok = fread(&d->upper[i][0], sizeof(int), d->upper[i].size(), f) == d->upper[i].size();
+            }
+        }
+        ok = ok && d->consistent();
+    }
+
+    fclose(f);
+
+    if(!ok) {
+        LOG(libfaceWARNING) << "HnswIndex::load : " << file << " is not a valid index.";
+        clear();
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace libface
@@ -0,0 +1,179 @@
+/** ===========================================================
+ * @file HnswIndex.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Approximate nearest neighbour search over a ProjectionGallery.
+ * @section DESCRIPTION
+ *
+ * Hierarchical navigable small world graph (Malkov and Yashunin). Every projection is a node on
+ * layer 0 and, with exponentially decreasing probability, on the layers above. A query descends
+ * greedily from the single node on the top layer and then explores layer 0 with a beam of efSearch
+ * candidates, so it visits O(log n) nodes instead of all of them. Larger beams trade speed for recall.
+ *
+ * The index only stores the graph. Vectors are read from the gallery passed to every call, which
+ * must be the one the index was built over.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _HNSWINDEX_H_
+#define _HNSWINDEX_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+// C headers
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libface
+{
+
+class ProjectionGallery;
+
+class FACEAPI HnswIndex
+{
+public:
+
+    /**
+     * Constructor. Creates an empty index.
+     *
+     * @param neighbours Links per node on the upper layers, twice as many on layer 0. 12 to 48 are typical.
+     * @param efConstruction Beam width while inserting. Larger builds a better graph, more slowly.
+     * @param efSearch Beam width while searching. Larger gives better recall, more slowly.
+     */
+    HnswIndex(int neighbours = 16, int efConstruction = 200, int efSearch = 64);
+
+    /**
+     * Copy constructor.
+     *
+     * @param that Object to be copied.
+     */
+    HnswIndex(const HnswIndex& that);
+
+    /**
+     * Assignment operator.
+     *
+     * @param that Object to be copied.
+     *
+     * @return Reference to assignee.
+     */
+    HnswIndex& operator = (const HnswIndex& that);
+
+    /**
+     * Destructor.
+     */
+    ~HnswIndex();
+
+    /**
+     * Removes all nodes.
+     */
+    void clear();
+
+    /**
+     * Sets the build parameters. Changing them clears the index.
+     *
+     * @param neighbours Links per node on the upper layers.
+     * @param efConstruction Beam width while inserting.
+     */
+    void setBuildParameters(int neighbours, int efConstruction);
+
+    /**
+     * @return Links per node on the upper layers.
+     */
+    int neighbours() const;
+
+    /**
+     * @return Beam width while inserting.
+     */
+    int efConstruction() const;
+
+    /**
+     * @param value Beam width while searching, at least the number of requested results is used.
+     */
+    void setEfSearch(int value);
+
+    /**
+     * @return Beam width while searching.
+     */
+    int efSearch() const;
+
+    /**
+     * @return Number of indexed projections.
+     */
+    int size() const;
+
+    /**
+     * Indexes all projections of a gallery, replacing the current graph.
+     *
+     * @param gallery The gallery.
+     */
+    void build(const ProjectionGallery& gallery);
+
+    /**
+     * Indexes the projections of a gallery which were added since the last call, so the index can
+     * follow a growing gallery.
+     *
+     * @param gallery The gallery the index was built over.
+     */
+    void update(const ProjectionGallery& gallery);
+
+    /**
+     * Finds the approximately closest projections to a query.
+     *
+     * @param gallery The gallery the index was built over.
+     * @param query The projected query, a single row or column of gallery.dimension() elements, any depth.
+     * @param k Maximum number of results.
+     *
+     * @return Up to k pairs of gallery index and squared distance, closest first. Removed projections are left out.
+     */
+    std::vector<std::pair<int, float> > search(const ProjectionGallery& gallery, const cv::Mat& query, int k) const;
+
+    /**
+     * Writes the graph to a binary file.
+     *
+     * @param file Path of the file.
+     *
+     * @return 0 if the file was written, non-zero otherwise.
+     */
+    int save(const std::string& file) const;
+
+    /**
+     * Reads a graph written by save().
+     *
+     * @param file Path of the file.
+     *
+     * @return 0 if the file was read, non-zero otherwise. The index is empty on failure.
+     */
+    int load(const std::string& file);
+
+private:
+
+    class HnswIndexPriv;
+    HnswIndexPriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _HNSWINDEX_H_ */
@@ -0,0 +1,189 @@
+/** ===========================================================
+ * @file ImageBufferPool.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Recycles image buffers between detections.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "ImageBufferPool.h"
+
+// LibFace headers
+#include "Log.h"
+
+// C headers
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+namespace libface {
+
+namespace {
+
+// Smallest size class, 4 KB
+const int MIN_CLASS = 12;
+
+/**
+ * @return The exponent of the smallest power of two that holds bytes.
+ */
+int sizeClass(size_t bytes) {
+    int exponent = MIN_CLASS;
+    while(((size_t)1 << exponent) < bytes) {
+        ++exponent;
+    }
+    return exponent;
+}
+
+} // namespace
+
+ImageBufferStats::ImageBufferStats() : requests(0), reuses(0), bytesInUse(0), bytesCached(0), peakBytes(0) {}
+
+ImageBufferStats& ImageBufferStats::operator += (const ImageBufferStats& that) {
+    requests    += that.requests;
+    reuses      += that.reuses;
+    bytesInUse  += that.bytesInUse;
+    bytesCached += that.bytesCached;
+    peakBytes   += that.peakBytes;
+    return *this;
+}
+
+double ImageBufferStats::reuseRate() const {
+    return requests ? (double)reuses / (double)requests : 0.0;
+}
+
+class ImageBufferPool::ImageBufferPoolPriv {
+
+public:
+
+    ImageBufferPoolPriv(size_t max) : maxCachedBytes(max), cached(), inUse(), stats() {}
+
+    void updatePeak() {
+        stats.peakBytes = std::max(stats.peakBytes, stats.bytesInUse + stats.bytesCached);
+    }
+
+    size_t                     maxCachedBytes;
+    map<int, vector<char*> >   cached;   // Free buffers by size class
+    map<char*, int>            inUse;    // Size class of every buffer handed out
+    ImageBufferStats           stats;
+};
+
+ImageBufferPool::ImageBufferPool(size_t maxCachedBytes) : d(new ImageBufferPoolPriv(maxCachedBytes)) {}
+
+ImageBufferPool::~ImageBufferPool() {
+    clear();
+    if(!d->inUse.empty()) {
+        LOG(libfaceWARNING) << "ImageBufferPool : " << d->inUse.size() << " images were not released.";
+    }
+    delete d;
+}
+
+IplImage* ImageBufferPool::acquire(CvSize size, int depth, int channels) {
+    IplImage* image   = cvCreateImageHeader(size, depth, channels);
+    int cls           = sizeClass(image->imageSize);
+    size_t bytes      = (size_t)1 << cls;
+    char* buffer      = 0;
+
+    vector<char*>& freeList = d->cached[cls];
+    if(!freeList.empty()) {
+        buffer = freeList.back();
+        freeList.pop_back();
+        d->stats.bytesCached -= bytes;
+        ++d->stats.reuses;
+    } else {
+        buffer = (char*)cvAlloc(bytes);
+    }
+
+    ++d->stats.requests;
+    d->stats.bytesInUse += bytes;
+    d->updatePeak();
+    d->inUse[buffer] = cls;
+
+    cvSetData(image, buffer, image->widthStep);
+    return image;
+}
+
+IplImage* ImageBufferPool::clone(const IplImage* image) {
+    IplImage* copy = acquire(cvSize(image->width, image->height), image->depth, image->nChannels);
+    if(copy->widthStep == image->widthStep) {
+        memcpy(copy->imageData, image->imageData, image->imageSize);
+    } else {
+        int rowBytes = std::min(copy->widthStep, image->widthStep);
+        for(int y = 0; y < image->height; ++y) {
+            memcpy(copy->imageData + y * copy->widthStep, image->imageData + y * image->widthStep, rowBytes);
+        }
+    }
+    copy->origin = image->origin;
+    return copy;
+}
+
+void ImageBufferPool::release(IplImage** image) {
+    if(!image || !*image) {
+        return;
+    }
+
+    char* buffer                     = (*image)->imageData;
+    map<char*, int>::iterator it     = d->inUse.find(buffer);
+    if(it == d->inUse.end()) {
+        LOG(libfaceERROR) << "ImageBufferPool::release : Image was not acquired from this pool.";
+        return;
+    }
+
+    int cls      = it->second;
+    size_t bytes = (size_t)1 << cls;
+    d->inUse.erase(it);
+    d->stats.bytesInUse -= bytes;
+
+    if(d->stats.bytesCached + bytes <= d->maxCachedBytes) {
+        d->cached[cls].push_back(buffer);
+        d->stats.bytesCached += bytes;
+    } else {
+        cvFree(&buffer);
+    }
+
+    cvReleaseImageHeader(image);
+}
+
+void ImageBufferPool::clear() {
+    for(map<int, vector<char*> >::iterator it = d->cached.begin(); it != d->cached.end(); ++it) {
+        for(unsigned i = 0; i < it->second.size(); ++i) {
+            cvFree(&it->second[i]);
+        }
+    }
+    d->cached.clear();
+    d->stats.bytesCached = 0;
+}
+
+ImageBufferStats ImageBufferPool::stats() const {
+    return d->stats;
+}
+
+void ImageBufferPool::resetStats() {
+    d->stats.requests  = 0;
+    d->stats.reuses    = 0;
+    d->stats.peakBytes = d->stats.bytesInUse + d->stats.bytesCached;
+}
+
+} // namespace libface
@@ -0,0 +1,148 @@
+/** ===========================================================
+ * @file ImageBufferPool.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Recycles image buffers between detections.
+ * @section DESCRIPTION
+ *
+ * Buffers are grouped into size classes of powers of two bytes. A released buffer is kept and
+ * handed out again for any later image of the same class, so a long run over photos of mixed
+ * resolutions settles on a few buffers per class instead of allocating and freeing for every image.
+ *
+ * The pool is not thread-safe; like FaceDetect, every thread should use its own.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _IMAGEBUFFERPOOL_H_
+#define _IMAGEBUFFERPOOL_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#if defined (__APPLE__)
+#include <cv.h>
+#else
+#include <opencv/cv.h>
+#endif
+
+// C headers
+#include <cstddef>
+
+namespace libface
+{
+
+/**
+ * Usage counters of an ImageBufferPool.
+ */
+struct FACEAPI ImageBufferStats
+{
+    ImageBufferStats();
+
+    /**
+     * Adds the counters of another pool, e.g. of another worker thread. Peak values are added as
+     * well, which gives an upper bound of the combined peak.
+     */
+    ImageBufferStats& operator += (const ImageBufferStats& that);
+
+    /**
+     * @return Fraction of requests served with a recycled buffer, 0 if there were none.
+     */
+    double reuseRate() const;
+
+    long   requests;      // Number of images handed out
+    long   reuses;        // Requests served from a cached buffer
+    size_t bytesInUse;    // Bytes of the buffers currently handed out
+    size_t bytesCached;   // Bytes of the buffers waiting for reuse
+    size_t peakBytes;     // Maximum of bytesInUse + bytesCached
+};
+
+class FACEAPI ImageBufferPool
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param maxCachedBytes Released buffers are freed instead of cached beyond this limit.
+     */
+    explicit ImageBufferPool(size_t maxCachedBytes = 64 * 1024 * 1024);
+
+    /**
+     * Destructor. Frees the cached buffers. Images still handed out must not be used afterwards.
+     */
+    ~ImageBufferPool();
+
+    /**
+     * Returns an image with uninitialised pixels, using a cached buffer of the same size class if
+     * there is one.
+     *
+     * @param size Size of the image.
+     * @param depth Pixel depth, e.g. IPL_DEPTH_8U.
+     * @param channels Number of channels.
+     *
+     * @return The image, to be given back with release(). Never use cvReleaseImage() on it.
+     */
+    IplImage* acquire(CvSize size, int depth, int channels);
+
+    /**
+     * Like cvCloneImage, but with a pooled buffer. The ROI of the source is not copied.
+     *
+     * @param image Image to be copied.
+     *
+     * @return The copy, to be given back with release().
+     */
+    IplImage* clone(const IplImage* image);
+
+    /**
+     * Gives an image back to the pool and sets the pointer to 0.
+     *
+     * @param image Image obtained from acquire() or clone() of this pool.
+     */
+    void release(IplImage** image);
+
+    /**
+     * Frees all cached buffers.
+     */
+    void clear();
+
+    /**
+     * @return The current counters.
+     */
+    ImageBufferStats stats() const;
+
+    /**
+     * Resets requests, reuses and peakBytes.
+     */
+    void resetStats();
+
+private:
+
+    ImageBufferPool(const ImageBufferPool&);
+    ImageBufferPool& operator = (const ImageBufferPool&);
+
+    class ImageBufferPoolPriv;
+    ImageBufferPoolPriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _IMAGEBUFFERPOOL_H_ */
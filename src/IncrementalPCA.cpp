@@ -0,0 +1,120 @@
+/** ===========================================================
+ * @file IncrementalPCA.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Rank-k update of a truncated PCA with a batch of new samples.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "IncrementalPCA.h"
+
+// LibFace headers
+#include "Log.h"
+
+// C headers
+#include <algorithm>
+
+using namespace cv;
+
+namespace libface {
+
+int IncrementalPCA::update(Mat& mean, Mat& eigenvectors, Mat& eigenvalues, int& samples, const Mat& batch) {
+    const int d = eigenvectors.rows;
+    const int k = eigenvectors.cols;
+    const int m = batch.rows;
+
+    if(m == 0) {
+        return 0;
+    }
+    if(batch.cols != d || mean.cols != d || eigenvalues.total() != (size_t)k) {
+        LOG(libfaceERROR) << "IncrementalPCA : Samples of dimension " << batch.cols << " do not match the model.";
+        return 1;
+    }
+
+    const double n     = std::max(0, samples);
+    const double total = n + m;
+
+    // centre the batch on its own mean
+    Mat x, batchMean;
+    batch.convertTo(x, CV_64F);
+    reduce(x, batchMean, 0, CV_REDUCE_AVG);
+    for(int i = 0; i < m; ++i) {
+        Mat row = x.row(i);
+        row    -= batchMean;
+    }
+    Mat shift = batchMean - mean;
+
+    // new directions: the batch and the shift of the mean without their part in the old span
+    Mat e(m + 1, d, CV_64F);
+    Mat first = e.rowRange(0, m);
+    x.copyTo(first);
+    Mat last = e.row(m);
+    shift.copyTo(last);
+
+    const double scale = norm(e);
+    Mat inside;
+    gemm(e, eigenvectors, 1.0, Mat(), 0.0, inside);
+    e -= inside * eigenvectors.t();
+
+    Mat w, u, vt;
+    SVD::compute(e, w, u, vt);
+    int r = 0;
+    while(r < w.rows && w.at<double>(r) > scale * 1e-10) {
+        ++r;
+    }
+
+    // basis Q = [U, R] as rows
+    Mat q(k + r, d, CV_64F);
+    Mat oldRows = q.rowRange(0, k);
+    transpose(eigenvectors, oldRows);
+    if(r > 0) {
+        Mat newRows = q.rowRange(k, k + r);
+        vt.rowRange(0, r).copyTo(newRows);
+    }
+
+    // merged scatter in that basis: n Lambda + A^T A + n m / (n + m) b^T b
+    Mat a, b, small;
+    gemm(x, q, 1.0, Mat(), 0.0, a, GEMM_2_T);
+    gemm(shift, q, 1.0, Mat(), 0.0, b, GEMM_2_T);
+    mulTransposed(a, small, true);
+    small += b.t() * b * (n * m / total);
+    for(int i = 0; i < k; ++i) {
+        small.at<double>(i, i) += n * eigenvalues.at<double>(i);
+    }
+
+    Mat values, vectors;
+    eigen(small, values, vectors);
+
+    Mat rotated;
+    gemm(vectors.rowRange(0, k), q, 1.0, Mat(), 0.0, rotated);
+    transpose(rotated, eigenvectors);
+    eigenvalues = values.rowRange(0, k) / total;
+    mean        = (mean * n + batchMean * (double)m) / total;
+    samples    += m;
+
+    LOG(libfaceDEBUG) << "IncrementalPCA : Merged " << m << " samples, " << r << " new directions, " << samples << " samples in total.";
+
+    return 0;
+}
+
+} // namespace libface
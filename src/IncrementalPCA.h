@@ -0,0 +1,66 @@
+/** ===========================================================
+ * @file IncrementalPCA.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Rank-k update of a truncated PCA with a batch of new samples.
+ * @section DESCRIPTION
+ *
+ * A PCA of n samples, kept as mean, k eigenvectors and eigenvalues, is merged with m new samples
+ * without the old ones (Ross, Lim, Lin and Yang, 2008). The merged covariance lies in the span of
+ * the old eigenvectors, the centred new samples and the shift of the mean, which has at most
+ * k + m + 1 dimensions. It is decomposed there, so an update costs O(D (k + m)^2) for D pixels,
+ * independent of n. Variance outside the old k eigenvectors is lost, as in any truncated model.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _INCREMENTALPCA_H_
+#define _INCREMENTALPCA_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+namespace libface
+{
+
+class FACEAPI IncrementalPCA
+{
+public:
+
+    /**
+     * Merges new samples into a PCA. The number of components stays the same.
+     *
+     * @param mean The mean as a row, CV_64F, updated.
+     * @param eigenvectors The components as columns, D x k CV_64F, updated.
+     * @param eigenvalues The variances of the components as a column, CV_64F, updated.
+     * @param samples Number of samples n of the PCA, increased by the number of new samples.
+     * @param batch The new samples, one per row, of any depth.
+     *
+     * @return 0 on success, 1 if the sizes do not match.
+     */
+    static int update(cv::Mat& mean, cv::Mat& eigenvectors, cv::Mat& eigenvalues, int& samples, const cv::Mat& batch);
+};
+
+} // namespace libface
+
+#endif /* _INCREMENTALPCA_H_ */
@@ -38,12 +38,15 @@
 
 // LibFace headers
 #include "Log.h"
+#include "BatchDetect.h"
 #include "Eigenfaces.h"
 #include "FisherFaces.h"
 #include "HMMFaces.h"
 #include "Face.h"
 #include "FaceDetect.h"
+#include "FaceStream.h"
 #include "LibFaceUtils.h"
+#include "ScanPipeline.h"
 
 // OpenCV headers
 #if defined (__APPLE__)
@@ -105,6 +108,18 @@ public:
         return 120;
     }
 
+    /**
+     * Returns the batch detector, creating it from detectionCore on first use.
+     *
+     * @return BatchDetect matching the current detector settings, or 0 if there is no FaceDetect.
+     */
+    BatchDetect* batch();
+
+    /**
+     * Drops the batch detector, e.g. because the detector settings changed.
+     */
+    void resetBatch();
+
     Mode                    type;
     Identifier              idType;
     string                  cascadeDir;
@@ -112,11 +127,13 @@ public:
     LibFaceRecognitionCore* recognitionCore;
     IplImage*               lastImage;
     string                  lastFileName;
+    int                     detectionThreads;
+    BatchDetect*            batchDetect;    // Created lazily, holds copies of detectionCore
 
 };
 
 LibFace::LibFacePriv::LibFacePriv(Mode argType, Identifier id_type, const string& argConfigDir, const string& argCascadeDir)
-    : type(argType), idType(id_type), cascadeDir(), detectionCore(0), recognitionCore(0), lastImage(0), lastFileName()
+    : type(argType), idType(id_type), cascadeDir(), detectionCore(0), recognitionCore(0), lastImage(0), lastFileName(), detectionThreads(0), batchDetect(0)
 {
     // We don't need face recognition if we just want detection, and vice versa.
     // So there is a case for everything.
@@ -148,7 +165,7 @@ LibFace::LibFacePriv::LibFacePriv(Mode argType, Identifier id_type, const string
     }
 }
 
-LibFace::LibFacePriv::LibFacePriv(const LibFacePriv& that) : type(that.type), cascadeDir(that.cascadeDir), detectionCore(0), recognitionCore(0), lastImage(0), lastFileName(that.lastFileName) {
+LibFace::LibFacePriv::LibFacePriv(const LibFacePriv& that) : type(that.type), cascadeDir(that.cascadeDir), detectionCore(0), recognitionCore(0), lastImage(0), lastFileName(that.lastFileName), detectionThreads(that.detectionThreads), batchDetect(0) {
     // copy lastImage
     if(that.lastImage) {
         lastImage = cvCloneImage(that.lastImage);
@@ -197,6 +214,8 @@ LibFace::LibFacePriv& LibFace::LibFacePriv::operator = (const LibFacePriv& that)
     lastFileName = that.lastFileName;
     type = that.type;
     cascadeDir = that.cascadeDir;
+    detectionThreads = that.detectionThreads;
+    resetBatch();
 
     // release lastImage
     if(lastImage) {
@@ -270,6 +289,7 @@ LibFace::LibFacePriv& LibFace::LibFacePriv::operator = (const LibFacePriv& that)
 }
 
 LibFace::LibFacePriv::~LibFacePriv() {
+    delete batchDetect;
     delete detectionCore;
     delete recognitionCore;
     if(lastImage) {
@@ -277,6 +297,23 @@ LibFace::LibFacePriv::~LibFacePriv() {
     }
 }
 
+BatchDetect* LibFace::LibFacePriv::batch() {
+    if(!batchDetect) {
+        FaceDetect* detector = dynamic_cast<FaceDetect*>(detectionCore);
+        if(!detector) {
+            LOG(libfaceERROR) << "Batch detection requires detectionCore to be of type FaceDetect*.";
+            return 0;
+        }
+        batchDetect = new BatchDetect(*detector, detectionThreads);
+    }
+    return batchDetect;
+}
+
+void LibFace::LibFacePriv::resetBatch() {
+    delete batchDetect;
+    batchDetect = 0;
+}
+
 LibFace::LibFace(Mode type, Identifier id_type, const string &configDir, const string &cascadeDir):
     d(new LibFacePriv(type, id_type, configDir, cascadeDir))
 {
@@ -347,6 +384,65 @@ vector<Face*>* LibFace::detectFaces(const IplImage* image) {
     return d->detectionCore->detectFaces(image);
 }
 
+vector<vector<Face*>*> LibFace::detectFaces(const vector<string>& filenames) {
+    if(noDetection() || !d->batch()) {
+        vector<vector<Face*>*> result;
+        for(unsigned i = 0; i < filenames.size(); ++i) {
+            result.push_back(new vector<Face*>);
+        }
+        return result;
+    }
+    return d->batch()->detectFaces(filenames);
+}
+
+vector<vector<Face*>*> LibFace::detectFaces(const vector<const IplImage*>& images) {
+    if(noDetection() || !d->batch()) {
+        vector<vector<Face*>*> result;
+        for(unsigned i = 0; i < images.size(); ++i) {
+            result.push_back(new vector<Face*>);
+        }
+        return result;
+    }
+    return d->batch()->detectFaces(images);
+}
+
+void LibFace::detectFaces(const vector<string>& filenames, DetectionListener* listener) {
+    if(noDetection() || !d->batch()) {
+        return;
+    }
+    d->batch()->detectFaces(filenames, listener);
+}
+
+void LibFace::detectFaces(const vector<const IplImage*>& images, DetectionListener* listener) {
+    if(noDetection() || !d->batch()) {
+        return;
+    }
+    d->batch()->detectFaces(images, listener);
+}
+
+int LibFace::scanDirectory(const string& dir, DetectionListener* listener, int decodeThreads) {
+    FaceDetect* detector = dynamic_cast<FaceDetect*>(d->detectionCore);
+    if(noDetection() || !detector) {
+        return 0;
+    }
+    ScanPipeline pipeline(*detector, decodeThreads, d->detectionThreads);
+    return pipeline.scanDirectory(dir, listener);
+}
+
+void LibFace::setDetectionThreads(int threads) {
+    if(threads < 0) {
+        threads = 0;
+    }
+    if(threads != d->detectionThreads) {
+        d->detectionThreads = threads;
+        d->resetBatch();
+    }
+}
+
+int LibFace::detectionThreads() const {
+    return d->detectionThreads;
+}
+
 map<string,string> LibFace::getConfig() {
     map<string,string> result;
 
@@ -365,6 +461,49 @@ double LibFace::getDetectionAccuracy() const {
     return d->detectionCore->accuracy();
 }
 
+DetectionArithmetic LibFace::getDetectionArithmetic() const {
+    FaceDetect* detector = dynamic_cast<FaceDetect*>(d->detectionCore);
+    if(noDetection() || !detector) {
+        return FloatingPoint;
+    }
+    return detector->arithmetic();
+}
+
+ImageBufferStats LibFace::getDetectionBufferStats() const {
+    ImageBufferStats stats;
+    FaceDetect* detector = dynamic_cast<FaceDetect*>(d->detectionCore);
+    if(noDetection() || !detector) {
+        return stats;
+    }
+    stats = detector->bufferStats();
+    if(d->batchDetect) {
+        stats += d->batchDetect->bufferStats();
+    }
+    return stats;
+}
+
+int LibFace::getDetectionGrouping() const {
+    FaceDetect* detector = dynamic_cast<FaceDetect*>(d->detectionCore);
+    if(noDetection() || !detector) {
+        return 0;
+    }
+    return detector->grouping();
+}
+
+MatchingOptions LibFace::getMatchingOptions() const {
+    if(noRecognition()) {
+        return MatchingOptions();
+    }
+    return d->recognitionCore->matchingOptions();
+}
+
+TrainingOptions LibFace::getTrainingOptions() const {
+    if(noRecognition()) {
+        return TrainingOptions();
+    }
+    return d->recognitionCore->trainingOptions();
+}
+
 int LibFace::getRecommendedImageSizeForDetection(const CvSize&) const {
     return FaceDetect::getRecommendedImageSizeForDetection();
 }
@@ -531,22 +670,54 @@ void LibFace::training(vector<Face*>* faces, int scaleFactor){
 
 }
 
+int LibFace::trainingFromStream(FaceStream& stream, int no_principal_components){
+    if(noRecognition()) {
+        return 1;
+    }
+    return d->recognitionCore->trainingFromStream(stream, no_principal_components);
+}
+
+int LibFace::removeID(int id){
+    if(noRecognition()) {
+        return 1;
+    }
+    return d->recognitionCore->removeID(id);
+}
+
+int LibFace::relabelID(int id, int newId){
+    if(noRecognition()) {
+        return 1;
+    }
+    return d->recognitionCore->relabelID(id, newId);
+}
+
 vector<int> LibFace::testing(vector<Face*>* faces){
 
-    vector<int> result;
+    vector<IplImage*> images;
     int size = faces->size();
 
     for (int i = 0 ; i < size ; i++) {
+        images.push_back(faces->at(i)->getFace());
+    }
 
-        Face* face = faces->at(i);
-        IplImage* faceImg = face->getFace();
-        int res;
+    if(d->idType != ID) {
+        return vector<int>(size, -1);
+    }
+
+    // one batch, so the recognition core can project all faces together
+    return d->recognitionCore->testingIDs(images);
+}
 
-        if(d->idType == ID)
-            res = d->recognitionCore->testingID(faceImg);
+vector<vector<pair<int, float> > > LibFace::testingTopK(vector<Face*>* faces, int k){
 
+    vector<vector<pair<int, float> > > result(faces->size());
 
-        result.push_back(res);
+    if(noRecognition() || d->idType != ID) {
+        return result;
+    }
+
+    for (unsigned i = 0 ; i < faces->size() ; i++) {
+        result[i] = d->recognitionCore->testingTopK(faces->at(i)->getFace(), k);
     }
 
     return result;
@@ -565,7 +736,43 @@ void LibFace::setDetectionAccuracy(double value) {
         // cannot return here
     } else {
         d->detectionCore->setAccuracy(value);
+        // the workers hold copies of the detector
+        d->resetBatch();
+    }
+}
+
+void LibFace::setDetectionArithmetic(DetectionArithmetic value) {
+    FaceDetect* detector = dynamic_cast<FaceDetect*>(d->detectionCore);
+    if(noDetection() || !detector) {
+        return;
+    }
+    detector->setArithmetic(value);
+    // the workers hold copies of the detector
+    d->resetBatch();
+}
+
+void LibFace::setDetectionGrouping(int value) {
+    FaceDetect* detector = dynamic_cast<FaceDetect*>(d->detectionCore);
+    if(noDetection() || !detector) {
+        return;
+    }
+    detector->setGrouping(value);
+    // the workers hold copies of the detector
+    d->resetBatch();
+}
+
+void LibFace::setMatchingOptions(const MatchingOptions& options) {
+    if(noRecognition()) {
+        return;
+    }
+    d->recognitionCore->setMatchingOptions(options);
+}
+
+void LibFace::setTrainingOptions(const TrainingOptions& options) {
+    if(noRecognition()) {
+        return;
     }
+    d->recognitionCore->setTrainingOptions(options);
 }
 
 int LibFace::update(const IplImage* img, vector<Face*>* faces, int scaleFactor) {
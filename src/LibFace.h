@@ -38,6 +38,7 @@
 
 // LibFace headers
 #include "LibFaceCore.h"
+#include "ImageBufferPool.h"
 
 // C headers
 #include <map>
@@ -49,6 +50,7 @@ namespace libface {
 
 // forward declaration
 class Face;
+class DetectionListener;
 
 /** This defines that everything is initialised in libface, both detection and recognition.
  */
@@ -149,6 +151,68 @@ public:
      */
     std::vector<Face*>* detectFaces(const char* arr, int width, int height, int step, int depth = IPL_DEPTH_8U, int channels = 1, int scaleFactor=1);
 
+    /**
+     * Method for detecting faces in many images at once. The images are distributed over a pool of
+     * worker threads, each with its own copy of the detector, see setDetectionThreads().
+     *
+     * @param filenames Filenames of the images to find faces in.
+     *
+     * @return One vector of Face objects per file, in the same order as the filenames. The caller owns the vectors and faces.
+     */
+    std::vector<std::vector<Face*>*> detectFaces(const std::vector<std::string>& filenames);
+
+    /**
+     * Method for detecting faces in many images at once, see detectFaces(const std::vector<std::string>&).
+     *
+     * @param images Pointers to the IplImages for face detection.
+     *
+     * @return One vector of Face objects per image, in the same order as the images.
+     */
+    std::vector<std::vector<Face*>*> detectFaces(const std::vector<const IplImage*>& images);
+
+    /**
+     * Method for detecting faces in many images at once, handing the result of every image to the
+     * listener as soon as it is finished. Returns when all images have been processed.
+     *
+     * @param filenames Filenames of the images to find faces in.
+     * @param listener Receives the index of the file and its faces, in order of completion.
+     */
+    void detectFaces(const std::vector<std::string>& filenames, DetectionListener* listener);
+
+    /**
+     * Method for detecting faces in many images at once, see detectFaces(const std::vector<std::string>&, DetectionListener*).
+     *
+     * @param images Pointers to the IplImages for face detection.
+     * @param listener Receives the index of the image and its faces, in order of completion.
+     */
+    void detectFaces(const std::vector<const IplImage*>& images, DetectionListener* listener);
+
+    /**
+     * Method for detecting faces in all images of a directory. Loading and decoding of the files
+     * runs in its own threads and overlaps with detection, see ScanPipeline.
+     *
+     * @param dir Directory to be scanned, not recursively. Hidden files are skipped.
+     * @param listener Receives the index of the file in ScanPipeline::listImages(dir) and its faces.
+     * @param decodeThreads Number of threads loading and decoding files.
+     *
+     * @return Number of files scanned.
+     */
+    int scanDirectory(const std::string& dir, DetectionListener* listener, int decodeThreads = 1);
+
+    /**
+     * Set the number of worker threads used by the batch detection methods.
+     *
+     * @param threads Number of threads, 0 (default) uses one thread per processor core.
+     */
+    void setDetectionThreads(int threads);
+
+    /**
+     * Get the number of worker threads used by the batch detection methods.
+     *
+     * @return Number of threads, 0 means one thread per processor core.
+     */
+    int detectionThreads() const;
+
     /**
      * Method for getting the configuration from the face recognition. There is no configuration
      * for face detection. The config is returned as a mapping of strings to strings. Each key
@@ -168,6 +232,42 @@ public:
      */
     double getDetectionAccuracy() const;
 
+    /**
+     * Get the arithmetic used for face detection, see setDetectionArithmetic().
+     *
+     * @return FloatingPoint or FixedPoint.
+     */
+    DetectionArithmetic getDetectionArithmetic() const;
+
+    /**
+     * Get the usage of the image buffers that detection recycles between images, summed over the
+     * single image detector and the workers of the batch methods.
+     *
+     * @return Number of requests, reuse rate, bytes in use and peak bytes.
+     */
+    ImageBufferStats getDetectionBufferStats() const;
+
+    /**
+     * Get the detection grouping threshold, see setDetectionGrouping().
+     *
+     * @return Minimum number of neighbours, 0 if the detection accuracy decides.
+     */
+    int getDetectionGrouping() const;
+
+    /**
+     * Get how the recognition searches the training projections, see setMatchingOptions().
+     *
+     * @return The matching options.
+     */
+    MatchingOptions getMatchingOptions() const;
+
+    /**
+     * Get how training computes the recognition model, see setTrainingOptions().
+     *
+     * @return The training options.
+     */
+    TrainingOptions getTrainingOptions() const;
+
     /**
      * Returns the image size (one dimension) recommended for face detection.
      * Give the size of the available image, if possible.
@@ -287,6 +387,56 @@ public:
      */
     void setDetectionAccuracy(double value);
 
+    /**
+     * Set the arithmetic used for face detection. FixedPoint evaluates the cascades with integers
+     * only, which is faster on processors with weak floating point units, and finds the same faces
+     * within the tolerance documented in FixedPointCascade.h.
+     *
+     * @param value FloatingPoint (default) or FixedPoint.
+     */
+    void setDetectionArithmetic(DetectionArithmetic value);
+
+    /**
+     * Set the minimum number of neighbouring raw detections a face needs, overriding the value
+     * implied by the detection accuracy. Detected faces report their neighbour count through
+     * Face::getConfidence(), so one pass with a low value can be thresholded afterwards with
+     * FaceDetect::selectConfident() for several precision targets.
+     *
+     * @param value Minimum number of neighbours, 0 restores the accuracy default.
+     */
+    void setDetectionGrouping(int value);
+
+    /**
+     * Set how the recognition searches the training projections. The exact scan is the default. For
+     * galleries of millions of faces, MatchingOptions::approximate builds an HNSW graph after training,
+     * which answers queries in a fraction of the time at a small loss of recall, tuned by efSearch.
+     * Set this before loadConfig() to reuse a saved index. MatchingOptions::quantized instead scans
+     * 8 bit codes of the projections and compares the best rerank candidates exactly.
+     * MatchingOptions::centroids compares with the mean projection of every ID first and exactly with
+     * the projections of the closest probes IDs only, so the cost grows with the number of people.
+     * MatchingOptions::distance compares whitened projections, by Euclidean distance or by angle,
+     * which usually tells faces apart better than the default. The stored projections are whitened
+     * in place. Each mode has its own recognition threshold in the config file, as its distances
+     * have another scale: under DistanceCosine they are at most 2.
+     * The exact scan of large galleries is shared by MatchingOptions::threads threads.
+     *
+     * @param options The matching options.
+     */
+    void setMatchingOptions(const MatchingOptions& options);
+
+    /**
+     * Set how training computes the recognition model. For Eigenfaces, PCAAutomatic (the default)
+     * switches to a randomized solver whose time grows linearly with the number of faces when the
+     * number of principal components is much smaller than the number of faces and pixels. When
+     * training is not given a number of components, Eigenfaces keeps the fewest that explain
+     * TrainingOptions::energy of the variance, at most maxComponents. Eigenfaces and Fisherfaces
+     * compute, store and project in single precision unless TrainingOptions::doublePrecision is set,
+     * which takes twice the memory and about twice the time.
+     *
+     * @param options The training options.
+     */
+    void setTrainingOptions(const TrainingOptions& options);
+
     /**
      * Method to update the library with faces from the picture specified. The actual images of the faces are extracted from the specified picture according to the coordinates saved in the Face objects.
      *
@@ -345,11 +495,53 @@ public:
      */
     void training(std::vector<Face*>* faces, int scaleFactor =1);
 
+    /**
+     * Training from faces which are read from a stream, e.g. a DirectoryFaceStream, so that the
+     * memory does not grow with the number of faces. Only Eigenfaces supports this at the moment.
+     *
+     * @param stream The training faces.
+     * @param no_principal_components Number of components of the model, must be positive.
+     *
+     * @return 0 if training was successful.
+     */
+    int trainingFromStream(FaceStream& stream, int no_principal_components);
+
+    /**
+     * Forgets all faces of an ID without retraining, e.g. to honour a deletion request. They are no
+     * longer recognized right away and are left out of the next saveConfig().
+     *
+     * @param id The ID.
+     *
+     * @return 0 on success, non-zero if the ID is unknown.
+     */
+    int removeID(int id);
+
+    /**
+     * Gives all faces of an ID another one without retraining, merging them with those of newId if it
+     * is known already.
+     *
+     * @param id The ID to change.
+     * @param newId Its new value.
+     *
+     * @return 0 on success, non-zero if the ID is unknown.
+     */
+    int relabelID(int id, int newId);
+
     /**
      * New update - For Recognition testing
      */
     vector<int> testing(std::vector<Face*>* faces);
 
+    /**
+     * Ranks the known people for each face, e.g. to offer candidates for tagging.
+     *
+     * @param faces Pointer to a std::vector of Face objects.
+     * @param k Maximum number of candidates per face.
+     *
+     * @return For every face up to k pairs of ID and score, best first. See LibFaceRecognitionCore::testingTopK() for the meaning of the score.
+     */
+    vector<vector<pair<int, float> > > testingTopK(std::vector<Face*>* faces, int k);
+
 
 private:
 
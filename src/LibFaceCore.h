@@ -68,6 +68,79 @@ enum Identifier {
     TAG
 };
 
+/**
+ * Arithmetic used to evaluate the Haar cascades during face detection.
+ */
+enum DetectionArithmetic
+{
+    FloatingPoint,   // OpenCV's cvHaarDetectObjects
+    FixedPoint       // Integer evaluation, see FixedPointCascade
+};
+
+/**
+ * Distance between projected faces used for matching. The whitening of DistanceMahalanobis and
+ * DistanceCosine is folded into the projection: Eigenfaces scale every eigenvector by the inverse
+ * square root of its eigenvalue, the Fisherfaces discriminants are whitened by the within-class
+ * covariance already.
+ */
+enum DistanceMode
+{
+    DistanceEuclidean,     // Plain Euclidean distance of the projections
+    DistanceMahalanobis,   // Euclidean distance of the whitened projections
+    DistanceCosine         // Angle between the whitened projections, as the squared distance of unit vectors 2 - 2 cos
+};
+
+/**
+ * How the recognition engines search their training projections.
+ */
+struct MatchingOptions
+{
+    MatchingOptions() : approximate(false), neighbours(16), efConstruction(200), efSearch(64), quantized(false), rerank(32), centroids(false), probes(8),
+                        distance(DistanceEuclidean), threads(0), parallelRows(32768) {}
+
+    bool approximate;      // Search an HNSW graph (see HnswIndex) instead of scanning all projections
+    int  neighbours;       // Links per graph node, more gives better recall and a bigger index
+    int  efConstruction;   // Beam width while building the graph
+    int  efSearch;         // Beam width while searching, more gives better recall and slower queries
+    bool quantized;        // Scan 8 bit codes (see ScalarQuantizer) instead of the float projections, unless approximate; kept next to them
+    int  rerank;           // Candidates of the quantized scan compared exactly
+    bool centroids;        // Compare with the mean of every ID first (see ClassCentroidIndex), unless approximate
+    int  probes;           // IDs whose projections are compared exactly after the centroids
+    DistanceMode distance; // Metric of all searches, see DistanceMode
+    int  threads;          // Threads sharing the exact scan of one query, 0 for one per core
+    int  parallelRows;     // Galleries with fewer projections are scanned by the calling thread alone
+};
+
+/**
+ * Solver used to compute a PCA during training.
+ */
+enum PCASolver
+{
+    PCAAutomatic,    // Randomized if few components are kept from many faces, exact otherwise
+    PCAExact,        // cv::PCA
+    PCARandomized    // RandomizedPCA
+};
+
+/**
+ * How the recognition engines compute their model during training.
+ */
+struct TrainingOptions
+{
+    TrainingOptions() : solver(PCAAutomatic), oversampling(10), powerIterations(2), sketchRows(0), chunkSize(256), threads(0), driftThreshold(0.05), refreshFraction(0.05), energy(0.95), maxComponents(0), doublePrecision(false) {}
+
+    PCASolver solver;
+    int oversampling;       // Extra random directions of the randomized solver
+    int powerIterations;    // Power iterations of the randomized solver, more for slowly decaying spectra
+    int sketchRows;         // Directions kept by streaming training (see StreamingPCA), 0 for 2 (components + oversampling)
+    int chunkSize;          // Faces decoded at once by streaming training
+    int threads;            // Threads converting and projecting the training faces, 0 for one per core
+    double driftThreshold;  // Eigenfaces: rise of the unexplained energy of enrolled faces over the training faces which updates the eigenspace, 0 never
+    double refreshFraction; // Fisherfaces: faces added or removed, as a fraction of those of the discriminants, which solve them again, 0 never
+    double energy;          // Fraction of the variance kept when training is not given a number of components, 0 keeps all
+    int maxComponents;      // Most components of a model, 0 for no limit
+    bool doublePrecision;   // Train, store and project in double instead of float, slower and twice the memory
+};
+
 enum TrainingRequirement
 {
     NewImages,
@@ -77,6 +150,7 @@ enum TrainingRequirement
 
 // forward declaration
 class Face;
+class FaceStream;
 
 /**
  * Abstract class which all classes for face recognition must implement.
@@ -159,8 +233,49 @@ public:
 
     virtual void training(vector<Face*>* newFaceArr, int no_principal_components = 0) = 0;
 
+    /**
+     * Training from faces which are read from a stream in chunks, so that only a fixed number of
+     * them is in memory at any time. The default only reports that the method cannot stream.
+     *
+     * @param stream The training faces, read twice.
+     * @param no_principal_components Number of components of the model, must be positive.
+     *
+     * @return 0 on success.
+     */
+    virtual int trainingFromStream(FaceStream& stream, int no_principal_components) {
+        LOG(libfaceWARNING) << "This recognition method cannot train from a stream.";
+        return 1;
+    }
+
     //virtual void training(vector<Face*>* newFaceArr) = 0;
 
+    /**
+     * Forgets all faces of an ID, e.g. on request of the person. The default only reports that the
+     * method cannot remove faces.
+     *
+     * @param id The ID.
+     *
+     * @return 0 on success, non-zero if the ID is unknown or faces cannot be removed.
+     */
+    virtual int removeID(int id) {
+        LOG(libfaceWARNING) << "This recognition method cannot remove faces.";
+        return 1;
+    }
+
+    /**
+     * Gives all faces of an ID another one, merging them with the faces of newId if it is known.
+     * The default only reports that the method cannot relabel faces.
+     *
+     * @param id The ID to change.
+     * @param newId Its new value.
+     *
+     * @return 0 on success, non-zero if the ID is unknown or faces cannot be relabelled.
+     */
+    virtual int relabelID(int id, int newId) {
+        LOG(libfaceWARNING) << "This recognition method cannot relabel faces.";
+        return 1;
+    }
+
     /**
      * New Addition
      * Testing phase of face recognition - with int id
@@ -168,6 +283,22 @@ public:
 
     virtual int testingID(IplImage* img) = 0;
 
+    /**
+     * Testing phase of face recognition for several faces at once. Methods which can project a batch
+     * of faces together override this, the default calls testingID() for every image.
+     *
+     * @param images The face images to be recognized.
+     *
+     * @return The ID of the closest face for every image, -1 if it could not be recognized.
+     */
+    virtual vector<int> testingIDs(const vector<IplImage*>& images) {
+        vector<int> ids;
+        for(unsigned i = 0; i < images.size(); ++i) {
+            ids.push_back(testingID(images[i]));
+        }
+        return ids;
+    }
+
     /**
      * New Addition
      * Testing phase of face recognition - with int id
@@ -175,8 +306,56 @@ public:
 
     virtual string testingTag(IplImage* img) = 0;
 
+    /**
+     * Ranks the known people for a face, e.g. to offer candidates for tagging. Each ID appears at
+     * most once. The score is a distance for Eigenfaces and Fisherfaces, where smaller is closer, and
+     * a log likelihood for HMMfaces, where larger is closer. The default returns the result of
+     * testingID() with a score of -1.
+     *
+     * @param img The face image to be recognized.
+     * @param k Maximum number of candidates.
+     *
+     * @return Up to k pairs of ID and score, best first.
+     */
+    virtual vector<pair<int, float> > testingTopK(IplImage* img, int k) {
+        vector<pair<int, float> > candidates;
+        int id = testingID(img);
+        if(id != -1 && k > 0) {
+            candidates.push_back(make_pair(id, -1.0f));
+        }
+        return candidates;
+    }
+
     virtual TrainingRequirement getTrainingRequirement()=0;
 
+    /**
+     * Sets how the training projections are searched. Engines without projections ignore this.
+     *
+     * @param options The matching options.
+     */
+    virtual void setMatchingOptions(const MatchingOptions& options) {}
+
+    /**
+     * @return The matching options, see setMatchingOptions().
+     */
+    virtual MatchingOptions matchingOptions() const {
+        return MatchingOptions();
+    }
+
+    /**
+     * Sets how the model is computed by training. Engines without these choices ignore this.
+     *
+     * @param options The training options.
+     */
+    virtual void setTrainingOptions(const TrainingOptions& options) {}
+
+    /**
+     * @return The training options, see setTrainingOptions().
+     */
+    virtual TrainingOptions trainingOptions() const {
+        return TrainingOptions();
+    }
+
 };
 
 // -------------------------------------------------------------------------------------------
@@ -37,11 +37,15 @@
 // LibFace headers
 #include "Log.h"
 #include "Face.h"
+#include "ImageBufferPool.h"
+#include "ThreadPool.h"
 
 // OpenCV headers
 #if defined (__APPLE__)
+#include <cvaux.h>
 #include <highgui.h>
 #else
+#include <opencv/cvaux.h>
 #include <opencv/highgui.h>
 #endif
 
@@ -51,15 +55,9 @@ namespace libface
 {
 
 /**
- * This takes the input image and returns a new image of a specified pixel count (area),
- * while preserving the aspect ratio.
- *
- * @param img The input image
- * @param area The desired area of the resized image
- * @param ratio The scaling factor, to be passed as reference
- * @return The resized image
+ * Computes the size of an image with the given area and the aspect ratio of img.
  */
-IplImage* LibFaceUtils::resizeToArea(const IplImage* img, int area, double& ratio)
+static CvSize areaSize(const IplImage* img, int area, double& ratio)
 {
     // Area of input image
     int W = img->width;
@@ -77,7 +75,39 @@ IplImage* LibFaceUtils::resizeToArea(const IplImage* img, int area, double& rati
     s.width       = (int)(W/z);
     s.height      = (int)(H/z);
     ratio         = z;
-    IplImage* out = cvCreateImage(s, img->depth, img->nChannels);
+
+    return s;
+}
+
+/**
+ * This takes the input image and returns a new image of a specified pixel count (area),
+ * while preserving the aspect ratio.
+ *
+ * @param img The input image
+ * @param area The desired area of the resized image
+ * @param ratio The scaling factor, to be passed as reference
+ * @return The resized image
+ */
+IplImage* LibFaceUtils::resizeToArea(const IplImage* img, int area, double& ratio)
+{
+    IplImage* out = cvCreateImage(areaSize(img, area, ratio), img->depth, img->nChannels);
+    cvResize(img, out);
+
+    return out;
+}
+
+/**
+ * Like resizeToArea(const IplImage*, int, double&), but takes the output buffer from a pool.
+ *
+ * @param img The image to be resized
+ * @param area The desired area
+ * @param ratio Receives the scale factor between input and output
+ * @param pool Pool providing the output buffer
+ * @return The resized image, to be given back with pool.release()
+ */
+IplImage* LibFaceUtils::resizeToArea(const IplImage* img, int area, double& ratio, ImageBufferPool& pool)
+{
+    IplImage* out = pool.acquire(areaSize(img, area, ratio), img->depth, img->nChannels);
     cvResize(img, out);
 
     return out;
@@ -689,6 +719,120 @@ IplImage* LibFaceUtils::scaledSection(const IplImage* src, const CvRect& sourceR
     return result;
 }
 
+cv::Mat LibFaceUtils::projectImages(const vector<IplImage*>& images, const cv::Mat& eigenvectors, const cv::Mat& mean, vector<int>& rows)
+{
+    rows.assign(images.size(), -1);
+    if (eigenvectors.empty() || mean.empty())
+        return cv::Mat();
+
+    // Stack the centred faces, one per row
+    cv::Mat data((int)images.size(), mean.cols, mean.type());
+    int count = 0;
+    for (unsigned i = 0; i < images.size(); ++i)
+    {
+        if (!images[i])
+            continue;
+
+        cv::Mat face = cv::cvarrToMat(images[i]);
+        if ((int)face.total() != mean.cols)
+        {
+            LOG(libfaceERROR) << "Face of " << face.total() << " pixels does not match the subspace of dimension " << mean.cols << ".";
+            continue;
+        }
+
+        if (!face.isContinuous())
+            face = face.clone();
+
+        cv::Mat row = data.row(count);
+        face.reshape(1, 1).convertTo(row, mean.type());
+        row    -= mean;
+        rows[i] = count++;
+    }
+
+    if (count == 0)
+        return cv::Mat();
+
+    cv::Mat projections;
+    cv::gemm(data.rowRange(0, count), eigenvectors, 1.0, cv::Mat(), 0.0, projections);
+    return projections;
+}
+
+namespace
+{
+
+/**
+ * Converts images into the rows of a matrix, see LibFaceUtils::rowMatrix().
+ */
+class RowConverter : public RangeTask
+{
+public:
+
+    RowConverter(const vector<cv::Mat>& images, cv::Mat& data) : m_images(images), m_data(data) {}
+
+    void run(int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            cv::Mat row = m_data.row(i);
+            m_images[i].reshape(1, 1).convertTo(row, m_data.type());
+        }
+    }
+
+private:
+
+    const vector<cv::Mat>& m_images;
+    cv::Mat&               m_data;
+};
+
+/**
+ * Projects rows into a subspace, see LibFaceUtils::projectRows().
+ */
+class RowProjector : public RangeTask
+{
+public:
+
+    RowProjector(const cv::Mat& data, const cv::Mat& eigenvectors, const cv::Mat& mean, cv::Mat& projections)
+        : m_data(data), m_eigenvectors(eigenvectors), m_mean(mean), m_projections(projections) {}
+
+    void run(int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            cv::Mat row = m_projections.row(i);
+            cv::subspaceProject(m_eigenvectors, m_mean, m_data.row(i)).copyTo(row);
+        }
+    }
+
+private:
+
+    const cv::Mat& m_data;
+    const cv::Mat& m_eigenvectors;
+    const cv::Mat& m_mean;
+    cv::Mat&       m_projections;
+};
+
+} // namespace
+
+cv::Mat LibFaceUtils::rowMatrix(const vector<cv::Mat>& images, int type, ThreadPool& pool)
+{
+    if (images.empty())
+        return cv::Mat();
+
+    // every worker writes its own rows of the preallocated matrix
+    cv::Mat data((int)images.size(), (int)images[0].total(), type);
+    RowConverter converter(images, data);
+    pool.parallelFor(data.rows, converter);
+    return data;
+}
+
+cv::Mat LibFaceUtils::projectRows(const cv::Mat& data, const cv::Mat& eigenvectors, const cv::Mat& mean, ThreadPool& pool)
+{
+    cv::Mat projections(data.rows, eigenvectors.cols, eigenvectors.type());
+    RowProjector projector(data, eigenvectors, mean, projections);
+    pool.parallelFor(data.rows, projector);
+    return projections;
+}
+
 string LibFaceUtils::stringify(const unsigned int& x) const {
     ostringstream o;
 
@@ -53,12 +53,15 @@ namespace libface
 
 // forward declaration
 class Face;
+class ImageBufferPool;
+class ThreadPool;
 
 class FACEAPI LibFaceUtils
 {
 public:
 
     static IplImage*   resizeToArea(const IplImage* img, int area, double& ratio);
+    static IplImage*   resizeToArea(const IplImage* img, int area, double& ratio, ImageBufferPool& pool);
     static CvPoint     center(const Face&);
     static int         distance(CvPoint, CvPoint);
     static int         distance(const Face&, const Face&);
@@ -86,6 +89,42 @@ public:
     static std::string imageToString(IplImage* src);
     static std::string matrixToString(CvMat* src);
 
+    /**
+     * Projects several face images into a subspace with one matrix product.
+     *
+     * @param images The face images. Images whose size does not match the mean are skipped.
+     * @param eigenvectors The basis of the subspace, one vector per column.
+     * @param mean The mean as a row vector.
+     * @param rows Receives for every image the row of its projection in the result, -1 if it was skipped.
+     *
+     * @return One projection per row, or an empty matrix if no image could be projected.
+     */
+    static cv::Mat     projectImages(const std::vector<IplImage*>& images, const cv::Mat& eigenvectors, const cv::Mat& mean, std::vector<int>& rows);
+
+    /**
+     * Copies images into the rows of a matrix, one row per image, converting them in parallel.
+     *
+     * @param images The images, all with the same number of elements.
+     * @param type Type of the result, e.g. CV_64FC1.
+     * @param pool The threads to use.
+     *
+     * @return One image per row, or an empty matrix if there is no image.
+     */
+    static cv::Mat     rowMatrix(const std::vector<cv::Mat>& images, int type, ThreadPool& pool);
+
+    /**
+     * Projects the rows of a matrix into a subspace in parallel. Every row is projected by
+     * cv::subspaceProject on its own, so the result does not depend on the number of threads.
+     *
+     * @param data One sample per row.
+     * @param eigenvectors The basis of the subspace, one vector per column.
+     * @param mean The mean as a row vector.
+     * @param pool The threads to use.
+     *
+     * @return One projection per row, of the type of the eigenvectors.
+     */
+    static cv::Mat     projectRows(const cv::Mat& data, const cv::Mat& eigenvectors, const cv::Mat& mean, ThreadPool& pool);
+
     /**
      * Converts unsigned integer to string, convenience function.
      *
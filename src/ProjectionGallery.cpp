@@ -0,0 +1,1014 @@
+/** ===========================================================
+ * @file ProjectionGallery.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Contiguous float32 store of projected faces with nearest neighbour search.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "ProjectionGallery.h"
+
+// LibFace headers
+#include "Log.h"
+#include "DistanceKernels.h"
+#include "ClassCentroidIndex.h"
+#include "HnswIndex.h"
+#include "ScalarQuantizer.h"
+#include "ThreadPool.h"
+#include "TopCandidates.h"
+
+// C headers
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+
+using namespace std;
+using namespace cv;
+
+namespace libface {
+
+namespace {
+
+/**
+ * @return p rounded up to the next multiple of DistanceKernels::ALIGNMENT.
+ */
+inline float* alignPointer(float* p) {
+    size_t address = (size_t)p;
+    size_t aligned = (address + DistanceKernels::ALIGNMENT - 1) / DistanceKernels::ALIGNMENT * DistanceKernels::ALIGNMENT;
+    return (float*)aligned;
+}
+
+const int PADDING_FLOATS = DistanceKernels::ALIGNMENT / sizeof(float);
+
+// Norm of removed rows, so that every distance computed from it is infinite
+const float REMOVED_NORM = std::numeric_limits<float>::infinity();
+
+// Rows of a shard of the parallel scan fill about this much of a core's cache
+const int SHARD_BYTES = 256 * 1024;
+
+/**
+ * Copies a row or column vector of any depth into a zero padded float buffer.
+ */
+void copyVector(const Mat& src, float* dst, int dimension, int stride) {
+    Mat header(src.rows, src.cols, CV_32FC1, dst);
+    if(src.rows == 1) {
+        src.convertTo(header, CV_32F);
+    } else {
+        Mat row;
+        src.reshape(1, 1).convertTo(row, CV_32F);
+        memcpy(dst, row.ptr<float>(0), dimension * sizeof(float));
+    }
+    memset(dst + dimension, 0, (stride - dimension) * sizeof(float));
+}
+
+} // namespace
+
+class ProjectionGallery::ProjectionGalleryPriv {
+
+public:
+
+    ProjectionGalleryPriv() : raw(0), data(0), capacity(0), rows(0), dimension(0), stride(0), labels(), norms(), lengths(), dead(), deadCount(0), rowsOf(),
+                              options(), index(), pool(0) {}
+
+    ~ProjectionGalleryPriv() {
+        delete[] raw;
+        delete pool;
+    }
+
+    /**
+     * Grows the buffer to hold at least the given number of rows, keeping the content.
+     */
+    void grow(int minimum);
+
+    float*        raw;        // As allocated
+    float*        data;       // raw, aligned to DistanceKernels::ALIGNMENT
+    int           capacity;   // In rows
+    int           rows;
+    int           dimension;
+    int           stride;     // dimension padded to DistanceKernels::WIDTH
+    vector<int>   labels;
+    vector<float> norms;      // Squared norms of the rows
+    vector<float> lengths;    // Norms of the projections as added, which DistanceCosine scales to unit length
+
+    vector<char>            dead;       // Per row, removed projections
+    int                     deadCount;
+    map<int, vector<int> >  rowsOf;     // Rows of every label which are not removed
+
+    /**
+     * Marks a row as removed, without touching rowsOf.
+     *
+     * @param gallery The owner.
+     * @param index The row.
+     */
+    void bury(const ProjectionGallery& gallery, int index);
+
+    MatchingOptions         options;
+    mutable HnswIndex       index;  // Follows the rows lazily, see useIndex()
+    mutable ScalarQuantizer codes;  // Follows the rows lazily, see useCodes()
+
+    mutable ClassCentroidIndex classes;  // Follows the rows lazily, see useClasses()
+
+    // Workers of the parallel scan, started by the first large scan, see usePool()
+    mutable ThreadPool* pool;
+    mutable Mutex       poolMutex;  // Concurrent searches start the workers once
+
+    /**
+     * Finds the closest row among rows begin to end - 1.
+     *
+     * @param q The padded query.
+     * @param queryNorm Its squared norm.
+     * @param best Receives the closest row, unchanged if no distance is below minDist.
+     * @param minDist Distance to beat, receives that of best.
+     */
+    void scanNearest(const float* q, float queryNorm, int begin, int end, int& best, float& minDist) const {
+        // blocks of four rows share one pass over the query
+        int i = begin;
+        float dots[4];
+        for(; i + 4 <= end; i += 4) {
+            DistanceKernels::dot4(q, data + (size_t)i * stride, stride, stride, dots);
+            for(int k = 0; k < 4; ++k) {
+                float dist = norms[i + k] + queryNorm - 2.0f * dots[k];
+                if(dist < minDist) {
+                    minDist = dist;
+                    best    = i + k;
+                }
+            }
+        }
+        for(; i < end; ++i) {
+            float dist = norms[i] + queryNorm - 2.0f * DistanceKernels::dot(q, data + (size_t)i * stride, stride);
+            if(dist < minDist) {
+                minDist = dist;
+                best    = i;
+            }
+        }
+    }
+
+    /**
+     * Offers the labels of rows begin to end - 1 with their distances.
+     */
+    void scanLabels(const float* q, float queryNorm, int begin, int end, TopCandidates& candidates) const {
+        int i = begin;
+        float dots[4];
+        for(; i + 4 <= end; i += 4) {
+            DistanceKernels::dot4(q, data + (size_t)i * stride, stride, stride, dots);
+            for(int j = 0; j < 4; ++j) {
+                if(!dead[i + j]) {
+                    float dist = std::max(0.0f, norms[i + j] + queryNorm - 2.0f * dots[j]);
+                    candidates.offer(labels[i + j], dist);
+                }
+            }
+        }
+        for(; i < end; ++i) {
+            if(!dead[i]) {
+                float dist = std::max(0.0f, norms[i] + queryNorm - 2.0f * DistanceKernels::dot(q, data + (size_t)i * stride, stride));
+                candidates.offer(labels[i], dist);
+            }
+        }
+    }
+
+    /**
+     * @return Rows per shard of the parallel scan, a multiple of the four row blocks.
+     */
+    int shardRows() const {
+        int rowsPerShard = SHARD_BYTES / (stride * (int)sizeof(float));
+        return std::max(64, rowsPerShard / 4 * 4);
+    }
+
+    /**
+     * @return Threads of the parallel scan, see MatchingOptions::threads.
+     */
+    int scanThreads() const {
+        return options.threads > 0 ? options.threads : ThreadPool::idealThreadCount();
+    }
+
+    /**
+     * @return Shards of an exact scan of the rows, 1 unless it is worth sharing.
+     */
+    int shards() const {
+        if(rows < options.parallelRows || rows < 2 * shardRows() || scanThreads() < 2) {
+            return 1;
+        }
+        return (rows + shardRows() - 1) / shardRows();
+    }
+
+    /**
+     * Starts the workers if the scan of the rows is worth sharing.
+     *
+     * @return The pool, or 0 if the calling thread scans alone.
+     */
+    ThreadPool* usePool() const {
+        if(shards() < 2) {
+            return 0;
+        }
+        MutexLocker locker(poolMutex);
+        if(!pool) {
+            pool = new ThreadPool(scanThreads());
+        }
+        return pool;
+    }
+
+    /**
+     * Scans shards of rows on the workers. Every shard has its own results, which are merged in the
+     * order of the shards, so the outcome is that of the serial scan.
+     */
+    class ShardScan : public RangeTask
+    {
+    public:
+
+        /**
+         * @param k 0 for the closest row of every shard, otherwise the k closest labels.
+         */
+        ShardScan(const ProjectionGalleryPriv& gallery, const float* q, float queryNorm, int k)
+            : gallery(gallery), q(q), queryNorm(queryNorm), k(k), shardRows(gallery.shardRows()),
+              results((gallery.rows + shardRows - 1) / shardRows) {}
+
+        int shards() const {
+            return (int)results.size();
+        }
+
+        void run(int begin, int end) {
+            for(int s = begin; s < end; ++s) {
+                const int first = s * shardRows;
+                const int last  = std::min(gallery.rows, first + shardRows);
+                if(k == 0) {
+                    int best      = -1;
+                    float minDist = FLT_MAX;
+                    gallery.scanNearest(q, queryNorm, first, last, best, minDist);
+                    results[s].assign(1, make_pair(best, minDist));
+                } else {
+                    TopCandidates candidates(k);
+                    gallery.scanLabels(q, queryNorm, first, last, candidates);
+                    results[s] = candidates.sorted();
+                }
+            }
+        }
+
+        const ProjectionGalleryPriv&         gallery;
+        const float*                         q;
+        const float                          queryNorm;
+        const int                            k;
+        const int                            shardRows;
+        vector<vector<pair<int, float> > >   results;
+    };
+
+    /**
+     * @return True if the rows are kept at unit length.
+     */
+    bool unit() const {
+        return options.distance == DistanceCosine;
+    }
+
+    /**
+     * Scales a row to unit length if the distance mode asks for it, remembering the length, and
+     * updates its squared norm.
+     */
+    void normalise(int index) {
+        float* row = data + (size_t)index * stride;
+        float norm = DistanceKernels::dot(row, row, stride);
+        if(unit()) {
+            lengths[index] = std::sqrt(norm);
+            if(norm > 0.0f) {
+                const float scale = 1.0f / lengths[index];
+                for(int j = 0; j < dimension; ++j) {
+                    row[j] *= scale;
+                }
+                norm = DistanceKernels::dot(row, row, stride);
+            }
+        }
+        norms[index] = dead[index] ? REMOVED_NORM : norm;
+    }
+
+    /**
+     * Gives unit rows their length back, so that they are the projections as added.
+     */
+    void restoreLengths() {
+        for(int i = 0; i < rows; ++i) {
+            float* row = data + (size_t)i * stride;
+            for(int j = 0; j < dimension; ++j) {
+                row[j] *= lengths[i];
+            }
+        }
+    }
+
+    /**
+     * @return The queries as CV_32F rows, scaled to unit length if the rows are.
+     */
+    Mat toQueries(const Mat& queries) const {
+        Mat q;
+        if(queries.cols != dimension) {
+            // a single query given as a column
+            queries.reshape(1, 1).convertTo(q, CV_32F);
+        } else {
+            queries.convertTo(q, CV_32F);
+        }
+        if(unit()) {
+            for(int i = 0; i < q.rows; ++i) {
+                Mat row     = q.row(i);
+                double size = norm(row);
+                if(size > 0.0) {
+                    row *= 1.0 / size;
+                }
+            }
+        }
+        return q;
+    }
+
+    /**
+     * Brings the index up to date if approximate matching is on.
+     *
+     * @param gallery The owner.
+     *
+     * @return True if searches should use the index.
+     */
+    bool useIndex(const ProjectionGallery& gallery) const {
+        if(!options.approximate || rows == 0) {
+            return false;
+        }
+        if(index.size() != rows) {
+            index.update(gallery);
+        }
+        return true;
+    }
+
+    /**
+     * Brings the codes up to date if quantized matching is on and the index is not used.
+     *
+     * @param gallery The owner.
+     *
+     * @return True if searches should scan the codes.
+     */
+    bool useCodes(const ProjectionGallery& gallery) const {
+        if(!options.quantized || options.approximate || options.centroids || rows == 0) {
+            return false;
+        }
+        if(codes.size() != rows) {
+            codes.update(gallery);
+        }
+        return true;
+    }
+
+    /**
+     * Brings the class centroids up to date if they are used and the graph index is not.
+     *
+     * @param gallery The owner.
+     *
+     * @return True if searches should go through the centroids.
+     */
+    bool useClasses(const ProjectionGallery& gallery) const {
+        if(!options.centroids || options.approximate || rows == 0) {
+            return false;
+        }
+        if(classes.size() != rows) {
+            classes.update(gallery);
+        }
+        return true;
+    }
+};
+
+void ProjectionGallery::ProjectionGalleryPriv::bury(const ProjectionGallery& gallery, int index) {
+    // the structures which keep own copies of the rows learn about it, the others skip it
+    if(index < classes.size()) {
+        classes.remove(gallery, index);
+    }
+
+    dead[index]  = 1;
+    norms[index] = REMOVED_NORM;
+    ++deadCount;
+}
+
+void ProjectionGallery::ProjectionGalleryPriv::grow(int minimum) {
+    if(minimum <= capacity || stride == 0) {
+        return;
+    }
+
+    int newCapacity = std::max(minimum, std::max(16, capacity * 2));
+    float* newRaw   = new float[(size_t)newCapacity * stride + PADDING_FLOATS];
+    float* newData  = alignPointer(newRaw);
+
+    if(rows > 0) {
+        memcpy(newData, data, (size_t)rows * stride * sizeof(float));
+    }
+
+    delete[] raw;
+    raw      = newRaw;
+    data     = newData;
+    capacity = newCapacity;
+}
+
+ProjectionGallery::ProjectionGallery() : d(new ProjectionGalleryPriv) {}
+
+ProjectionGallery::ProjectionGallery(const ProjectionGallery& that) : d(new ProjectionGalleryPriv) {
+    *this = that;
+}
+
+ProjectionGallery& ProjectionGallery::operator = (const ProjectionGallery& that) {
+    if(this == &that) {
+        return *this;
+    }
+
+    clear();
+    d->dimension = that.d->dimension;
+    d->stride    = that.d->stride;
+    d->grow(that.d->rows);
+    if(that.d->rows > 0) {
+        memcpy(d->data, that.d->data, (size_t)that.d->rows * that.d->stride * sizeof(float));
+    }
+    d->rows      = that.d->rows;
+    d->labels    = that.d->labels;
+    d->norms     = that.d->norms;
+    d->dead      = that.d->dead;
+    d->deadCount = that.d->deadCount;
+    d->rowsOf    = that.d->rowsOf;
+    d->lengths   = that.d->lengths;
+    if(that.d->options.threads != d->options.threads) {
+        delete d->pool;
+        d->pool = 0;
+    }
+    d->options   = that.d->options;
+    d->index     = that.d->index;
+    d->codes     = that.d->codes;
+    d->classes   = that.d->classes;
+
+    return *this;
+}
+
+ProjectionGallery::~ProjectionGallery() {
+    delete d;
+}
+
+void ProjectionGallery::clear() {
+    delete[] d->raw;
+    d->raw       = 0;
+    d->data      = 0;
+    d->capacity  = 0;
+    d->rows      = 0;
+    d->dimension = 0;
+    d->stride    = 0;
+    d->labels.clear();
+    d->norms.clear();
+    d->dead.clear();
+    d->deadCount = 0;
+    d->rowsOf.clear();
+    d->lengths.clear();
+    d->index.clear();
+    d->codes.clear();
+    d->classes.clear();
+}
+
+void ProjectionGallery::reserve(int rows) {
+    d->grow(rows);
+    d->labels.reserve(rows);
+    d->norms.reserve(rows);
+    d->dead.reserve(rows);
+    if(d->unit()) {
+        d->lengths.reserve(rows);
+    }
+}
+
+int ProjectionGallery::add(const Mat& projection, int label) {
+    int dimension = (int)projection.total();
+
+    if(d->rows == 0 && d->stride == 0) {
+        d->dimension = dimension;
+        d->stride    = DistanceKernels::padded(dimension);
+    } else if(dimension != d->dimension) {
+        LOG(libfaceERROR) << "ProjectionGallery::add : Projection of dimension " << dimension << " does not match the gallery dimension " << d->dimension << ".";
+        return -1;
+    }
+
+    d->grow(d->rows + 1);
+
+    float* row = d->data + (size_t)d->rows * d->stride;
+    copyVector(projection, row, d->dimension, d->stride);
+
+    d->labels.push_back(label);
+    d->norms.push_back(0.0f);
+    d->dead.push_back(0);
+    if(d->unit()) {
+        d->lengths.push_back(0.0f);
+    }
+    d->rowsOf[label].push_back(d->rows);
+    d->normalise(d->rows);
+
+    return d->rows++;
+}
+
+int ProjectionGallery::set(int index, const Mat& projection) {
+    if(index < 0 || index >= d->rows || d->dead[index] || (int)projection.total() != d->dimension) {
+        LOG(libfaceERROR) << "ProjectionGallery::set : No projection " << index << " of dimension " << projection.total() << ".";
+        return 1;
+    }
+
+    float* row = d->data + (size_t)index * d->stride;
+    copyVector(projection, row, d->dimension, d->stride);
+    d->normalise(index);
+
+    // the graph was built around the old position
+    d->index.clear();
+    d->codes.clear();
+    d->classes.clear();
+    return 0;
+}
+
+int ProjectionGallery::remove(int index) {
+    if(index < 0 || index >= d->rows || d->dead[index]) {
+        LOG(libfaceERROR) << "ProjectionGallery::remove : No projection " << index << ".";
+        return 1;
+    }
+
+    vector<int>& rows = d->rowsOf[d->labels[index]];
+    rows.erase(std::find(rows.begin(), rows.end(), index));
+    if(rows.empty()) {
+        d->rowsOf.erase(d->labels[index]);
+    }
+
+    d->bury(*this, index);
+    return 0;
+}
+
+int ProjectionGallery::removeLabel(int label) {
+    map<int, vector<int> >::iterator it = d->rowsOf.find(label);
+    if(it == d->rowsOf.end()) {
+        return 0;
+    }
+
+    vector<int> rows;
+    rows.swap(it->second);
+    d->rowsOf.erase(it);
+
+    for(unsigned i = 0; i < rows.size(); ++i) {
+        d->bury(*this, rows[i]);
+    }
+    return (int)rows.size();
+}
+
+int ProjectionGallery::relabel(int label, int newLabel) {
+    map<int, vector<int> >::iterator it = d->rowsOf.find(label);
+    if(it == d->rowsOf.end() || label == newLabel) {
+        return 0;
+    }
+
+    vector<int> rows;
+    rows.swap(it->second);
+    d->rowsOf.erase(it);
+
+    vector<int>& target = d->rowsOf[newLabel];
+    for(unsigned i = 0; i < rows.size(); ++i) {
+        d->labels[rows[i]] = newLabel;
+    }
+    target.insert(target.end(), rows.begin(), rows.end());
+    std::sort(target.begin(), target.end());
+
+    // graph and codes do not know labels, the centroids are kept per label
+    d->classes.clear();
+    return (int)rows.size();
+}
+
+bool ProjectionGallery::removed(int index) const {
+    return d->dead.at(index) != 0;
+}
+
+int ProjectionGallery::removedCount() const {
+    return d->deadCount;
+}
+
+void ProjectionGallery::compact(vector<int>& remap) {
+    remap.assign(d->rows, -1);
+    if(d->deadCount == 0) {
+        for(int i = 0; i < d->rows; ++i) {
+            remap[i] = i;
+        }
+        return;
+    }
+
+    int live = 0;
+    for(int i = 0; i < d->rows; ++i) {
+        if(d->dead[i]) {
+            continue;
+        }
+        if(live != i) {
+            memcpy(d->data + (size_t)live * d->stride, d->data + (size_t)i * d->stride, d->stride * sizeof(float));
+            d->labels[live] = d->labels[i];
+            d->norms[live]  = d->norms[i];
+            if(d->unit()) {
+                d->lengths[live] = d->lengths[i];
+            }
+        }
+        remap[i] = live++;
+    }
+
+    LOG(libfaceDEBUG) << "ProjectionGallery::compact : Dropped " << d->deadCount << " removed projections, " << live << " remain.";
+
+    d->rows = live;
+    d->labels.resize(live);
+    d->norms.resize(live);
+    if(d->unit()) {
+        d->lengths.resize(live);
+    }
+    d->dead.assign(live, 0);
+    d->deadCount = 0;
+
+    d->rowsOf.clear();
+    for(int i = 0; i < live; ++i) {
+        d->rowsOf[d->labels[i]].push_back(i);
+    }
+
+    d->index.clear();
+    d->codes.clear();
+    d->classes.clear();
+}
+
+void ProjectionGallery::transform(const Mat& matrix, const Mat& offset) {
+    if(d->rows == 0) {
+        return;
+    }
+
+    Mat m, o;
+    matrix.convertTo(m, CV_32F);
+    if(!offset.empty()) {
+        offset.reshape(1, 1).convertTo(o, CV_32F);
+    }
+
+    // the map applies to the projections as added
+    if(d->unit()) {
+        d->restoreLengths();
+    }
+
+    // the padding is left out through the row step and stays zero
+    Mat gallery(d->rows, d->dimension, CV_32FC1, d->data, (size_t)d->stride * sizeof(float));
+    Mat mapped;
+    gemm(gallery, m, 1.0, Mat(), 0.0, mapped);
+
+    for(int i = 0; i < d->rows; ++i) {
+        Mat target = gallery.row(i);
+        if(o.empty()) {
+            mapped.row(i).copyTo(target);
+        } else {
+            cv::add(mapped.row(i), o, target);
+        }
+        d->normalise(i);
+    }
+
+    d->index.clear();
+    d->codes.clear();
+    d->classes.clear();
+}
+
+void ProjectionGallery::scale(const Mat& factors) {
+    if(d->rows == 0 || (int)factors.total() != d->dimension) {
+        return;
+    }
+
+    Mat f;
+    factors.reshape(1, 1).convertTo(f, CV_32F);
+    const float* factor = f.ptr<float>(0);
+
+    if(d->unit()) {
+        d->restoreLengths();
+    }
+    for(int i = 0; i < d->rows; ++i) {
+        float* row = d->data + (size_t)i * d->stride;
+        for(int j = 0; j < d->dimension; ++j) {
+            row[j] *= factor[j];
+        }
+        d->normalise(i);
+    }
+
+    d->index.clear();
+    d->codes.clear();
+    d->classes.clear();
+}
+
+int ProjectionGallery::size() const {
+    return d->rows;
+}
+
+int ProjectionGallery::shards() const {
+    return d->shards();
+}
+
+int ProjectionGallery::dimension() const {
+    return d->dimension;
+}
+
+int ProjectionGallery::stride() const {
+    return d->stride;
+}
+
+int ProjectionGallery::label(int index) const {
+    return d->labels.at(index);
+}
+
+const vector<int>& ProjectionGallery::rowsOf(int label) const {
+    static const vector<int> none;
+    map<int, vector<int> >::const_iterator it = d->rowsOf.find(label);
+    return it == d->rowsOf.end() ? none : it->second;
+}
+
+const vector<int>& ProjectionGallery::labels() const {
+    return d->labels;
+}
+
+float ProjectionGallery::squaredNorm(int index) const {
+    return d->norms.at(index);
+}
+
+const float* ProjectionGallery::row(int index) const {
+    return d->data + (size_t)index * d->stride;
+}
+
+Mat ProjectionGallery::projection(int index) const {
+    Mat shared(1, d->dimension, CV_32FC1, (void*)row(index));
+    if(d->unit()) {
+        return shared * d->lengths.at(index);
+    }
+    return shared;
+}
+
+const float* ProjectionGallery::padQuery(const Mat& query, vector<float>& buffer) const {
+    if(d->stride == 0 || (int)query.total() != d->dimension) {
+        return 0;
+    }
+
+    buffer.resize(d->stride + PADDING_FLOATS);
+    float* q = alignPointer(&buffer[0]);
+    copyVector(query, q, d->dimension, d->stride);
+    return q;
+}
+
+int ProjectionGallery::nearest(const Mat& input, float* squaredDistance) const {
+    if(d->rows == 0 || (int)input.total() != d->dimension) {
+        if(d->rows > 0) {
+            LOG(libfaceERROR) << "ProjectionGallery::nearest : Query of dimension " << input.total() << " does not match the gallery dimension " << d->dimension << ".";
+        }
+        return -1;
+    }
+
+    // the rows were scaled when they were added, a query is scaled once per search
+    const Mat query = d->toQueries(input);
+
+    if(d->useIndex(*this)) {
+        vector<pair<int, float> > found = d->index.search(*this, query, 1);
+        if(found.empty()) {
+            return -1;
+        }
+        if(squaredDistance) {
+            *squaredDistance = found.front().second;
+        }
+        return found.front().first;
+    }
+
+    if(d->useClasses(*this)) {
+        vector<pair<int, float> > found = d->classes.search(*this, query, 1, d->options.probes);
+        if(found.empty()) {
+            return -1;
+        }
+        if(squaredDistance) {
+            *squaredDistance = found.front().second;
+        }
+        return found.front().first;
+    }
+
+    if(d->useCodes(*this)) {
+        vector<pair<int, float> > found = d->codes.search(*this, query, 1, d->options.rerank);
+        if(found.empty()) {
+            return -1;
+        }
+        if(squaredDistance) {
+            *squaredDistance = found.front().second;
+        }
+        return found.front().first;
+    }
+
+    vector<float> buffer;
+    const float* q = padQuery(query, buffer);
+
+    const float queryNorm = DistanceKernels::dot(q, q, d->stride);
+    float minDist         = FLT_MAX;
+    int best              = -1;
+
+    if(ThreadPool* pool = d->usePool()) {
+        ProjectionGalleryPriv::ShardScan scan(*d, q, queryNorm, 0);
+        pool->parallelFor(scan.shards(), scan);
+        for(int s = 0; s < scan.shards(); ++s) {
+            if(scan.results[s][0].first >= 0 && scan.results[s][0].second < minDist) {
+                best    = scan.results[s][0].first;
+                minDist = scan.results[s][0].second;
+            }
+        }
+    } else {
+        d->scanNearest(q, queryNorm, 0, d->rows, best, minDist);
+    }
+
+    if(squaredDistance) {
+        // rounding may make the expansion slightly negative for identical vectors
+        *squaredDistance = std::max(0.0f, minDist);
+    }
+    return best;
+}
+
+vector<pair<int, float> > ProjectionGallery::nearestLabels(const Mat& input, int k) const {
+    if(d->rows == 0 || (int)input.total() != d->dimension) {
+        if(d->rows > 0) {
+            LOG(libfaceERROR) << "ProjectionGallery::nearestLabels : Query of dimension " << input.total() << " does not match the gallery dimension " << d->dimension << ".";
+        }
+        return vector<pair<int, float> >();
+    }
+
+    const Mat query = d->toQueries(input);
+
+    TopCandidates candidates(k);
+
+    if(d->useIndex(*this)) {
+        // labels repeat, so ask for a full beam and keep the closest projection of each label
+        vector<pair<int, float> > found = d->index.search(*this, query, std::max(k, d->index.efSearch()));
+        for(unsigned i = 0; i < found.size(); ++i) {
+            candidates.offer(d->labels[found[i].first], found[i].second);
+        }
+        return candidates.sorted();
+    }
+
+    if(d->useClasses(*this)) {
+        // one result per class, which is one per label
+        vector<pair<int, float> > found = d->classes.search(*this, query, k, d->options.probes);
+        for(unsigned i = 0; i < found.size(); ++i) {
+            candidates.offer(d->labels[found[i].first], found[i].second);
+        }
+        return candidates.sorted();
+    }
+
+    if(d->useCodes(*this)) {
+        // labels repeat, so re-rank at least as many projections as labels are asked for
+        vector<pair<int, float> > found = d->codes.search(*this, query, std::max(k, d->options.rerank), d->options.rerank);
+        for(unsigned i = 0; i < found.size(); ++i) {
+            candidates.offer(d->labels[found[i].first], found[i].second);
+        }
+        return candidates.sorted();
+    }
+
+    vector<float> buffer;
+    const float* q = padQuery(query, buffer);
+
+    const float queryNorm = DistanceKernels::dot(q, q, d->stride);
+
+    if(ThreadPool* pool = d->usePool()) {
+        // a label among the k best overall is among the k best of the shard of its closest row
+        ProjectionGalleryPriv::ShardScan scan(*d, q, queryNorm, std::max(1, k));
+        pool->parallelFor(scan.shards(), scan);
+        for(int s = 0; s < scan.shards(); ++s) {
+            for(unsigned j = 0; j < scan.results[s].size(); ++j) {
+                candidates.offer(scan.results[s][j].first, scan.results[s][j].second);
+            }
+        }
+    } else {
+        d->scanLabels(q, queryNorm, 0, d->rows, candidates);
+    }
+
+    return candidates.sorted();
+}
+
+void ProjectionGallery::nearest(const Mat& queries, vector<int>& indices, vector<float>* squaredDistances) const {
+    indices.assign(queries.rows, -1);
+    if(squaredDistances) {
+        squaredDistances->assign(queries.rows, 0.0f);
+    }
+
+    if(d->rows == 0 || queries.rows == 0) {
+        return;
+    }
+    if(queries.cols != d->dimension) {
+        LOG(libfaceERROR) << "ProjectionGallery::nearest : Queries of dimension " << queries.cols << " do not match the gallery dimension " << d->dimension << ".";
+        return;
+    }
+
+    if(d->useIndex(*this) || d->useClasses(*this) || d->useCodes(*this)) {
+        for(int i = 0; i < queries.rows; ++i) {
+            float dist  = 0.0f;
+            indices[i]  = nearest(queries.row(i), &dist);
+            if(squaredDistances) {
+                (*squaredDistances)[i] = dist;
+            }
+        }
+        return;
+    }
+
+    Mat q = d->toQueries(queries);
+
+    // the padding is left out through the row step
+    Mat gallery(d->rows, d->dimension, CV_32FC1, d->data, (size_t)d->stride * sizeof(float));
+    Mat dots;
+    gemm(q, gallery, 1.0, Mat(), 0.0, dots, CV_GEMM_B_T);
+
+    for(int i = 0; i < q.rows; ++i) {
+        const float* qi       = q.ptr<float>(i);
+        const float* dotRow   = dots.ptr<float>(i);
+        float queryNorm       = 0.0f;
+        for(int k = 0; k < d->dimension; ++k) {
+            queryNorm += qi[k] * qi[k];
+        }
+
+        float minDist = FLT_MAX;
+        int best      = -1;
+        for(int j = 0; j < d->rows; ++j) {
+            float dist = d->norms[j] + queryNorm - 2.0f * dotRow[j];
+            if(dist < minDist) {
+                minDist = dist;
+                best    = j;
+            }
+        }
+
+        indices[i] = best;
+        if(squaredDistances) {
+            (*squaredDistances)[i] = std::max(0.0f, minDist);
+        }
+    }
+}
+
+void ProjectionGallery::setMatchingOptions(const MatchingOptions& options) {
+    if(options.threads != d->options.threads) {
+        delete d->pool;
+        d->pool = 0;
+    }
+    if((options.distance == DistanceCosine) != d->unit()) {
+        // the rows are scaled to unit length or given their lengths back
+        if(d->unit()) {
+            d->restoreLengths();
+        }
+        d->options.distance = options.distance;
+        d->lengths.assign(d->unit() ? d->rows : 0, 0.0f);
+        for(int i = 0; i < d->rows; ++i) {
+            d->normalise(i);
+        }
+        d->index.clear();
+        d->codes.clear();
+        d->classes.clear();
+    }
+
+    d->options = options;
+    d->index.setBuildParameters(options.neighbours, options.efConstruction);
+    d->index.setEfSearch(options.efSearch);
+    if(!options.approximate) {
+        d->index.clear();
+    }
+    if(!options.quantized) {
+        d->codes.clear();
+    }
+    if(!options.centroids) {
+        d->classes.clear();
+    }
+}
+
+MatchingOptions ProjectionGallery::matchingOptions() const {
+    return d->options;
+}
+
+int ProjectionGallery::saveIndex(const string& file) const {
+    if(!d->useIndex(*this)) {
+        // do not leave an index of older projections behind
+        std::remove(file.c_str());
+        return 0;
+    }
+    return d->index.save(file);
+}
+
+int ProjectionGallery::loadIndex(const string& file) {
+    if(d->index.load(file) != 0) {
+        return 1;
+    }
+
+    if(d->index.size() != d->rows || d->index.neighbours() != d->options.neighbours || d->index.efConstruction() != d->options.efConstruction) {
+        LOG(libfaceWARNING) << "ProjectionGallery::loadIndex : " << file << " does not match the gallery or the matching options, it will be rebuilt.";
+        d->index.clear();
+        d->index.setBuildParameters(d->options.neighbours, d->options.efConstruction);
+        return 1;
+    }
+
+    d->index.setEfSearch(d->options.efSearch);
+    return 0;
+}
+
+} // namespace libface
@@ -0,0 +1,338 @@
+/** ===========================================================
+ * @file ProjectionGallery.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Contiguous float32 store of projected faces with nearest neighbour search.
+ * @section DESCRIPTION
+ *
+ * All projections live in one aligned float matrix whose rows are padded with zeros to a multiple
+ * of DistanceKernels::WIDTH, together with their labels and squared norms. The nearest neighbour is
+ * found with |x - q|^2 = |x|^2 + |q|^2 - 2 x.q, scanning the rows in blocks of four with the
+ * vectorised kernels, so a large gallery is read from memory exactly once per query. Galleries of
+ * at least MatchingOptions::parallelRows projections are cut into shards of a few hundred kilobytes,
+ * which the threads of a pool owned by the gallery scan for the same query. The results of the
+ * shards are merged in order, so they are those of the serial scan.
+ *
+ * With MatchingOptions::approximate the single query searches use an HnswIndex instead, which is
+ * brought up to date with the added projections before the next query.
+ *
+ * With DistanceCosine the rows are scaled to unit length in place when they are added, and a query
+ * once per search, so the squared Euclidean distance 2 - 2 cos is found by the same kernels. The
+ * lengths are kept, one float per projection, so that transform() and a change of the distance mode
+ * work on the projections as added. The whitening of DistanceMahalanobis belongs to the subspace
+ * the projections come from and is left to the engines.
+ *
+ * Removed projections stay in place as tombstones with an infinite norm, so removal is O(1) and
+ * indices stay valid, until compact() moves the remaining rows together.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _PROJECTIONGALLERY_H_
+#define _PROJECTIONGALLERY_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+#include "LibFaceCore.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+// C headers
+#include <string>
+#include <vector>
+
+namespace libface
+{
+
+class FACEAPI ProjectionGallery
+{
+public:
+
+    /**
+     * Constructor. Creates an empty gallery.
+     */
+    ProjectionGallery();
+
+    /**
+     * Copy constructor.
+     *
+     * @param that Object to be copied.
+     */
+    ProjectionGallery(const ProjectionGallery& that);
+
+    /**
+     * Assignment operator.
+     *
+     * @param that Object to be copied.
+     *
+     * @return Reference to assignee.
+     */
+    ProjectionGallery& operator = (const ProjectionGallery& that);
+
+    /**
+     * Destructor.
+     */
+    ~ProjectionGallery();
+
+    /**
+     * Removes all projections. The dimension is determined again by the next add().
+     */
+    void clear();
+
+    /**
+     * Allocates memory for the given number of projections.
+     *
+     * @param rows Expected number of projections.
+     */
+    void reserve(int rows);
+
+    /**
+     * Appends a projection. The first projection determines the dimension of the gallery.
+     *
+     * @param projection A single row or column of any depth, converted to float.
+     * @param label The label (ID) of the face.
+     *
+     * @return The index of the projection, or -1 if its dimension does not match.
+     */
+    int add(const cv::Mat& projection, int label);
+
+    /**
+     * Replaces a projection, keeping its label.
+     *
+     * @param index Index of the projection.
+     * @param projection A single row or column of dimension() elements, any depth.
+     *
+     * @return 0 on success, 1 if the index or the dimension does not match.
+     */
+    int set(int index, const cv::Mat& projection);
+
+    /**
+     * Marks a projection as removed. Searches skip it, its index stays valid until compact().
+     *
+     * @param index Index of the projection.
+     *
+     * @return 0 on success, 1 if there is no such projection or it was removed already.
+     */
+    int remove(int index);
+
+    /**
+     * Removes all projections of a label.
+     *
+     * @param label The label (ID).
+     *
+     * @return Number of projections removed.
+     */
+    int removeLabel(int label);
+
+    /**
+     * Gives all projections of a label another one. If the new label has projections already, the
+     * two are merged.
+     *
+     * @param label The label (ID) to change.
+     * @param newLabel Its new value.
+     *
+     * @return Number of projections relabelled.
+     */
+    int relabel(int label, int newLabel);
+
+    /**
+     * @param index Index of a projection.
+     *
+     * @return True if it was removed.
+     */
+    bool removed(int index) const;
+
+    /**
+     * @return Number of removed projections still taking up rows.
+     */
+    int removedCount() const;
+
+    /**
+     * Drops the rows of removed projections. Remaining projections keep their order.
+     *
+     * @param remap Receives the new index of every old index, -1 for removed projections.
+     */
+    void compact(std::vector<int>& remap);
+
+    /**
+     * Maps every projection p, as added, to p * matrix + offset, e.g. to follow a change of the subspace.
+     *
+     * @param matrix dimension() x dimension() matrix, any depth.
+     * @param offset Row of dimension() elements added after the product, or an empty matrix.
+     */
+    void transform(const cv::Mat& matrix, const cv::Mat& offset);
+
+    /**
+     * Multiplies every component of every projection, as added, by its own factor, e.g. to whiten
+     * them. Cheaper than transform() with a diagonal matrix.
+     *
+     * @param factors dimension() factors, any depth.
+     */
+    void scale(const cv::Mat& factors);
+
+    /**
+     * @return Number of rows, removed projections included.
+     */
+    int size() const;
+
+    /**
+     * @return Number of shards an exact scan is split into with the current options, 1 if the
+     * calling thread scans all rows.
+     */
+    int shards() const;
+
+    /**
+     * @return Number of components of each projection, 0 if the gallery is empty.
+     */
+    int dimension() const;
+
+    /**
+     * @return Distance between two rows in floats.
+     */
+    int stride() const;
+
+    /**
+     * @param index Index of a projection.
+     *
+     * @return Its label.
+     */
+    int label(int index) const;
+
+    /**
+     * @param label A label.
+     *
+     * @return Indices of its projections which are not removed, in the order they were added.
+     * Valid until the gallery changes.
+     */
+    const std::vector<int>& rowsOf(int label) const;
+
+    /**
+     * @return All labels in order of the projections, removed projections included.
+     */
+    const std::vector<int>& labels() const;
+
+    /**
+     * @param index Index of a projection.
+     *
+     * @return The squared Euclidean norm of its row, infinite if it was removed.
+     */
+    float squaredNorm(int index) const;
+
+    /**
+     * @param index Index of a projection.
+     *
+     * @return Pointer to the padded row as searched, of unit length for DistanceCosine. Valid until
+     * the gallery is modified.
+     */
+    const float* row(int index) const;
+
+    /**
+     * @param index Index of a projection.
+     *
+     * @return The projection as added, a 1 x dimension() CV_32F matrix sharing the gallery memory
+     * unless the rows are kept at unit length for DistanceCosine.
+     */
+    cv::Mat projection(int index) const;
+
+    /**
+     * Copies a query into the layout of the rows, so it can be passed to DistanceKernels with row().
+     *
+     * @param query A single row or column of dimension() elements, any depth.
+     * @param buffer Storage for the copy, resized as needed.
+     *
+     * @return Pointer to the aligned, zero padded copy inside buffer, or 0 if the dimension does not match.
+     */
+    const float* padQuery(const cv::Mat& query, std::vector<float>& buffer) const;
+
+    /**
+     * Finds the projection closest to a query by Euclidean distance.
+     *
+     * @param query The projected query, a single row or column of dimension() elements, any depth.
+     * @param squaredDistance If not 0, receives the squared distance to the closest projection.
+     *
+     * @return The index of the closest projection, -1 if the gallery is empty or the dimension does not match.
+     */
+    int nearest(const cv::Mat& query, float* squaredDistance = 0) const;
+
+    /**
+     * Finds the closest projection for every row of a matrix of queries. The dot products of all
+     * queries with all projections are computed with a single matrix product.
+     *
+     * @param queries One projected query per row with dimension() columns, any depth.
+     * @param indices Receives for every query the index of the closest projection, -1 if the gallery is empty or the dimension does not match.
+     * @param squaredDistances If not 0, receives for every query the squared distance to the closest projection.
+     */
+    void nearest(const cv::Mat& queries, std::vector<int>& indices, std::vector<float>* squaredDistances = 0) const;
+
+    /**
+     * Finds the k labels closest to a query in a single scan. A label's distance is that of its
+     * closest projection.
+     *
+     * @param query The projected query, a single row or column of dimension() elements, any depth.
+     * @param k Maximum number of labels.
+     *
+     * @return Up to k labels with their squared distances, closest first. Empty if the gallery is empty or the dimension does not match.
+     */
+    std::vector<std::pair<int, float> > nearestLabels(const cv::Mat& query, int k) const;
+
+    /**
+     * Chooses between the exact scan and the approximate index for searches, and the distance.
+     * Squared distances returned by searches are those of the distance mode. Switching to or from
+     * DistanceCosine scales all rows once.
+     *
+     * @param options The matching options.
+     */
+    void setMatchingOptions(const MatchingOptions& options);
+
+    /**
+     * @return The matching options, see setMatchingOptions().
+     */
+    MatchingOptions matchingOptions() const;
+
+    /**
+     * Writes the approximate index, so that it does not have to be rebuilt after loading. Without
+     * approximate matching an existing file is removed instead.
+     *
+     * @param file Path of the file.
+     *
+     * @return 0 if the file was written or there is no index, non-zero otherwise.
+     */
+    int saveIndex(const std::string& file) const;
+
+    /**
+     * Reads an index written by saveIndex(). Call it after all projections have been added. An index
+     * of a different number of projections or built with other options is discarded.
+     *
+     * @param file Path of the file.
+     *
+     * @return 0 if the index was read, non-zero otherwise. The index is then rebuilt when needed.
+     */
+    int loadIndex(const std::string& file);
+
+private:
+
+    class ProjectionGalleryPriv;
+    ProjectionGalleryPriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _PROJECTIONGALLERY_H_ */
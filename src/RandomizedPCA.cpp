@@ -0,0 +1,123 @@
+/** ===========================================================
+ * @file RandomizedPCA.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Truncated PCA by a randomized range finder.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "RandomizedPCA.h"
+
+// LibFace headers
+#include "Log.h"
+
+// C headers
+#include <algorithm>
+
+using namespace cv;
+
+namespace libface {
+
+namespace {
+
+/**
+ * Replaces the columns of a tall matrix by an orthonormal basis of their span.
+ */
+void orthonormalize(Mat& m) {
+    Mat w, u, vt;
+    SVD::compute(m, w, u, vt, SVD::MODIFY_A);
+    m = u;
+}
+
+} // namespace
+
+PCA RandomizedPCA::compute(Mat& data, int components, int oversampling, int powerIterations, Mat* projections) {
+    PCA pca;
+
+    const int n = data.rows;
+    const int d = data.cols;
+    if(n == 0 || components <= 0) {
+        return pca;
+    }
+
+    const int k = std::min(components, std::min(n, d));
+    const int l = std::min(k + std::max(0, oversampling), std::min(n, d));
+
+    // centre the samples
+    reduce(data, pca.mean, 0, CV_REDUCE_AVG);
+    for(int i = 0; i < n; ++i) {
+        Mat row = data.row(i);
+        row    -= pca.mean;
+    }
+
+    // random sample of the range, fixed seed so that training is reproducible
+    Mat omega(d, l, data.type());
+    RNG rng(0x1234567);
+    rng.fill(omega, RNG::NORMAL, 0.0, 1.0);
+
+    Mat y;
+    gemm(data, omega, 1.0, Mat(), 0.0, y);
+    omega.release();
+
+    // power iterations sharpen the spectrum, orthonormalising in between keeps the small directions
+    Mat z;
+    for(int i = 0; i < powerIterations; ++i) {
+        orthonormalize(y);
+        gemm(data, y, 1.0, Mat(), 0.0, z, GEMM_1_T);
+        orthonormalize(z);
+        gemm(data, z, 1.0, Mat(), 0.0, y);
+    }
+    z.release();
+    orthonormalize(y);
+
+    // project onto the found range and decompose the small matrix exactly
+    Mat b;
+    gemm(y, data, 1.0, Mat(), 0.0, b, GEMM_1_T);
+
+    Mat w, u, vt;
+    SVD::compute(b, w, u, vt);
+    b.release();
+
+    pca.eigenvectors = vt.rowRange(0, k).clone();
+    w.rowRange(0, k).convertTo(pca.eigenvalues, data.type());
+    pca.eigenvalues  = pca.eigenvalues.mul(pca.eigenvalues, 1.0 / n);
+
+    if(projections) {
+        // X V exactly, Q U S only approximates it, and queries are projected onto V as well
+        gemm(data, pca.eigenvectors, 1.0, Mat(), 0.0, *projections, GEMM_2_T);
+    }
+
+    LOG(libfaceDEBUG) << "RandomizedPCA : " << k << " of " << std::min(n, d) << " components from " << l << " random directions.";
+
+    return pca;
+}
+
+bool RandomizedPCA::preferred(int samples, int dimension, int components, int oversampling) {
+    if(components <= 0) {
+        return false;
+    }
+    // the exact decomposition is cheap for small problems and the sketch needs room to save anything
+    return 4 * (components + oversampling) <= std::min(samples, dimension) && samples >= 1000;
+}
+
+} // namespace libface
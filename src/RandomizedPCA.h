@@ -0,0 +1,78 @@
+/** ===========================================================
+ * @file RandomizedPCA.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Truncated PCA by a randomized range finder.
+ * @section DESCRIPTION
+ *
+ * cv::PCA forms an N x N or D x D covariance matrix and decomposes it completely, which takes
+ * O(N^2 D + N^3) time and O(N^2) memory for N faces of D pixels. When only k << min(N, D) components
+ * are kept, the range of the data is found instead by multiplying it with k + p random vectors,
+ * refined by a few power iterations, and a small (k + p) x D matrix is decomposed exactly
+ * (Halko, Martinsson and Tropp, 2011). This costs O(N D k) time and O(N k + D k) extra memory.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _RANDOMIZEDPCA_H_
+#define _RANDOMIZEDPCA_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+namespace libface
+{
+
+class FACEAPI RandomizedPCA
+{
+public:
+
+    /**
+     * Computes the leading principal components of the rows of a matrix.
+     *
+     * @param data One sample per row, CV_32F or CV_64F. It is centred in place to save memory.
+     * @param components Number of components k.
+     * @param oversampling Number p of extra random directions, which make the result accurate for the first k.
+     * @param powerIterations Number of power iterations, more are needed when the spectrum decays slowly.
+     * @param projections If not 0, receives the centred samples projected onto the eigenvectors, as
+     * cv::PCA::project() gives them, N x k of the type of data.
+     *
+     * @return The result in the layout of cv::PCA: mean as a row, eigenvectors as rows and eigenvalues as a column.
+     */
+    static cv::PCA compute(cv::Mat& data, int components, int oversampling = 10, int powerIterations = 2, cv::Mat* projections = 0);
+
+    /**
+     * @param samples Number of samples N.
+     * @param dimension Dimension of a sample D.
+     * @param components Number of components k to keep, 0 for all.
+     * @param oversampling Number p of extra random directions.
+     *
+     * @return True if k + p is small enough against min(N, D) for compute() to be faster than cv::PCA,
+     *         and there are enough samples for cv::PCA to be slow. Small databases keep the exact result.
+     */
+    static bool preferred(int samples, int dimension, int components, int oversampling = 10);
+};
+
+} // namespace libface
+
+#endif /* _RANDOMIZEDPCA_H_ */
@@ -0,0 +1,156 @@
+/** ===========================================================
+ * @file ScalarQuantizer.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   8 bit codes of the projections of a ProjectionGallery, scanned before an exact re-ranking.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "ScalarQuantizer.h"
+
+// LibFace headers
+#include "DistanceKernels.h"
+#include "Log.h"
+#include "ProjectionGallery.h"
+#include "TopCandidates.h"
+
+// C headers
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace cv;
+
+namespace libface {
+
+ScalarQuantizer::ScalarQuantizer() : m_dimension(0), m_scales(), m_codes(), m_norms() {}
+
+void ScalarQuantizer::clear() {
+    m_dimension = 0;
+    m_scales.clear();
+    m_codes.clear();
+    m_norms.clear();
+}
+
+int ScalarQuantizer::size() const {
+    return (int)m_norms.size();
+}
+
+size_t ScalarQuantizer::bytes() const {
+    return m_codes.size() + (m_norms.size() + m_scales.size()) * sizeof(float);
+}
+
+void ScalarQuantizer::update(const ProjectionGallery& gallery) {
+    const int rows = gallery.size();
+    if(rows == 0 || size() >= rows) {
+        return;
+    }
+
+    // a new component beyond the range of its scale would be clipped, so all codes are built again
+    for(int i = size(); i < rows && !m_scales.empty(); ++i) {
+        const float* p = gallery.row(i);
+        for(int j = 0; j < m_dimension; ++j) {
+            if(std::fabs(p[j]) > 127.5f * m_scales[j]) {
+                LOG(libfaceDEBUG) << "ScalarQuantizer : Projection " << i << " exceeds the range of component " << j
+                                  << ", encoding all " << rows << " projections again.";
+                clear();
+                break;
+            }
+        }
+    }
+
+    if(m_scales.empty()) {
+        // symmetric range per component, from the projections known now
+        m_dimension = gallery.dimension();
+        vector<float> largest(m_dimension, 0.0f);
+        for(int i = 0; i < rows; ++i) {
+            const float* p = gallery.row(i);
+            for(int j = 0; j < m_dimension; ++j) {
+                largest[j] = std::max(largest[j], std::fabs(p[j]));
+            }
+        }
+        m_scales.resize(m_dimension);
+        for(int j = 0; j < m_dimension; ++j) {
+            m_scales[j] = largest[j] > 0.0f ? largest[j] / 127.0f : 1.0f;
+        }
+    }
+
+    m_codes.reserve((size_t)rows * m_dimension);
+    m_norms.reserve(rows);
+
+    for(int i = size(); i < rows; ++i) {
+        const float* p = gallery.row(i);
+        float norm     = 0.0f;
+        for(int j = 0; j < m_dimension; ++j) {
+            float level = std::floor(p[j] / m_scales[j] + 0.5f);
+            level       = std::max(-127.0f, std::min(127.0f, level));
+            m_codes.push_back((signed char)level);
+
+            float decoded = level * m_scales[j];
+            norm         += decoded * decoded;
+        }
+        m_norms.push_back(norm);
+    }
+}
+
+vector<pair<int, float> > ScalarQuantizer::search(const ProjectionGallery& gallery, const Mat& query, int k, int candidates) const {
+    vector<pair<int, float> > result;
+
+    vector<float> buffer;
+    const float* q = gallery.padQuery(query, buffer);
+    if(!q || k <= 0 || m_norms.empty()) {
+        return result;
+    }
+
+    // the scales move to the query, so a row costs one multiply-add per byte
+    vector<float> scaled(m_dimension);
+    for(int j = 0; j < m_dimension; ++j) {
+        scaled[j] = q[j] * m_scales[j];
+    }
+    const float queryNorm = DistanceKernels::dot(q, q, gallery.stride());
+
+    // rows are distinct candidates, so TopCandidates keyed by the row keeps the closest ones
+    TopCandidates approximate(std::max(k, candidates));
+    const signed char* code = &m_codes[0];
+    for(int i = 0; i < size(); ++i, code += m_dimension) {
+        if(gallery.removed(i)) {
+            continue;
+        }
+        float dist = m_norms[i] + queryNorm - 2.0f * DistanceKernels::dot(&scaled[0], code, m_dimension);
+        if(approximate.accepts(dist)) {
+            approximate.offer(i, dist);
+        }
+    }
+
+    // exact distances for the candidates
+    vector<pair<int, float> > found = approximate.sorted();
+    TopCandidates exact(k);
+    for(unsigned i = 0; i < found.size(); ++i) {
+        int row = found[i].first;
+        exact.offer(row, DistanceKernels::squaredDistance(q, gallery.row(row), gallery.stride()));
+    }
+
+    return exact.sorted();
+}
+
+} // namespace libface
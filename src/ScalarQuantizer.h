@@ -0,0 +1,114 @@
+/** ===========================================================
+ * @file ScalarQuantizer.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   8 bit codes of the projections of a ProjectionGallery, scanned before an exact re-ranking.
+ * @section DESCRIPTION
+ *
+ * Every component of every projection is stored as a signed byte times a scale per component,
+ * chosen from the largest magnitude of the component in the gallery. A query is compared in full
+ * precision against the decoded rows (asymmetric distance), which reads a quarter of the memory of
+ * the float rows. The closest candidates are then re-ranked with the exact float rows, so the order
+ * of the final results is exact unless the true neighbour fell out of the candidates.
+ *
+ * The codes save memory bandwidth, not memory: the float rows stay in the gallery for the
+ * re-ranking, and the codes and their norms add one byte per component and four per projection.
+ *
+ * The codes only follow the gallery. Vectors are read from the gallery passed to every call, which
+ * must be the one the codes were built from.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _SCALARQUANTIZER_H_
+#define _SCALARQUANTIZER_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+// C headers
+#include <utility>
+#include <vector>
+
+namespace libface
+{
+
+class ProjectionGallery;
+
+class FACEAPI ScalarQuantizer
+{
+public:
+
+    /**
+     * Constructor. The codes are empty until update() is called.
+     */
+    ScalarQuantizer();
+
+    /**
+     * Forgets all codes and scales.
+     */
+    void clear();
+
+    /**
+     * @return Number of encoded projections.
+     */
+    int size() const;
+
+    /**
+     * @return Memory of the codes in bytes.
+     */
+    size_t bytes() const;
+
+    /**
+     * Encodes the projections added to the gallery since the last call. The scales are chosen on
+     * the first call; if a later projection exceeds the range of a component, the scales are chosen
+     * again and all projections are encoded again.
+     *
+     * @param gallery The gallery the codes follow.
+     */
+    void update(const ProjectionGallery& gallery);
+
+    /**
+     * Finds the closest projections to a query by scanning the codes and re-ranking the best
+     * candidates exactly.
+     *
+     * @param gallery The gallery the codes were built from.
+     * @param query The projected query, a single row or column of gallery.dimension() elements, any depth.
+     * @param k Maximum number of results.
+     * @param candidates Number of candidates re-ranked exactly, at least k are.
+     *
+     * @return Up to k pairs of gallery index and exact squared distance, closest first, without removed projections.
+     */
+    std::vector<std::pair<int, float> > search(const ProjectionGallery& gallery, const cv::Mat& query, int k, int candidates) const;
+
+private:
+
+    int                      m_dimension;
+    std::vector<float>       m_scales;    // Per component
+    std::vector<signed char> m_codes;     // m_dimension per projection
+    std::vector<float>       m_norms;     // Squared norms of the decoded projections
+};
+
+} // namespace libface
+
+#endif /* _SCALARQUANTIZER_H_ */
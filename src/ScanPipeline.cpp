@@ -0,0 +1,339 @@
+/** ===========================================================
+ * @file ScanPipeline.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Two stage decode/detect pipeline for scanning many image files.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "ScanPipeline.h"
+
+// LibFace headers
+#include "Log.h"
+#include "Face.h"
+#include "FaceDetect.h"
+#include "BatchDetect.h"
+#include "BoundedQueue.h"
+#include "ThreadPool.h"
+
+// OpenCV headers
+#if defined (__APPLE__)
+#include <highgui.h>
+#else
+#include <opencv/highgui.h>
+#endif
+
+// C headers
+#include <algorithm>
+#include <ctime>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace libface {
+
+namespace {
+
+/**
+ * @return The image file as grayscale, 0 with a warning if it cannot be loaded.
+ */
+IplImage* decodeImage(const string& filename) {
+    IplImage* image = cvLoadImage(filename.c_str(), CV_LOAD_IMAGE_GRAYSCALE);
+    if(!image) {
+        LOG(libfaceWARNING) << "ScanPipeline : Could not load " << filename << ", skipping.";
+    }
+    return image;
+}
+
+/**
+ * Detects the faces of a decoded image and releases it. An image which could not be decoded has no faces.
+ */
+vector<Face*>* detectImage(IplImage* image, FaceDetect* detector) {
+    if(!image) {
+        return new vector<Face*>();
+    }
+    vector<Face*>* faces = detector->detectFaces(image);
+    cvReleaseImage(&image);
+    return faces;
+}
+
+/**
+ * Hands the faces to the listener, or deletes them if there is none.
+ */
+void deliverFaces(DetectionListener* listener, int index, vector<Face*>* faces) {
+    if(listener) {
+        listener->facesDetected(index, faces);
+        return;
+    }
+    for(unsigned i = 0; i < faces->size(); ++i) {
+        delete faces->at(i);
+    }
+    delete faces;
+}
+
+/**
+ * A decoded image travelling from the decode to the detection stage. An index of -1 tells a
+ * detection thread that there is no more work.
+ */
+struct DecodedImage {
+    int       index;
+    IplImage* image;
+};
+
+/**
+ * The state shared by both stages of one scan.
+ */
+struct ScanJob {
+
+    ScanJob(const vector<string>& argFilenames, DetectionListener* argListener, int capacity, int decoders, int argDetectors)
+        : filenames(argFilenames), listener(argListener), next(0), decodersLeft(decoders), detectors(argDetectors), queue(capacity) {}
+
+    const vector<string>&      filenames;
+    DetectionListener*         listener;
+    int                        next;           // Next file to be decoded
+    int                        decodersLeft;   // Decode threads still running
+    int                        detectors;      // Number of detection threads to be stopped at the end
+
+    BoundedQueue<DecodedImage> queue;
+    Mutex                      mutex;
+    Mutex                      deliveryMutex;
+};
+
+class DecodeTask : public Task {
+
+public:
+
+    explicit DecodeTask(ScanJob* job) : m_job(job) {}
+
+    void run() {
+        for(;;) {
+            int index;
+            {
+                MutexLocker locker(m_job->mutex);
+                if(m_job->next >= (int)m_job->filenames.size()) {
+                    break;
+                }
+                index = m_job->next++;
+            }
+
+            DecodedImage item;
+            item.index = index;
+            item.image = decodeImage(m_job->filenames.at(index));
+
+            // blocks while the detection stage is behind
+            m_job->queue.push(item);
+        }
+
+        bool last;
+        {
+            MutexLocker locker(m_job->mutex);
+            last = (--m_job->decodersLeft == 0);
+        }
+
+        if(last) {
+            DecodedImage end;
+            end.index = -1;
+            end.image = 0;
+            for(int i = 0; i < m_job->detectors; ++i) {
+                m_job->queue.push(end);
+            }
+        }
+    }
+
+private:
+
+    ScanJob* m_job;
+};
+
+class ScanDetectTask : public Task {
+
+public:
+
+    ScanDetectTask(ScanJob* job, FaceDetect* detector) : m_job(job), m_detector(detector) {}
+
+    void run() {
+        for(;;) {
+            DecodedImage item = m_job->queue.pop();
+            if(item.index < 0) {
+                return;
+            }
+
+            vector<Face*>* faces = detectImage(item.image, m_detector);
+
+            MutexLocker locker(m_job->deliveryMutex);
+            deliverFaces(m_job->listener, item.index, faces);
+        }
+    }
+
+private:
+
+    ScanJob*    m_job;
+    FaceDetect* m_detector;
+};
+
+} // namespace
+
+class ScanPipeline::ScanPipelinePriv {
+
+public:
+
+    ScanPipelinePriv(int decoders, int detectors, int capacity)
+        : decodeThreads(decoders), detectThreads(detectors), queueCapacity(capacity), pool(decoders + detectors), detectors() {}
+
+    ~ScanPipelinePriv() {
+        for(unsigned i = 0; i < detectors.size(); ++i) {
+            delete detectors.at(i);
+        }
+    }
+
+    int                 decodeThreads;
+    int                 detectThreads;
+    int                 queueCapacity;
+
+    // Sized so that every task of both stages runs concurrently; the stages block on each other, so
+    // scan() runs no more tasks than the pool has threads.
+    ThreadPool          pool;
+    vector<FaceDetect*> detectors;   // One per detection thread
+};
+
+static int clampDecoders(int threads) {
+    return threads > 0 ? threads : 1;
+}
+
+static int clampDetectors(int threads) {
+    return threads > 0 ? threads : ThreadPool::idealThreadCount();
+}
+
+ScanPipeline::ScanPipeline(const FaceDetect& prototype, int decodeThreads, int detectThreads, int queueCapacity)
+    : d(new ScanPipelinePriv(clampDecoders(decodeThreads), clampDetectors(detectThreads), queueCapacity > 0 ? queueCapacity : 1)) {
+    for(int i = 0; i < d->detectThreads; ++i) {
+        d->detectors.push_back(new FaceDetect(prototype));
+    }
+}
+
+ScanPipeline::~ScanPipeline() {
+    delete d;
+}
+
+void ScanPipeline::scan(const vector<string>& filenames, DetectionListener* listener) {
+    if(filenames.empty()) {
+        return;
+    }
+
+    clock_t scan = clock();
+
+    // a task waiting for the other stage must not hold the only thread, and without any worker
+    // start() runs a task in the calling thread
+    const int threads = d->pool.threadCount();
+    if(threads < 2) {
+        LOG(libfaceDEBUG) << "ScanPipeline : " << threads << " thread available, decoding and detecting one file after the other.";
+        for(unsigned i = 0; i < filenames.size(); ++i) {
+            deliverFaces(listener, i, detectImage(decodeImage(filenames.at(i)), d->detectors.at(0)));
+        }
+    } else {
+        // fewer threads than requested started: the stages share them in the requested proportion
+        int decoders  = d->decodeThreads;
+        int detectors = d->detectThreads;
+        if(threads < decoders + detectors) {
+            decoders  = std::max(1, std::min(threads - 1, decoders * threads / (decoders + detectors)));
+            detectors = std::min(detectors, threads - decoders);
+            LOG(libfaceWARNING) << "ScanPipeline : Only " << threads << " threads available, scanning with " << decoders
+                                << " decode and " << detectors << " detection threads.";
+        }
+
+        ScanJob job(filenames, listener, d->queueCapacity, decoders, detectors);
+
+        vector<Task*> tasks;
+        for(int i = 0; i < detectors; ++i) {
+            tasks.push_back(new ScanDetectTask(&job, d->detectors.at(i)));
+        }
+        for(int i = 0; i < decoders; ++i) {
+            tasks.push_back(new DecodeTask(&job));
+        }
+
+        for(unsigned i = 0; i < tasks.size(); ++i) {
+            d->pool.start(tasks.at(i));
+        }
+        d->pool.waitForDone();
+
+        for(unsigned i = 0; i < tasks.size(); ++i) {
+            delete tasks.at(i);
+        }
+    }
+
+    scan = clock() - scan;
+    LOG(libfaceDEBUG) << "Scanning " << filenames.size() << " files took: " << (double)scan / ((double)CLOCKS_PER_SEC) << "sec. (CPU time)";
+}
+
+int ScanPipeline::scanDirectory(const string& dir, DetectionListener* listener) {
+    vector<string> filenames = listImages(dir);
+    scan(filenames, listener);
+    return filenames.size();
+}
+
+vector<string> ScanPipeline::listImages(const string& dir) {
+    vector<string> result;
+
+    DIR* directory = opendir(dir.c_str());
+    if(!directory) {
+        LOG(libfaceWARNING) << "ScanPipeline : Could not open directory " << dir;
+        return result;
+    }
+
+    string prefix = dir;
+    if(!prefix.empty() && prefix[prefix.size()-1] != '/') {
+        prefix += '/';
+    }
+
+    struct dirent* entry;
+    while((entry = readdir(directory)) != 0) {
+        if(entry->d_name[0] == '.') {
+            continue;
+        }
+
+        string path = prefix + entry->d_name;
+        struct stat fileInfo;
+        if(stat(path.c_str(), &fileInfo) == 0 && S_ISREG(fileInfo.st_mode)) {
+            result.push_back(path);
+        }
+    }
+    closedir(directory);
+
+    sort(result.begin(), result.end());
+    return result;
+}
+
+int ScanPipeline::decodeThreads() const {
+    return d->decodeThreads;
+}
+
+int ScanPipeline::detectThreads() const {
+    return d->detectThreads;
+}
+
+int ScanPipeline::queueCapacity() const {
+    return d->queueCapacity;
+}
+
+} // namespace libface
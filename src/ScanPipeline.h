@@ -0,0 +1,115 @@
+/** ===========================================================
+ * @file ScanPipeline.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Two stage decode/detect pipeline for scanning many image files.
+ * @section DESCRIPTION
+ *
+ * Loading and decoding images is done by one group of threads, face detection by another. The
+ * stages are connected by a BoundedQueue of decoded images, so disk and decoder time overlap with
+ * detection time, and at most a fixed number of decoded images exist at any moment.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _SCANPIPELINE_H_
+#define _SCANPIPELINE_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// C headers
+#include <string>
+#include <vector>
+
+namespace libface
+{
+
+// forward declaration
+class DetectionListener;
+class FaceDetect;
+
+class FACEAPI ScanPipeline
+{
+public:
+
+    /**
+     * Constructor. Every detection thread gets its own copy of the prototype detector.
+     *
+     * @param prototype Detector with the cascades and accuracy to be used.
+     * @param decodeThreads Number of threads loading and decoding files, at least 1.
+     * @param detectThreads Number of threads detecting faces. 0 or less uses one thread per core.
+     * @param queueCapacity Maximum number of decoded images waiting for detection.
+     */
+    ScanPipeline(const FaceDetect& prototype, int decodeThreads = 1, int detectThreads = 0, int queueCapacity = 8);
+
+    /**
+     * Destructor.
+     */
+    ~ScanPipeline();
+
+    /**
+     * Loads all files as grayscale images and detects faces in them. Blocks until every file has
+     * been passed to the listener. Files that cannot be loaded are reported with an empty face vector.
+     *
+     * At most queueCapacity() + decodeThreads() + detectThreads() decoded images are alive at once.
+     * If fewer threads could be started, both stages share those that did; with less than two the
+     * files are decoded and detected one after the other in the calling thread.
+     *
+     * @param filenames Paths of the images.
+     * @param listener Receives the index of each file and its faces, in order of completion.
+     */
+    void scan(const std::vector<std::string>& filenames, DetectionListener* listener);
+
+    /**
+     * Convenience wrapper for scan(listImages(dir), listener).
+     *
+     * @param dir Directory to be scanned, not recursively.
+     * @param listener Receives the index into listImages(dir) and the faces of each file.
+     *
+     * @return Number of files scanned.
+     */
+    int scanDirectory(const std::string& dir, DetectionListener* listener);
+
+    /**
+     * Lists the regular, non-hidden files of a directory in alphabetical order.
+     *
+     * @param dir The directory.
+     *
+     * @return Full paths of the files. Empty if the directory cannot be read.
+     */
+    static std::vector<std::string> listImages(const std::string& dir);
+
+    int decodeThreads() const;
+    int detectThreads() const;
+    int queueCapacity() const;
+
+private:
+
+    ScanPipeline(const ScanPipeline&);
+    ScanPipeline& operator = (const ScanPipeline&);
+
+    class ScanPipelinePriv;
+    ScanPipelinePriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _SCANPIPELINE_H_ */
@@ -0,0 +1,79 @@
+/** ===========================================================
+ * @file ScratchArena.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Reusable scratch memory of the calling thread.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "ScratchArena.h"
+
+// C headers
+#include <pthread.h>
+#include <vector>
+
+using namespace std;
+
+namespace libface {
+
+namespace {
+
+pthread_key_t  key;
+pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Frees the buffer of a thread when it exits.
+ */
+extern "C" void destroyBuffer(void* buffer) {
+    delete static_cast<vector<float>*>(buffer);
+}
+
+void createKey() {
+    pthread_key_create(&key, destroyBuffer);
+}
+
+} // namespace
+
+float* ScratchArena::floats(size_t count) {
+    pthread_once(&keyOnce, createKey);
+
+    vector<float>* buffer = static_cast<vector<float>*>(pthread_getspecific(key));
+    if(!buffer) {
+        buffer = new vector<float>;
+        pthread_setspecific(key, buffer);
+    }
+
+    if(buffer->size() < count) {
+        buffer->resize(count);
+    }
+    return buffer->empty() ? 0 : &(*buffer)[0];
+}
+
+void ScratchArena::release() {
+    pthread_once(&keyOnce, createKey);
+
+    delete static_cast<vector<float>*>(pthread_getspecific(key));
+    pthread_setspecific(key, 0);
+}
+
+} // namespace libface
@@ -0,0 +1,70 @@
+/** ===========================================================
+ * @file ScratchArena.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Reusable scratch memory of the calling thread.
+ * @section DESCRIPTION
+ *
+ * Helpers which run for every comparison of a query need a little temporary space, e.g. a row of
+ * an image converted to float. Every thread owns one buffer, which only grows, so after the first
+ * calls these helpers no longer allocate. The buffer is freed when the thread exits.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _SCRATCHARENA_H_
+#define _SCRATCHARENA_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// C headers
+#include <cstddef>
+
+namespace libface
+{
+
+class FACEAPI ScratchArena
+{
+public:
+
+    /**
+     * Returns scratch space of the calling thread. A later call from the same thread may return
+     * the same space, so a helper must take all it needs at once and not call other users.
+     *
+     * @param count Number of floats needed.
+     *
+     * @return At least count floats, uninitialised.
+     */
+    static float* floats(size_t count);
+
+    /**
+     * Frees the scratch space of the calling thread, e.g. after an unusually large request.
+     */
+    static void release();
+
+private:
+
+    ScratchArena();
+};
+
+} // namespace libface
+
+#endif /* _SCRATCHARENA_H_ */
@@ -0,0 +1,238 @@
+/** ===========================================================
+ * @file StreamingPCA.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   PCA of samples which are seen once, in chunks, with memory independent of their number.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "StreamingPCA.h"
+
+// LibFace headers
+#include "Log.h"
+
+// C headers
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+
+namespace libface {
+
+class StreamingPCA::StreamingPCAPriv {
+
+public:
+
+    StreamingPCAPriv(int rows) : l(std::max(1, rows)), used(0), n(0), dim(0) {}
+
+    /**
+     * Rotates the sketch onto its singular vectors and subtracts the l-th squared singular value,
+     * which leaves at most l - 1 rows.
+     */
+    void shrink();
+
+    int l;
+    Mat sketch;    // 2l x D, CV_32F, the first used rows are valid
+    int used;
+    Mat offset;    // mean of the first chunk, the sketch and sum are of the samples minus this
+    Mat sum;       // 1 x D, CV_64F
+    int n;
+    int dim;
+};
+
+void StreamingPCA::StreamingPCAPriv::shrink() {
+    Mat b;
+    sketch.rowRange(0, used).convertTo(b, CV_64F);
+
+    // B = U S V^T with U and S^2 from the small matrix B B^T
+    Mat g, values, vectors;
+    mulTransposed(b, g, false);
+    eigen(g, values, vectors);
+
+    const double delta = used >= l ? std::max(0.0, values.at<double>(l - 1)) : 0.0;
+
+    Mat coefficients(std::min(used, l - 1), used, CV_64F);
+    int keep = 0;
+    for(; keep < coefficients.rows; ++keep) {
+        double s2 = values.at<double>(keep);
+        if(s2 <= delta || s2 <= 0.0) {
+            break;
+        }
+        // sqrt(s^2 - delta) v^T = sqrt(s^2 - delta) / s u^T B
+        Mat row = coefficients.row(keep);
+        vectors.row(keep).convertTo(row, CV_64F, std::sqrt((s2 - delta) / s2));
+    }
+
+    if(keep > 0) {
+        Mat shrunk;
+        gemm(coefficients.rowRange(0, keep), b, 1.0, Mat(), 0.0, shrunk);
+        Mat target = sketch.rowRange(0, keep);
+        shrunk.convertTo(target, CV_32F);
+    }
+    used = keep;
+}
+
+StreamingPCA::StreamingPCA(int sketchRows) : d(new StreamingPCAPriv(sketchRows)) {}
+
+StreamingPCA::StreamingPCA(const StreamingPCA& that) : d(new StreamingPCAPriv(*that.d)) {
+    d->sketch = that.d->sketch.clone();
+    d->offset = that.d->offset.clone();
+    d->sum    = that.d->sum.clone();
+}
+
+StreamingPCA& StreamingPCA::operator = (const StreamingPCA& that) {
+    if(this != &that) {
+        *d        = *that.d;
+        d->sketch = that.d->sketch.clone();
+        d->offset = that.d->offset.clone();
+        d->sum    = that.d->sum.clone();
+    }
+    return *this;
+}
+
+StreamingPCA::~StreamingPCA() {
+    delete d;
+}
+
+void StreamingPCA::clear() {
+    d->sketch.release();
+    d->offset.release();
+    d->sum.release();
+    d->used = 0;
+    d->n    = 0;
+    d->dim  = 0;
+}
+
+void StreamingPCA::add(const Mat& samples) {
+    if(samples.empty()) {
+        return;
+    }
+
+    Mat y;
+    samples.convertTo(y, CV_64F);
+
+    if(d->n == 0) {
+        // centring by an early estimate of the mean avoids the cancellation of sum(x x^T) - n m m^T
+        d->dim = y.cols;
+        reduce(y, d->offset, 0, CV_REDUCE_AVG);
+        d->sum    = Mat::zeros(1, d->dim, CV_64F);
+        d->sketch.create(2 * d->l, d->dim, CV_32F);
+        d->used   = 0;
+    } else if(y.cols != d->dim) {
+        LOG(libfaceWARNING) << "StreamingPCA : Samples of dimension " << y.cols << " do not match " << d->dim << ", ignored.";
+        return;
+    }
+
+    for(int i = 0; i < y.rows; ++i) {
+        Mat row = y.row(i);
+        row    -= d->offset;
+        d->sum += row;
+    }
+    d->n += y.rows;
+
+    for(int first = 0; first < y.rows; ) {
+        if(d->used == d->sketch.rows) {
+            d->shrink();
+        }
+        int rows    = std::min(y.rows - first, d->sketch.rows - d->used);
+        Mat target  = d->sketch.rowRange(d->used, d->used + rows);
+        y.rowRange(first, first + rows).convertTo(target, CV_32F);
+        d->used    += rows;
+        first      += rows;
+    }
+}
+
+int StreamingPCA::count() const {
+    return d->n;
+}
+
+int StreamingPCA::dimension() const {
+    return d->dim;
+}
+
+PCA StreamingPCA::compute(int components) const {
+    PCA pca;
+    if(d->n == 0 || components <= 0) {
+        return pca;
+    }
+
+    const int n = d->n;
+    Mat mean    = d->sum / (double)n;
+
+    // the covariance B^T B / n - m m^T lies in the row space of A = [B; m]
+    Mat a(d->used + 1, d->dim, CV_64F);
+    if(d->used > 0) {
+        Mat top = a.rowRange(0, d->used);
+        d->sketch.rowRange(0, d->used).convertTo(top, CV_64F);
+    }
+    Mat last = a.row(d->used);
+    mean.copyTo(last);
+
+    // orthonormal basis V of that row space from A A^T = E^T L E, V = L^-1/2 E A
+    Mat g, values, vectors;
+    mulTransposed(a, g, false);
+    eigen(g, values, vectors);
+
+    const double largest = values.at<double>(0);
+    int r = 0;
+    while(r < values.rows && values.at<double>(r) > largest * 1e-10 && values.at<double>(r) > 0.0) {
+        ++r;
+    }
+    if(r == 0) {
+        LOG(libfaceWARNING) << "StreamingPCA : All samples are equal.";
+        return pca;
+    }
+
+    Mat coefficients = vectors.rowRange(0, r).clone();
+    for(int i = 0; i < r; ++i) {
+        Mat row = coefficients.row(i);
+        row    *= 1.0 / std::sqrt(values.at<double>(i));
+    }
+    Mat basis;
+    gemm(coefficients, a, 1.0, Mat(), 0.0, basis);
+
+    // the covariance restricted to the basis, V (B^T B / n - m m^T) V^T
+    Mat vb, vm, t;
+    if(d->used > 0) {
+        gemm(basis, a.rowRange(0, d->used), 1.0, Mat(), 0.0, vb, GEMM_2_T);
+    } else {
+        vb = Mat::zeros(r, 1, CV_64F);
+    }
+    gemm(basis, mean, 1.0, Mat(), 0.0, vm, GEMM_2_T);
+    mulTransposed(vb, t, false, noArray(), 1.0 / n);
+    t -= vm * vm.t();
+
+    Mat tValues, tVectors;
+    eigen(t, tValues, tVectors);
+
+    const int k = std::min(components, r);
+    gemm(tVectors.rowRange(0, k), basis, 1.0, Mat(), 0.0, pca.eigenvectors);
+    pca.eigenvalues = max(tValues.rowRange(0, k), 0.0);
+    pca.mean        = d->offset + mean;
+
+    LOG(libfaceDEBUG) << "StreamingPCA : " << k << " components of " << n << " samples from a sketch of " << d->used << " rows.";
+
+    return pca;
+}
+
+} // namespace libface
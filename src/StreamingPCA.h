@@ -0,0 +1,118 @@
+/** ===========================================================
+ * @file StreamingPCA.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   PCA of samples which are seen once, in chunks, with memory independent of their number.
+ * @section DESCRIPTION
+ *
+ * The samples are summarized by their sum and a Frequent Directions sketch (Liberty, 2013): a
+ * matrix B of at most 2l rows with B^T B close to X^T X. Whenever B fills up, it is rotated onto
+ * its singular vectors and the l-th squared singular value is subtracted from all of them, which
+ * empties half of the rows. The error of B^T B is at most ||X - X_k||_F^2 / (l - k) for every k < l,
+ * so the leading components are kept well if l is somewhat larger than their number.
+ *
+ * Memory is 2l x D floats and D doubles for D pixels, whatever the number of samples.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _STREAMINGPCA_H_
+#define _STREAMINGPCA_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// OpenCV headers
+#include "opencv2/core/core.hpp"
+
+namespace libface
+{
+
+class FACEAPI StreamingPCA
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param sketchRows Number l of directions kept by the sketch, at least the number of components wanted.
+     */
+    StreamingPCA(int sketchRows);
+
+    /**
+     * Copy constructor.
+     *
+     * @param that The sketch to copy.
+     */
+    StreamingPCA(const StreamingPCA& that);
+
+    /**
+     * Assignment operator.
+     *
+     * @param that The sketch to copy.
+     */
+    StreamingPCA& operator = (const StreamingPCA& that);
+
+    /**
+     * Destructor.
+     */
+    ~StreamingPCA();
+
+    /**
+     * Forgets all samples.
+     */
+    void clear();
+
+    /**
+     * Adds samples to the sketch.
+     *
+     * @param samples One sample per row, of any depth. All samples must have the same dimension.
+     */
+    void add(const cv::Mat& samples);
+
+    /**
+     * @return Number of samples added.
+     */
+    int count() const;
+
+    /**
+     * @return Dimension of the samples, 0 if none was added.
+     */
+    int dimension() const;
+
+    /**
+     * Computes the leading principal components of the samples added so far.
+     *
+     * @param components Number of components k, at most the sketch rows.
+     *
+     * @return The result in the layout of cv::PCA, CV_64F: mean as a row, eigenvectors as rows and
+     *         eigenvalues as a column. Empty if no sample was added.
+     */
+    cv::PCA compute(int components) const;
+
+private:
+
+    class StreamingPCAPriv;
+    StreamingPCAPriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _STREAMINGPCA_H_ */
@@ -0,0 +1,268 @@
+/** ===========================================================
+ * @file ThreadPool.cpp
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Small pthread based worker pool and locking primitives.
+ * @section DESCRIPTION
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+// own header
+#include "ThreadPool.h"
+
+// LibFace headers
+#include "Log.h"
+
+// C headers
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+namespace libface {
+
+Mutex::Mutex() {
+    pthread_mutex_init(&m_mutex, 0);
+}
+
+Mutex::~Mutex() {
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void Mutex::lock() {
+    pthread_mutex_lock(&m_mutex);
+}
+
+void Mutex::unlock() {
+    pthread_mutex_unlock(&m_mutex);
+}
+
+WaitCondition::WaitCondition() {
+    pthread_cond_init(&m_cond, 0);
+}
+
+WaitCondition::~WaitCondition() {
+    pthread_cond_destroy(&m_cond);
+}
+
+void WaitCondition::wait(Mutex& mutex) {
+    pthread_cond_wait(&m_cond, &mutex.m_mutex);
+}
+
+void WaitCondition::wakeOne() {
+    pthread_cond_signal(&m_cond);
+}
+
+void WaitCondition::wakeAll() {
+    pthread_cond_broadcast(&m_cond);
+}
+
+class ThreadPool::ThreadPoolPriv {
+
+public:
+
+    ThreadPoolPriv() : threads(), queue(), active(0), stopping(false) {}
+
+    /**
+     * Entry point of every worker thread.
+     *
+     * @param arg Pointer to the ThreadPoolPriv owning the thread.
+     */
+    static void* worker(void* arg);
+
+    vector<pthread_t> threads;
+    deque<Task*>      queue;
+    int               active;     // Tasks taken from the queue, but not yet finished
+    bool              stopping;
+
+    Mutex             mutex;
+    WaitCondition     taskAvailable;
+    WaitCondition     allDone;
+};
+
+void* ThreadPool::ThreadPoolPriv::worker(void* arg) {
+    ThreadPoolPriv* d = static_cast<ThreadPoolPriv*>(arg);
+
+    d->mutex.lock();
+    for(;;) {
+        while(d->queue.empty() && !d->stopping) {
+            d->taskAvailable.wait(d->mutex);
+        }
+        if(d->queue.empty()) {
+            // stopping and nothing left to do
+            break;
+        }
+
+        Task* task = d->queue.front();
+        d->queue.pop_front();
+        ++d->active;
+
+        d->mutex.unlock();
+        task->run();
+        d->mutex.lock();
+
+        --d->active;
+        if(d->active == 0 && d->queue.empty()) {
+            d->allDone.wakeAll();
+        }
+    }
+    d->mutex.unlock();
+
+    return 0;
+}
+
+ThreadPool::ThreadPool(int threads) : d(new ThreadPoolPriv) {
+    if(threads <= 0) {
+        threads = idealThreadCount();
+    }
+
+    for(int i = 0; i < threads; ++i) {
+        pthread_t thread;
+        if(pthread_create(&thread, 0, &ThreadPoolPriv::worker, d) != 0) {
+            LOG(libfaceERROR) << "ThreadPool : Unable to start worker thread " << i << ".";
+            break;
+        }
+        d->threads.push_back(thread);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    waitForDone();
+
+    d->mutex.lock();
+    d->stopping = true;
+    d->taskAvailable.wakeAll();
+    d->mutex.unlock();
+
+    for(unsigned i = 0; i < d->threads.size(); ++i) {
+        pthread_join(d->threads.at(i), 0);
+    }
+
+    delete d;
+}
+
+void ThreadPool::start(Task* task) {
+    if(d->threads.empty()) {
+        // No worker could be started, degrade to running in the calling thread.
+        task->run();
+        return;
+    }
+
+    MutexLocker locker(d->mutex);
+    d->queue.push_back(task);
+    d->taskAvailable.wakeOne();
+}
+
+void ThreadPool::waitForDone() {
+    MutexLocker locker(d->mutex);
+    while(d->active > 0 || !d->queue.empty()) {
+        d->allDone.wait(d->mutex);
+    }
+}
+
+namespace {
+
+/**
+ * Ranges of one parallelFor() call which have not finished yet.
+ */
+struct RangeBatch {
+
+    RangeBatch(int pending) : pending(pending) {}
+
+    int           pending;
+    Mutex         mutex;
+    WaitCondition done;
+};
+
+/**
+ * Adapts one range of a RangeTask to the Task interface.
+ */
+class RangeRunner : public Task {
+
+public:
+
+    RangeRunner(RangeTask& task, int begin, int end, RangeBatch& batch) : m_task(task), m_begin(begin), m_end(end), m_batch(batch) {}
+
+    void run() {
+        m_task.run(m_begin, m_end);
+
+        MutexLocker locker(m_batch.mutex);
+        if(--m_batch.pending == 0) {
+            m_batch.done.wakeAll();
+        }
+    }
+
+private:
+
+    RangeTask&  m_task;
+    int         m_begin;
+    int         m_end;
+    RangeBatch& m_batch;
+};
+
+} // namespace
+
+void ThreadPool::parallelFor(int count, RangeTask& task) {
+    if(count <= 0) {
+        return;
+    }
+
+    const int ranges = std::min(threadCount(), count);
+    if(ranges == 1) {
+        task.run(0, count);
+        return;
+    }
+
+    // only the ranges of this call are waited for, other callers may share the pool
+    RangeBatch batch(ranges);
+    vector<RangeRunner*> runners;
+    for(int i = 0; i < ranges; ++i) {
+        // sizes differ by at most one
+        int begin = (int)((long long)count * i / ranges);
+        int end   = (int)((long long)count * (i + 1) / ranges);
+        runners.push_back(new RangeRunner(task, begin, end, batch));
+        start(runners.back());
+    }
+
+    {
+        MutexLocker locker(batch.mutex);
+        while(batch.pending > 0) {
+            batch.done.wait(batch.mutex);
+        }
+    }
+
+    for(unsigned i = 0; i < runners.size(); ++i) {
+        delete runners.at(i);
+    }
+}
+
+int ThreadPool::threadCount() const {
+    return d->threads.empty() ? 1 : (int)d->threads.size();
+}
+
+int ThreadPool::idealThreadCount() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+} // namespace libface
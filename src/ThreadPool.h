@@ -0,0 +1,204 @@
+/** ===========================================================
+ * @file ThreadPool.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Small pthread based worker pool and locking primitives.
+ * @section DESCRIPTION
+ *
+ * The classes in libface are not thread-safe by themselves. This pool is used internally by the
+ * batch entry points, which give every worker its own copy of the objects it needs.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+// LibFace headers
+#include "LibFaceConfig.h"
+
+// C headers
+#include <pthread.h>
+
+namespace libface
+{
+
+/**
+ * Non-recursive mutex.
+ */
+class FACEAPI Mutex
+{
+public:
+
+    Mutex();
+    ~Mutex();
+
+    void lock();
+    void unlock();
+
+private:
+
+    Mutex(const Mutex&);
+    Mutex& operator = (const Mutex&);
+
+    pthread_mutex_t m_mutex;
+
+    friend class WaitCondition;
+};
+
+/**
+ * Locks a mutex for the lifetime of the locker object.
+ */
+class FACEAPI MutexLocker
+{
+public:
+
+    explicit MutexLocker(Mutex& mutex) : m_mutex(mutex) { m_mutex.lock(); }
+    ~MutexLocker() { m_mutex.unlock(); }
+
+private:
+
+    MutexLocker(const MutexLocker&);
+    MutexLocker& operator = (const MutexLocker&);
+
+    Mutex& m_mutex;
+};
+
+/**
+ * Condition variable to be used together with a locked Mutex.
+ */
+class FACEAPI WaitCondition
+{
+public:
+
+    WaitCondition();
+    ~WaitCondition();
+
+    /**
+     * Atomically releases the locked mutex and waits until woken up. The mutex is locked again on return.
+     *
+     * @param mutex A mutex locked by the calling thread.
+     */
+    void wait(Mutex& mutex);
+
+    void wakeOne();
+    void wakeAll();
+
+private:
+
+    WaitCondition(const WaitCondition&);
+    WaitCondition& operator = (const WaitCondition&);
+
+    pthread_cond_t m_cond;
+};
+
+/**
+ * A unit of work to be executed by the ThreadPool.
+ */
+class FACEAPI Task
+{
+public:
+
+    virtual ~Task() {};
+
+    /**
+     * Purely virtual method that does the work. Called from one of the worker threads.
+     */
+    virtual void run() = 0;
+};
+
+/**
+ * Work on a range of indices, see ThreadPool::parallelFor().
+ */
+class FACEAPI RangeTask
+{
+public:
+
+    virtual ~RangeTask() {};
+
+    /**
+     * Purely virtual method that processes the indices begin to end - 1. Called from several
+     * worker threads at once with disjoint ranges.
+     */
+    virtual void run(int begin, int end) = 0;
+};
+
+class FACEAPI ThreadPool
+{
+public:
+
+    /**
+     * Starts a pool of worker threads which live until the pool is destroyed.
+     *
+     * @param threads Number of worker threads. 0 or less means idealThreadCount().
+     */
+    ThreadPool(int threads = 0);
+
+    /**
+     * Waits for all queued tasks and joins the worker threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * Queues a task for execution. The pool does not take ownership, the task has to stay
+     * valid until waitForDone() returned.
+     *
+     * @param task The task to be run.
+     */
+    void start(Task* task);
+
+    /**
+     * Blocks until every task passed to start() has finished.
+     */
+    void waitForDone();
+
+    /**
+     * Splits the indices 0 to count - 1 into one contiguous range per worker thread, runs the task on
+     * them and blocks until all are done. Tasks which write only the results of their own indices
+     * give the same results as a serial loop, whatever the number of threads. Only these ranges are
+     * waited for, so several threads may call it on the same pool at once.
+     *
+     * @param count Number of indices.
+     * @param task The work to be done, shared by all threads.
+     */
+    void parallelFor(int count, RangeTask& task);
+
+    /**
+     * @return Number of worker threads in the pool.
+     */
+    int threadCount() const;
+
+    /**
+     * @return The number of processor cores available, at least 1.
+     */
+    static int idealThreadCount();
+
+private:
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator = (const ThreadPool&);
+
+    class ThreadPoolPriv;
+    ThreadPoolPriv* const d;
+};
+
+} // namespace libface
+
+#endif /* _THREADPOOL_H_ */
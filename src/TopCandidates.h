@@ -0,0 +1,131 @@
+/** ===========================================================
+ * @file TopCandidates.h
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Keeps the k best scoring labels seen during a scan.
+ * @section DESCRIPTION
+ *
+ * A bounded heap whose top is the worst of the kept candidates, so a score that cannot enter is
+ * rejected with one comparison and a scan over n faces costs O(n log k). Every label is kept at most
+ * once with its best score, as several training faces usually share a label.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#ifndef _TOPCANDIDATES_H_
+#define _TOPCANDIDATES_H_
+
+// C headers
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace libface
+{
+
+class TopCandidates
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * @param k Number of candidates to keep, at least 1.
+     * @param largerIsBetter True for similarities such as likelihoods, false for distances.
+     */
+    TopCandidates(int k, bool largerIsBetter = false) : m_k(k > 0 ? k : 1), m_order(largerIsBetter) {
+        m_heap.reserve(m_k);
+    }
+
+    /**
+     * @param score A score.
+     *
+     * @return True if a new label with this score would be kept.
+     */
+    bool accepts(float score) const {
+        return (int)m_heap.size() < m_k || m_order.better(score, m_heap.front().second);
+    }
+
+    /**
+     * Offers a label with a score. It is kept if it is among the k best labels seen so far.
+     *
+     * @param label The label (ID).
+     * @param score Its score.
+     */
+    void offer(int label, float score) {
+        if(!accepts(score)) {
+            return;
+        }
+
+        // k is small, a linear search is cheaper than a map
+        for(unsigned i = 0; i < m_heap.size(); ++i) {
+            if(m_heap[i].first == label) {
+                if(m_order.better(score, m_heap[i].second)) {
+                    m_heap[i].second = score;
+                    std::make_heap(m_heap.begin(), m_heap.end(), m_order);
+                }
+                return;
+            }
+        }
+
+        if((int)m_heap.size() == m_k) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), m_order);
+            m_heap.pop_back();
+        }
+        m_heap.push_back(std::make_pair(label, score));
+        std::push_heap(m_heap.begin(), m_heap.end(), m_order);
+    }
+
+    /**
+     * @return The kept labels with their scores, best first.
+     */
+    std::vector<std::pair<int, float> > sorted() const {
+        std::vector<std::pair<int, float> > result(m_heap);
+        std::sort_heap(result.begin(), result.end(), m_order);
+        return result;
+    }
+
+private:
+
+    /**
+     * Heap order, the worst candidate compares greatest and ends up on top.
+     */
+    struct Order {
+        Order(bool larger) : largerIsBetter(larger) {}
+
+        bool better(float a, float b) const {
+            return largerIsBetter ? a > b : a < b;
+        }
+
+        bool operator () (const std::pair<int, float>& a, const std::pair<int, float>& b) const {
+            return better(a.second, b.second);
+        }
+
+        bool largerIsBetter;
+    };
+
+    int                                 m_k;
+    Order                               m_order;
+    std::vector<std::pair<int, float> > m_heap;
+};
+
+} // namespace libface
+
+#endif /* _TOPCANDIDATES_H_ */
@@ -0,0 +1,157 @@
+/** ===========================================================
+ * @file
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Eigenfaces enrolment test.
+ * @section DESCRIPTION
+ *
+ * Trains Eigenfaces on random faces whose width is not a multiple of 4, so the rows of their
+ * IplImages are padded, and enrols more faces of the known IDs with drift tracking checking every
+ * face. Every enrolled face must be stored and recognised as its ID, on a trained and on an
+ * untrained engine.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "Eigenfaces.h"
+#include "Face.h"
+
+using namespace std;
+using namespace libface;
+
+static const int WIDTH      = 27;   // padded to 28 bytes per row
+static const int HEIGHT     = 25;
+static const int PEOPLE     = 4;
+static const int TRAINING   = 6;    // faces of every person used for training
+static const int ENROLLED   = 2;    // faces of every person enrolled afterwards
+static const int COMPONENTS = 10;
+
+/**
+ * A face of a person: the person's pattern with a little noise, in a new IplImage.
+ */
+static IplImage* randomFace(cv::RNG& rng, const cv::Mat& pattern) {
+    IplImage* image = cvCreateImage(cvSize(WIDTH, HEIGHT), IPL_DEPTH_8U, 1);
+    cv::Mat pixels  = cv::cvarrToMat(image);
+    cv::Mat noise(HEIGHT, WIDTH, CV_32FC1);
+    rng.fill(noise, cv::RNG::NORMAL, 0.0, 8.0);
+    cv::Mat face = pattern + noise;
+    face.convertTo(pixels, CV_8U);
+    return image;
+}
+
+static void release(vector<Face*>& faces) {
+    for(unsigned i = 0; i < faces.size(); ++i) {
+        delete faces[i];
+    }
+    faces.clear();
+}
+
+/**
+ * Enrols the faces through update() and checks that each is stored and recognised as its ID.
+ */
+static bool enrol(Eigenfaces& engine, vector<Face*>& faces, bool trained) {
+    const int before = engine.count();
+    try {
+        if(engine.update(&faces) != 0) {
+            printf("FAILED: update returned an error\n");
+            return false;
+        }
+    } catch(const cv::Exception& e) {
+        printf("FAILED: update threw %s\n", e.what());
+        return false;
+    }
+
+    if(engine.count() != before + (int)faces.size()) {
+        printf("FAILED: %d faces stored, %d expected\n", engine.count() - before, (int)faces.size());
+        return false;
+    }
+
+    if(trained) {
+        for(unsigned i = 0; i < faces.size(); ++i) {
+            int id = engine.testingID(faces[i]->getFace());
+            if(id != faces[i]->getId()) {
+                printf("FAILED: enrolled face %d of ID %d recognised as %d\n", i, faces[i]->getId(), id);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    cv::RNG rng(1234);
+
+    vector<cv::Mat> patterns;
+    for(int p = 0; p < PEOPLE; ++p) {
+        cv::Mat pattern(HEIGHT, WIDTH, CV_32FC1);
+        rng.fill(pattern, cv::RNG::UNIFORM, 32.0, 224.0);
+        patterns.push_back(pattern);
+    }
+
+    vector<Face*> training;
+    for(int p = 0; p < PEOPLE; ++p) {
+        for(int n = 0; n < TRAINING; ++n) {
+            training.push_back(new Face(0, 0, WIDTH, HEIGHT, p + 1, randomFace(rng, patterns[p])));
+        }
+    }
+
+    vector<Face*> enrolled;
+    for(int p = 0; p < PEOPLE; ++p) {
+        for(int n = 0; n < ENROLLED; ++n) {
+            enrolled.push_back(new Face(0, 0, WIDTH, HEIGHT, p + 1, randomFace(rng, patterns[p])));
+        }
+    }
+
+    // every enrolled face is checked for drift right away
+    TrainingOptions options;
+    options.chunkSize = 1;
+
+    // the directory holds no model, so both engines start untrained
+    Eigenfaces trained(".");
+    trained.setTrainingOptions(options);
+    trained.training(&training, COMPONENTS);
+    bool ok = enrol(trained, enrolled, true);
+
+    // faces of a known ID are stored on an untrained engine as well
+    Eigenfaces untrained(".");
+    untrained.setTrainingOptions(options);
+    vector<Face*> first(enrolled.begin(), enrolled.begin() + 1);
+    vector<Face*> again(enrolled.begin() + 1, enrolled.begin() + 2);
+    ok = enrol(untrained, first, false) && ok;
+    ok = enrol(untrained, again, false) && ok;
+
+    release(training);
+    release(enrolled);
+
+    if(!ok) {
+        return EXIT_FAILURE;
+    }
+
+    printf("PASSED\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/** ===========================================================
+ * @file
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Fixed point detection test.
+ * @section DESCRIPTION
+ *
+ * Detects faces in every image of a directory with floating point and with fixed point cascade
+ * evaluation, and checks that both find the same faces within the tolerance documented in
+ * FixedPointCascade.h.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Face.h"
+#include "FaceDetect.h"
+
+using namespace std;
+using namespace libface;
+
+/**
+ * Counts the faces of a that have a counterpart in b whose corners are less than 20% of the
+ * face width away.
+ */
+static int matched(const vector<Face*>* a, const vector<Face*>* b) {
+    int count = 0;
+    for(unsigned i = 0; i < a->size(); ++i) {
+        const Face* f = a->at(i);
+        int tolerance = f->getWidth() / 5;
+        for(unsigned j = 0; j < b->size(); ++j) {
+            const Face* g = b->at(j);
+            if(abs(f->getX1() - g->getX1()) <= tolerance && abs(f->getY1() - g->getY1()) <= tolerance
+               && abs(f->getX2() - g->getX2()) <= tolerance && abs(f->getY2() - g->getY2()) <= tolerance) {
+                ++count;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+static void release(vector<Face*>* faces) {
+    for(unsigned i = 0; i < faces->size(); ++i) {
+        delete faces->at(i);
+    }
+    delete faces;
+}
+
+int main(int argc, char* argv[]) {
+
+    if(argc < 2) {
+        printf("Wrong Number of parameters. Usage:\n\ttestFixedPoint <input_dir> [cascade_dir]");
+        return EXIT_FAILURE;
+    }
+
+    string path       = argv[1];
+    string cascadeDir = argc > 2 ? string(argv[2]) : string(OPENCVDIR) + "/haarcascades";
+
+    FaceDetect floating(cascadeDir);
+    FaceDetect fixed(cascadeDir);
+    fixed.setArithmetic(FixedPoint);
+
+    DIR* dir = opendir(path.c_str());
+    if(dir == NULL) {
+        perror("");
+        return EXIT_FAILURE;
+    }
+
+    int floatFaces = 0, fixedFaces = 0, floatMatched = 0, fixedMatched = 0;
+    struct dirent* ent;
+    while((ent = readdir(dir)) != NULL) {
+        if(ent->d_name[0] == '.') {
+            continue;
+        }
+
+        string filename = path + "/" + ent->d_name;
+        vector<Face*>* a = floating.detectFaces(filename);
+        vector<Face*>* b = fixed.detectFaces(filename);
+
+        printf("%s: %d floating point, %d fixed point\n", ent->d_name, (int)a->size(), (int)b->size());
+
+        floatFaces   += a->size();
+        fixedFaces   += b->size();
+        floatMatched += matched(a, b);
+        fixedMatched += matched(b, a);
+
+        release(a);
+        release(b);
+    }
+    closedir(dir);
+
+    printf("RESULTS:\n");
+    printf("\tFLOATING POINT FACES:\t%d (%d matched)\n", floatFaces, floatMatched);
+    printf("\tFIXED POINT FACES:\t%d (%d matched)\n", fixedFaces, fixedMatched);
+
+    // at least 90% of the faces of either path must be found by the other one
+    if(floatMatched * 10 < floatFaces * 9 || fixedMatched * 10 < fixedFaces * 9) {
+        printf("FIXED POINT TEST FAILED\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("END OF FIXED POINT TEST\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+/** ===========================================================
+ * @file
+ *
+ * This file is a part of libface project
+ * <a href="http://libface.sourceforge.net">http://libface.sourceforge.net</a>
+ *
+ * @date    2026-10-18
+ * @brief   Matching structures of ProjectionGallery test.
+ * @section DESCRIPTION
+ *
+ * Fills galleries with random clustered projections and compares nearest() against a brute force
+ * scan: exactly for the plain scan, the sharded scan and the class centroids probing every class,
+ * and by recall for the 8 bit codes and the HNSW graph. Removed projections must not be found.
+ *
+ * @author Copyright (C) 2026 by libface developers
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU General
+ * Public License as published by the Free Software Foundation;
+ * either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * ============================================================ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "ProjectionGallery.h"
+
+using namespace std;
+using namespace libface;
+
+static const int FACES     = 4000;   // three shards of 1636 rows of 40 floats for the sharded scan
+static const int PEOPLE    = 100;
+static const int DIMENSION = 40;
+static const int QUERIES   = 200;
+
+/**
+ * Squared distance of the closest live row, by brute force in double.
+ */
+static double closest(const cv::Mat& faces, const vector<bool>& removed, const cv::Mat& query) {
+    double best = -1.0;
+    for(int i = 0; i < faces.rows; ++i) {
+        if(removed[i]) {
+            continue;
+        }
+        double dist = cv::norm(faces.row(i), query, cv::NORM_L2);
+        dist       *= dist;
+        if(best < 0.0 || dist < best) {
+            best = dist;
+        }
+    }
+    return best;
+}
+
+/**
+ * Counts the queries whose nearest() projection is at the brute force distance. Ties count, so
+ * the index found does not need to be the one of the brute force scan.
+ */
+static int agreeing(const ProjectionGallery& gallery, const cv::Mat& faces, const vector<bool>& removed, const cv::Mat& queries) {
+    int count = 0;
+    for(int q = 0; q < queries.rows; ++q) {
+        float dist = 0.0f;
+        int index  = gallery.nearest(queries.row(q), &dist);
+        if(index < 0 || removed[index]) {
+            continue;
+        }
+        double truth = closest(faces, removed, queries.row(q));
+        if(fabs(dist - truth) <= 1e-3 * (1.0 + truth)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+static bool check(const char* name, int count, int required) {
+    printf("%-24s %d / %d queries agree with the brute force scan\n", name, count, QUERIES);
+    if(count < required) {
+        printf("FAILED: %s needs %d\n", name, required);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    cv::RNG rng(4321);
+
+    // every person has a centre, faces of the person scatter around it
+    cv::Mat centres(PEOPLE, DIMENSION, CV_32FC1);
+    rng.fill(centres, cv::RNG::NORMAL, 0.0, 10.0);
+
+    cv::Mat faces(FACES, DIMENSION, CV_32FC1);
+    rng.fill(faces, cv::RNG::NORMAL, 0.0, 1.0);
+    for(int i = 0; i < FACES; ++i) {
+        cv::Mat row = faces.row(i);
+        row        += centres.row(i % PEOPLE);
+    }
+
+    cv::Mat queries(QUERIES, DIMENSION, CV_32FC1);
+    rng.fill(queries, cv::RNG::NORMAL, 0.0, 1.0);
+    for(int q = 0; q < QUERIES; ++q) {
+        cv::Mat row = queries.row(q);
+        row        += centres.row(rng.uniform(0, PEOPLE));
+    }
+
+    ProjectionGallery exact;
+    for(int i = 0; i < FACES; ++i) {
+        if(exact.add(faces.row(i), i % PEOPLE) != i) {
+            printf("FAILED: add returned a wrong index for face %d\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+    vector<bool> removed(FACES, false);
+
+    bool ok = check("exact scan", agreeing(exact, faces, removed, queries), QUERIES);
+
+    // several shards of the 256 KB the scan keeps in cache
+    ProjectionGallery sharded(exact);
+    MatchingOptions options;
+    options.threads      = 4;
+    options.parallelRows = 1;
+    sharded.setMatchingOptions(options);
+    if(sharded.shards() < 2) {
+        printf("FAILED: the sharded scan runs %d shard\n", sharded.shards());
+        ok = false;
+    }
+    ok = check("sharded scan", agreeing(sharded, faces, removed, queries), QUERIES) && ok;
+
+    // probing every class compares every projection, so the result is exact
+    ProjectionGallery centroids(exact);
+    options              = MatchingOptions();
+    options.centroids    = true;
+    options.probes       = PEOPLE;
+    centroids.setMatchingOptions(options);
+    ok = check("centroids, all probes", agreeing(centroids, faces, removed, queries), QUERIES) && ok;
+
+    // the clusters are far apart, the default probes find the right class
+    ProjectionGallery probed(exact);
+    options              = MatchingOptions();
+    options.centroids    = true;
+    probed.setMatchingOptions(options);
+    ok = check("centroids", agreeing(probed, faces, removed, queries), QUERIES * 95 / 100) && ok;
+
+    ProjectionGallery codes(exact);
+    options              = MatchingOptions();
+    options.quantized    = true;
+    codes.setMatchingOptions(options);
+    ok = check("8 bit codes", agreeing(codes, faces, removed, queries), QUERIES * 95 / 100) && ok;
+
+    ProjectionGallery graph(exact);
+    options              = MatchingOptions();
+    options.approximate  = true;
+    graph.setMatchingOptions(options);
+    ok = check("HNSW graph", agreeing(graph, faces, removed, queries), QUERIES * 90 / 100) && ok;
+
+    // removed projections are skipped by every structure, the ones built before the removal included
+    for(int i = 0; i < FACES; i += 3) {
+        removed[i] = true;
+        exact.remove(i);
+        centroids.remove(i);
+        codes.remove(i);
+        graph.remove(i);
+    }
+    ok = check("exact scan, removed", agreeing(exact, faces, removed, queries), QUERIES) && ok;
+    ok = check("centroids, removed", agreeing(centroids, faces, removed, queries), QUERIES) && ok;
+    ok = check("8 bit codes, removed", agreeing(codes, faces, removed, queries), QUERIES * 95 / 100) && ok;
+    ok = check("HNSW graph, removed", agreeing(graph, faces, removed, queries), QUERIES * 90 / 100) && ok;
+
+    if(!ok) {
+        return EXIT_FAILURE;
+    }
+
+    printf("PASSED\n");
+    return EXIT_SUCCESS;
+}